@@ -34,20 +34,45 @@
 // If super buckets contain less than SUPER_BUCKET_FILL_DEGREE * BUCKET_MAX
 // objects, they morph into regular buckets
 #define SUPER_BUCKET_FILL_DEGREE 0.5
+// Number of data objects that range scans look ahead when prefetching the
+// next buckets; used if no fixed prefetch distance is set
+#define PREFETCH_LOOKAHEAD 512
+// Maximum number of buckets that range scans prefetch ahead
+#define PREFETCH_MAX_DISTANCE 16
+// Number of point queries that SearchObjectBatch advances through the inner
+// nodes in lock-step
+#define POINT_QUERY_GROUP_SIZE 16
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 // https://github.com/vit-vit/CTPL/
 #include "ctpl_stl.h"
 
+#include "BBTreeBatchExecutor.h"
 #include "BBTreeBucket.h"
+#include "BBTreeBufferPool.h"
+#include "BBTreeHybridIndex.h"
+#include "BBTreeQueryContext.h"
+#include "BBTreeRangeCursor.h"
+#include "BBTreeResultCache.h"
+#include "BBTreeSelection.h"
+#include "BBTreeSemanticCache.h"
+#include "BBTreeTidSet.h"
+#include "BBTreeTrace.h"
+#include "BBTreeTuner.h"
+#include "BBTreeWorkloadPolicy.h"
 
 /**
  * Used to order data objects dimensionwise.
@@ -64,6 +89,28 @@ struct DimensionCompare {
   unsigned int dim;
 };
 
+/**
+ * Location of a data object in the tid directory: its bucket and its position
+ * within the bucket (see BBTreeBucket).
+ */
+struct BBTreeTidLocation {
+  uint32_t bucket;
+  uint32_t position;
+};
+
+/**
+ * Estimated cost of a range query (see BBTree::EstimateRange()).
+ */
+struct BBTreeEstimate {
+  // estimated number of matching data objects
+  double rows;
+  // number of buckets whose zone maps intersect with the range query
+  size_t buckets;
+};
+
+// Bucket of identifiers that are not stored in the tid directory
+#define BBTREE_INVALID_BUCKET UINT32_MAX
+
 /**
  * The BBTREE index structure.
  * Example usage with a 10-dimensional feature space:
@@ -73,6 +120,96 @@ struct DimensionCompare {
  *
  * Example usage with a 10-dimensional feature space and 5 threads:
  *   BBTree* bbtree = new BBTree(10, 5);
+ *
+ * Bucket capacity and fanout default to BUCKET_MAX, BUCKET_AVG and
+ * DELIMITERS_PER_SPLIT. They can be chosen by calibration instead:
+ *   bbtree->SetAutoTuning(true);
+ *   bbtree->BulkInsert(feature_vectors, tids);
+ *
+ * Point queries and deletes scan the relevant buckets. For point-query- or
+ * delete-heavy workloads, buckets can maintain a hash index instead:
+ *   bbtree->SetHashIndex(true);
+ * Buckets can also maintain Bloom filters that reject most point queries for
+ * data objects that do not exist without scanning the bucket:
+ *   bbtree->SetBloomFilter(true);
+ *
+ * Data objects can be deleted, fetched and updated by identifier if the tid
+ * directory is enabled:
+ *   bbtree->SetTidDirectory(true);
+ *   bbtree->UpdateObject(tid, new_feature_vector);
+ *
+ * All data objects of a range query can be deleted or updated in one pass:
+ *   bbtree->DeleteRange(lower_boundary, upper_boundary);
+ *   bbtree->UpdateRange(lower_boundary, upper_boundary,
+ *                       [](uint32_t tid, std::vector<float> &object) { ... });
+ *
+ * Counts and aggregates of range queries are computed during the scan; buckets
+ * that are covered by the query are answered from their zone maps and sums:
+ *   size_t num_matches = bbtree->CountRange(lower_boundary, upper_boundary);
+ *
+ * The result size of a range query can be estimated without scanning any
+ * bucket, e.g., to choose between the BB-Tree and a full scan:
+ *   BBTreeEstimate estimate = bbtree->EstimateRange(lower_boundary, upper_boundary);
+ *
+ * A BBTreeHybridIndex runs unselective range queries as scans of a column
+ * store instead, based on such estimates and the observed runtimes.
+ *
+ * Sets of range queries (boxes) are executed in a single traversal that scans
+ * every relevant bucket once:
+ *   bbtree->SearchRanges(lower_boundaries, upper_boundaries);
+ * Concurrent clients can share these scans via a BBTreeBatchExecutor.
+ *
+ * Results of repeated range queries can be served from a BBTreeResultCache,
+ * which drops them once one of the buckets they were read from changes.
+ * A BBTreeSemanticCache also answers range queries that are contained in or
+ * overlap recently answered ones.
+ *
+ * Joins return pairs of (box index, tid) or (tid, tid of the other tree):
+ *   bbtree->JoinBoxesMT(lower_boundaries, upper_boundaries);
+ *   bbtree->JoinDistanceMT(*other, epsilon, BBTREE_METRIC_L2);
+ *
+ * Data sets that do not fit into memory can be indexed out of core: the
+ * buckets are stored as pages in a file and only num_frames of them are kept
+ * resident by a buffer pool with the given replacement policy:
+ *   bbtree->SetBufferPool("/tmp/bbtree.pages", num_frames, BBTREE_REPLACEMENT_ARC);
+ * A BBTreeWorkloadPolicy evicts buckets by the monitored range queries instead:
+ *   bbtree->SetBufferPool("/tmp/bbtree.pages", num_frames,
+ *                         new BBTreeWorkloadPolicy(*bbtree));
+ * In this mode, only InsertObject(), BulkInsert(), SearchRange() and
+ * SearchRangeMT() returning tids (executed single-threaded),
+ * RebuildDelimiters(), getCount() and printStatistics() are supported. All
+ * other operations read buckets without pinning them and throw
+ * std::logic_error while a buffer pool is set: point queries, deletes,
+ * updates, counts, aggregates, estimates, selections, streamed and batched
+ * range queries, nearest neighbor queries, joins and enabling the tid
+ * directory.
+ * DisableBufferPool() loads all buckets back into memory.
+ *
+ * The bucket accesses of queries, inserts and deletes can be written to a
+ * trace, which tools/simulator replays against cache replacement policies:
+ *   bbtree->SetTrace("/tmp/bbtree.trace");
+ *
+ * Range queries can stop early if only some matches are needed:
+ *   bbtree->SearchRangeLimit(lower_boundary, upper_boundary, 1000);
+ *   bbtree->SearchRangeTopK(lower_boundary, upper_boundary, dimension, k);
+ *
+ * Nearest neighbor queries visit the buckets in order of the minimum distance
+ * of their zone maps to the query object:
+ *   bbtree->SearchKNN(search_object, k, BBTREE_METRIC_L2);
+ *
+ * Range queries can reuse the result and scratch buffers of a context to
+ * avoid allocations (see BBTreeQueryContext):
+ *   bbtree->SearchRangeMT(lower_boundary, upper_boundary, context);
+ *
+ * Range queries with many matches can return selection bitmaps instead of
+ * tids (see BBTreeSelection):
+ *   BBTreeSelection selection;
+ *   bbtree->SearchRangeMT(lower_boundary, upper_boundary, selection);
+ *
+ * Results of range queries can also be consumed bucket by bucket while the
+ * query is running, either with a callback or with a BBTreeRangeCursor:
+ *   bbtree->SearchRangeStreamMT(lower_boundary, upper_boundary,
+ *     [](const BBTreeResultBatch &batch) { ...; return true; }, false);
  */
 class BBTree {
  public:
@@ -82,42 +219,155 @@ class BBTree {
    BBTree(size_t dimensions, size_t num_threads) :
      dimensions(dimensions), num_threads(num_threads) {
      this->count = 0;
+     this->bucket_max = BUCKET_MAX;
+     this->bucket_avg = BUCKET_AVG;
+     this->delimiters_per_split = DELIMITERS_PER_SPLIT;
+     this->auto_tuning = false;
+     this->tuned_scan_cost = 0.0;
+     this->prefetch_distance = 0;
+     this->hash_index = false;
+     this->bloom_filter = false;
+     this->use_tid_directory = false;
+     this->monitor_position = 0;
+     this->num_monitored_queries = 0;
+     this->next_pending_bucket = 0;
+     this->pending_queries = 0;
      this->num_buckets = 1;
      this->num_super_buckets = 0;
      this->num_empty_buckets = 0;
      this->height = 1;
      this->thread_pool = new ctpl::thread_pool(num_threads);
-     this->buckets = new BBTreeBucket*[this->num_buckets];
+     this->buffer_pool = NULL;
+     this->trace = NULL;
+     this->buckets = new BBTreeBucket[this->num_buckets];
+     this->zone_maps = new float[2 * this->dimensions * this->num_buckets];
+     this->bucket_sums = new double[this->dimensions * this->num_buckets];
+     this->bucket_versions = new uint64_t[this->num_buckets]();
+     this->structure_version = 0;
      for (size_t i = 0; i < num_buckets; ++i)
-       this->buckets[i] = new BBTreeRegularBucket();
+       this->resetZoneMap(i);
      this->delimiter_dimensions = new int[1];
      this->delimiter_dimensions[0] = 0;
-     this->delimiter_values = new float[DELIMITERS_PER_SPLIT];
-     for (size_t i = 0; i < DELIMITERS_PER_SPLIT; ++i)
+     this->delimiter_values = new float[this->delimiters_per_split];
+     for (size_t i = 0; i < this->delimiters_per_split; ++i)
        delimiter_values[i] = std::numeric_limits<float>::max();
    };
 
    ~BBTree() {
      delete this->thread_pool;
+     delete this->buffer_pool;
+     delete this->trace;
      delete [] this->buckets;
+     delete [] this->zone_maps;
+     delete [] this->bucket_sums;
+     delete [] this->bucket_versions;
      delete [] this->delimiter_dimensions;
      delete [] this->delimiter_values;
    };
 
    void printStatistics() const;
    size_t getCount() const;
+   void SetAutoTuning(const bool enabled);
+   BBTreeTuning getTuning() const;
+   void SetPrefetchDistance(const size_t distance);
+   void SetHashIndex(const bool enabled);
+   void SetBloomFilter(const bool enabled);
+   void SetTidDirectory(const bool enabled);
+   void SetBufferPool(const std::string &path,
+                      const size_t num_frames,
+                      const BBTreeReplacement replacement = BBTREE_REPLACEMENT_LRU);
+   void SetBufferPool(const std::string &path,
+                      const size_t num_frames,
+                      BBTreeReplacementPolicy* policy);
+   void DisableBufferPool();
+   const BBTreeBufferPool* GetBufferPool() const;
+   void SetTrace(const std::string &path);
+   void DisableTrace();
    void InsertObject(const std::vector<float> feature_vector,
                      const uint32_t object_id);
    void BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
                    const std::vector<uint32_t> &object_ids);
    bool DeleteObject(const std::vector<float> &feature_vector);
+   bool DeleteByTid(const uint32_t object_id);
+   std::vector<float> GetObjectByTid(const uint32_t object_id) const;
+   bool UpdateObject(const uint32_t object_id,
+                     const std::vector<float> &feature_vector);
+   size_t DeleteRange(const std::vector<float> &lower_boundary,
+                      const std::vector<float> &upper_boundary);
+   size_t UpdateRange(const std::vector<float> &lower_boundary,
+                      const std::vector<float> &upper_boundary,
+                      const std::function<void(uint32_t, std::vector<float>&)> &update);
    uint32_t SearchObject(const std::vector<float> &search_object) const;
+   void SearchObjectBatch(const std::vector<std::vector<float> > &search_objects,
+                          std::vector<uint32_t> &results) const;
+   BBTreeEstimate EstimateRange(const std::vector<float> &lower_boundary,
+                                const std::vector<float> &upper_boundary) const;
+   size_t CountRange(const std::vector<float> &lower_boundary,
+                     const std::vector<float> &upper_boundary);
+   BBTreeAggregate AggregateRange(const std::vector<float> &lower_boundary,
+                                  const std::vector<float> &upper_boundary,
+                                  const size_t dimension);
    std::vector<uint32_t> SearchRange(const std::vector<float> &lower_boundary,
                                      const std::vector<float> &upper_boundary);
+   std::vector<std::vector<uint32_t> > SearchRanges(const std::vector<std::vector<float> > &lower_boundaries,
+                                                    const std::vector<std::vector<float> > &upper_boundaries);
+   std::vector<std::vector<uint32_t> > SearchRangesMT(const std::vector<std::vector<float> > &lower_boundaries,
+                                                      const std::vector<std::vector<float> > &upper_boundaries);
+   std::vector<uint32_t> SearchRangesUnion(const std::vector<std::vector<float> > &lower_boundaries,
+                                           const std::vector<std::vector<float> > &upper_boundaries);
+   std::vector<std::pair<uint32_t, uint32_t> > JoinBoxes(const std::vector<std::vector<float> > &lower_boundaries,
+                                                         const std::vector<std::vector<float> > &upper_boundaries);
+   std::vector<std::pair<uint32_t, uint32_t> > JoinBoxesMT(const std::vector<std::vector<float> > &lower_boundaries,
+                                                           const std::vector<std::vector<float> > &upper_boundaries);
+   std::vector<std::pair<uint32_t, uint32_t> > JoinDistance(BBTree &other,
+                                                            const float epsilon,
+                                                            const BBTreeMetric metric);
+   std::vector<std::pair<uint32_t, uint32_t> > JoinDistanceMT(BBTree &other,
+                                                              const float epsilon,
+                                                              const BBTreeMetric metric);
+   std::vector<uint32_t> SearchRangeLimit(const std::vector<float> &lower_boundary,
+                                          const std::vector<float> &upper_boundary,
+                                          const size_t limit);
+   std::vector<uint32_t> SearchRangeTopK(const std::vector<float> &lower_boundary,
+                                         const std::vector<float> &upper_boundary,
+                                         const size_t dimension,
+                                         const size_t k);
    std::vector<uint32_t> SearchRangeMT(const std::vector<float> &lower_boundary,
                                        const std::vector<float> &upper_boundary);
+   void SearchRange(const std::vector<float> &lower_boundary,
+                    const std::vector<float> &upper_boundary,
+                    BBTreeQueryContext &context);
+   void SearchRangeMT(const std::vector<float> &lower_boundary,
+                      const std::vector<float> &upper_boundary,
+                      BBTreeQueryContext &context);
+   void SearchRange(const std::vector<float> &lower_boundary,
+                    const std::vector<float> &upper_boundary,
+                    BBTreeSelection &selection);
+   void SearchRangeMT(const std::vector<float> &lower_boundary,
+                      const std::vector<float> &upper_boundary,
+                      BBTreeSelection &selection);
+   void SearchRangeStream(const std::vector<float> &lower_boundary,
+                          const std::vector<float> &upper_boundary,
+                          const std::function<bool(const BBTreeResultBatch&)> &callback,
+                          const bool with_objects);
+   void SearchRangeStreamMT(const std::vector<float> &lower_boundary,
+                            const std::vector<float> &upper_boundary,
+                            const std::function<bool(const BBTreeResultBatch&)> &callback,
+                            const bool with_objects);
    std::vector<uint32_t> SearchFixedRadiusNN(const std::vector<float> &search_object,
                                              const float &r);
+   std::vector<uint32_t> SearchFixedRadiusNN(const std::vector<float> &search_object,
+                                             const float &r,
+                                             const BBTreeMetric metric);
+   std::vector<uint32_t> SearchFixedRadiusNNMT(const std::vector<float> &search_object,
+                                               const float &r,
+                                               const BBTreeMetric metric);
+   std::vector<uint32_t> SearchKNN(const std::vector<float> &search_object,
+                                   const size_t k,
+                                   const BBTreeMetric metric);
+   std::vector<uint32_t> SearchKNNMT(const std::vector<float> &search_object,
+                                     const size_t k,
+                                     const BBTreeMetric metric);
    static void ScanBuckets(int thread_id,
                            BBTree *bbtree,
                            std::vector<uint32_t> &results,
@@ -126,9 +376,62 @@ class BBTree {
                            const std::vector<size_t> &buckets,
                            const size_t start,
                            const size_t end);
+   static void ScanBucketsRanges(int thread_id,
+                                 BBTree *bbtree,
+                                 std::vector<std::vector<uint32_t> > *results,
+                                 std::vector<uint32_t> *union_results,
+                                 const std::vector<std::vector<float> > &lower_boundaries,
+                                 const std::vector<std::vector<float> > &upper_boundaries,
+                                 const std::vector<size_t> &match_buckets,
+                                 const std::vector<std::vector<uint32_t> > &bucket_boxes,
+                                 const size_t start,
+                                 const size_t end);
+   static void JoinBuckets(int thread_id,
+                           BBTree *bbtree,
+                           const BBTree *other,
+                           std::vector<std::pair<uint32_t, uint32_t> > &results,
+                           const BBTreeMetric metric,
+                           const float max_distance,
+                           const std::vector<std::pair<size_t, size_t> > &bucket_pairs,
+                           const size_t start,
+                           const size_t end);
+   static void ScanBucketsRadius(int thread_id,
+                                 BBTree *bbtree,
+                                 std::vector<uint32_t> &results,
+                                 const std::vector<float> &search_object,
+                                 const BBTreeMetric metric,
+                                 const float max_distance,
+                                 const std::vector<size_t> &match_buckets,
+                                 const size_t start,
+                                 const size_t end);
+   static void ScanBucketsKNN(int thread_id,
+                              BBTree *bbtree,
+                              const std::vector<float> &search_object,
+                              const size_t k,
+                              const BBTreeMetric metric,
+                              std::vector<std::pair<float, size_t> > &order,
+                              std::mutex &order_mutex,
+                              std::atomic<float> &bound,
+                              std::vector<std::pair<float, uint32_t> > &heap);
+   static size_t SelectBuckets(int thread_id,
+                               BBTreeSelection &selection,
+                               const std::vector<float> &lower_boundary,
+                               const std::vector<float> &upper_boundary,
+                               const size_t start,
+                               const size_t end);
    void RebuildDelimiters();
 
  private:
+  // plans and scans the buckets of streamed range queries
+  friend class BBTreeRangeCursor;
+  // scans a column-store copy of the data objects on the thread pool
+  friend class BBTreeHybridIndex;
+  // validates cached query results against the bucket versions
+  friend class BBTreeResultCache;
+  friend class BBTreeSemanticCache;
+  // scores buckets by the workload monitor and the running range query
+  friend class BBTreeWorkloadPolicy;
+
   size_t count;
   size_t dimensions;
   size_t num_buckets;
@@ -136,24 +439,175 @@ class BBTree {
   size_t num_empty_buckets;
   size_t num_threads;
   size_t height;
+  // maximum bucket size (b_max)
+  size_t bucket_max;
+  // average bucket size targeted by RebuildDelimiters
+  size_t bucket_avg;
+  // k-1
+  size_t delimiters_per_split;
+  // if set, bucket sizes and fanout are calibrated when (re)building
+  bool auto_tuning;
+  // calibration measurements of the last auto-tuning run
+  BBTreeTuner tuner;
+  double tuned_scan_cost;
+  // number of buckets that range scans prefetch ahead; 0 = adaptive
+  size_t prefetch_distance;
+  // if set, every (sub-)bucket maintains a hash index for exact-match lookups
+  bool hash_index;
+  // if set, every (sub-)bucket maintains a Bloom filter of its data objects
+  bool bloom_filter;
+  // if set, tid_directory maps identifiers to the locations of data objects
+  bool use_tid_directory;
+  std::vector<BBTreeTidLocation> tid_directory;
   int* delimiter_dimensions;
   float* delimiter_values;
-  BBTreeBucket** buckets;
+  // contiguous bucket directory
+  BBTreeBucket* buckets;
+  // per-bucket minimum (first m values) and maximum (next m values) of
+  // every dimension; empty buckets have an empty (inverted) zone map; kept
+  // apart from the bucket headers, so the zone maps of consecutive buckets
+  // are packed densely for filtering
+  float* zone_maps;
+  // per-bucket sums of every dimension (m values per bucket); maintained
+  // together with the zone maps to answer aggregates of contained buckets
+  double* bucket_sums;
+  // per-bucket modification counters; bumped whenever the data objects of a
+  // bucket change
+  uint64_t* bucket_versions;
+  // bumped whenever RebuildDelimiters() replaces the bucket directory
+  uint64_t structure_version;
   // thread pool used by the parallel BBTREE to enable reuse of POSIX threads
   ctpl::thread_pool *thread_pool;
-  // historical lower boundaries of range queries
+  // if set, buckets are stored in a file and only some of them are resident
+  BBTreeBufferPool *buffer_pool;
+  // buckets that the running range query reads in buffer pool mode, the
+  // position of the first one that it has not pinned yet, and the number of
+  // range queries that have announced their buckets so far
+  std::vector<size_t> pending_buckets;
+  size_t next_pending_bucket;
+  size_t pending_queries;
+  // if set, bucket accesses are recorded
+  BBTreeTrace *trace;
+  // historical lower boundaries of range queries (ring buffer)
   std::vector<std::vector<float> > last_lower_bounds;
-  // historical upper boundaries of range queries
+  // historical upper boundaries of range queries (ring buffer)
   std::vector<std::vector<float> > last_upper_bounds;
+  // slot of the oldest query once the ring buffer is full
+  size_t monitor_position;
+  // number of range queries recorded by the monitor so far
+  size_t num_monitored_queries;
 
   size_t getNumberOfNodesInTreeOfHeight(const size_t height) const;
   inline std::vector<size_t> getBucketOfFeatureVector(const std::vector<float> &feature_vector) const;
+  inline size_t searchInnerNode(const float value, const size_t offset) const;
+  inline size_t getNumberOfEqualDelimiters(const size_t offset,
+                                           const size_t rel_pos) const;
   inline size_t getBucketOfFeatureVectorForInsert(const std::vector<float> &feature_vector,
                                                   const bool debug) const;
   inline std::vector<size_t> getBucketsForRange(const std::vector<float> &lower_boundary,
                                                 const std::vector<float> &upper_boundary) const;
+  inline void getBucketsForRange(const std::vector<float> &lower_boundary,
+                                 const std::vector<float> &upper_boundary,
+                                 std::vector<size_t> &buckets,
+                                 std::vector<size_t> &next_nodes) const;
+  void getBucketsForRanges(const std::vector<std::vector<float> > &lower_boundaries,
+                           const std::vector<std::vector<float> > &upper_boundaries,
+                           std::vector<size_t> &buckets,
+                           std::vector<std::vector<uint32_t> > &bucket_boxes) const;
+  void searchRanges(const std::vector<std::vector<float> > &lower_boundaries,
+                    const std::vector<std::vector<float> > &upper_boundaries,
+                    std::vector<std::vector<uint32_t> > *results,
+                    std::vector<uint32_t> *union_results);
+  void getJoinBucketPairs(const BBTree &other,
+                          const float epsilon,
+                          const BBTreeMetric metric,
+                          std::vector<std::pair<size_t, size_t> > &bucket_pairs) const;
+  static std::vector<std::pair<uint32_t, uint32_t> > flattenJoinResults(const std::vector<std::vector<uint32_t> > &results);
+  static inline double getOverlapFraction(const float minimum,
+                                          const float maximum,
+                                          const float lower,
+                                          const float upper);
+  inline void monitorQuery(const std::vector<float> &lower_boundary,
+                           const std::vector<float> &upper_boundary);
+  void monitorKNNQuery(const std::vector<float> &search_object,
+                       const float distance,
+                       const BBTreeMetric metric);
   inline void transformRegularIntoSuperBucket(const size_t bucket_id);
   inline void transformSuperIntoRegularBucket(const size_t bucket_id);
+  inline size_t locateBucketForInsert(const std::vector<float> &feature_vector,
+                                      const size_t height,
+                                      const int* delimiter_dimensions,
+                                      const float* delimiter_values) const;
+  inline void configureBucket(BBTreeBucket &bucket) const;
+  void planSelection(const std::vector<float> &lower_boundary,
+                     const std::vector<float> &upper_boundary,
+                     BBTreeSelection &selection) const;
+  void planCachedResult(const std::vector<float> &lower_boundary,
+                        const std::vector<float> &upper_boundary,
+                        std::vector<size_t> &match_buckets) const;
+  void planCursor(const std::vector<float> &lower_boundary,
+                  const std::vector<float> &upper_boundary,
+                  std::vector<size_t> &match_buckets);
+  void scanBucketBatch(const size_t bucket_id,
+                       const std::vector<float> &lower_boundary,
+                       const std::vector<float> &upper_boundary,
+                       const bool with_objects,
+                       BBTreeResultBatch &batch,
+                       std::vector<uint64_t> &bitmap) const;
+  void deleteObjectAt(const size_t bucket_id,
+                      const uint32_t position,
+                      const std::vector<float> &feature_vector);
+  void finishRangeModification(const std::vector<size_t> &modified_buckets);
+  inline bool hasTidLocation(const uint32_t object_id) const;
+  inline void setTidLocation(const uint32_t object_id,
+                             const size_t bucket_id,
+                             const uint32_t position);
+  void refreshTidDirectory(const size_t bucket_id);
+  inline bool isOnZoneMapBoundary(const size_t bucket_id,
+                                  const std::vector<float> &feature_vector) const;
+  void resetZoneMap(const size_t bucket_id);
+  inline void updateZoneMap(const size_t bucket_id,
+                            const std::vector<float> &feature_vector);
+  void rebuildZoneMap(const size_t bucket_id);
+  inline void updateBucketSums(const size_t bucket_id,
+                               const std::vector<float> &feature_vector,
+                               const double sign);
+  inline bool zoneMapIntersects(const size_t bucket_id,
+                                const std::vector<float> &lower_boundary,
+                                const std::vector<float> &upper_boundary) const;
+  inline bool zoneMapContained(const size_t bucket_id,
+                               const std::vector<float> &lower_boundary,
+                               const std::vector<float> &upper_boundary) const;
+  inline float getZoneMapDistance(const size_t bucket_id,
+                                  const std::vector<float> &search_object,
+                                  const BBTreeMetric metric) const;
+  void orderBucketsByDistance(const std::vector<float> &search_object,
+                              const BBTreeMetric metric,
+                              std::vector<std::pair<float, size_t> > &order) const;
+  inline void pinBucket(const size_t bucket_id);
+  inline void unpinBucket(const size_t bucket_id, const bool dirty);
+  void loadBucket(const size_t bucket_id);
+  void evictBuckets();
+  void checkNoBufferPool(const char* operation) const;
+  inline size_t getNumberOfObjects(const size_t bucket_id) const;
+  void appendNewBuckets(BBTreeBucket* new_buckets,
+                        std::vector<size_t> &filled_buckets);
+  void sampleSpilledBuckets(const std::vector<size_t> &sample_buckets,
+                            std::vector<std::vector<float> > &samples);
+  inline void traceBucket(const BBTreeTraceOperation operation,
+                          const size_t bucket_id) const;
+  inline size_t getPrefetchDistance() const;
+  inline void prefetchBuckets(const std::vector<size_t> &match_buckets,
+                              const size_t position,
+                              const size_t end,
+                              const size_t distance,
+                              const std::vector<float> &lower_boundary,
+                              const std::vector<float> &upper_boundary) const;
+  inline void scanBucket(std::vector<uint32_t> &results,
+                         const size_t bucket_id,
+                         const std::vector<float> &lower_boundary,
+                         const std::vector<float> &upper_boundary) const;
+  void applyTuning(const std::vector<std::vector<float> > &samples);
 };
 
 #endif
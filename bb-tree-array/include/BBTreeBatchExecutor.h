@@ -0,0 +1,95 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREEBATCHEXECUTOR
+#define BBTREEBATCHEXECUTOR
+#pragma once
+
+// Time in microseconds that the executor waits for further queries after
+// the first query of a batch arrived
+#define BATCH_WINDOW_MICROSECONDS 200
+// Maximum number of range queries executed in one batch
+#define BATCH_MAX_QUERIES 64
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class BBTree;
+
+/**
+ * Executor that batches the range queries of concurrent clients and runs
+ * every batch as shared scan: the tree is traversed once for all queries of
+ * a batch and every relevant bucket is scanned once while evaluating all
+ * pending queries (see BBTree::SearchRanges()). The matches are routed to
+ * the results of the individual queries.
+ *
+ * A batch is closed BATCH_WINDOW_MICROSECONDS after its first query arrived
+ * or as soon as it holds BATCH_MAX_QUERIES queries. Batches are executed by
+ * a dispatcher thread, so the executor also serializes all accesses to the
+ * BB-Tree. The BB-Tree must not be modified while queries are pending.
+ *
+ * Example usage:
+ *   BBTreeBatchExecutor executor(*bbtree);
+ *   // on any client thread
+ *   std::vector<uint32_t> results = executor.SearchRange(lower_boundary,
+ *                                                        upper_boundary);
+ */
+class BBTreeBatchExecutor {
+  public:
+    BBTreeBatchExecutor(BBTree &bbtree,
+                        const size_t window_microseconds = BATCH_WINDOW_MICROSECONDS,
+                        const size_t max_queries = BATCH_MAX_QUERIES,
+                        const bool multithreaded = true);
+    ~BBTreeBatchExecutor();
+
+    std::future<std::vector<uint32_t> > SubmitRange(const std::vector<float> &lower_boundary,
+                                                    const std::vector<float> &upper_boundary);
+    std::vector<uint32_t> SearchRange(const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary);
+    size_t GetNumberOfBatches() const;
+    size_t GetNumberOfQueries() const;
+  private:
+    /**
+     * Range query waiting for the next batch.
+     */
+    struct PendingQuery {
+      std::vector<float> lower_boundary;
+      std::vector<float> upper_boundary;
+      std::promise<std::vector<uint32_t> > results;
+    };
+
+    BBTree &bbtree;
+    const size_t window_microseconds;
+    const size_t max_queries;
+    const bool multithreaded;
+
+    mutable std::mutex mutex;
+    std::condition_variable not_empty;
+    std::vector<PendingQuery> pending;
+    bool stopped;
+    // statistics of executed batches
+    size_t num_batches;
+    size_t num_queries;
+    std::thread dispatcher;
+
+    BBTreeBatchExecutor(const BBTreeBatchExecutor &other) = delete;
+    BBTreeBatchExecutor& operator=(const BBTreeBatchExecutor &other) = delete;
+
+    void dispatch();
+    void executeBatch(std::vector<PendingQuery> &batch);
+};
+
+#endif
@@ -6,133 +6,1118 @@
 *  Used solely for scholastic work in course CSCE 614 for
 *  the course research project. Adaptations and additions
 *  are marked with //ADDED ... //ADDED.
-*  
+*
 *********************************************************/
 
 #ifndef BBTREEBUCKET
 #define BBTREEBUCKET
 #pragma once
 
+// Initial capacity (in data objects) of a bucket's column storage
+#define BUCKET_INITIAL_CAPACITY 16
+// Number of hash index slots per data object of capacity (load factor <= 0.5)
+#define BUCKET_HASH_SLOTS_PER_OBJECT 2
+// Number of Bloom filter bits per data object of capacity
+#define BUCKET_BLOOM_BITS_PER_OBJECT 8
+// Size of a Bloom filter block in bits (half a cache line)
+#define BUCKET_BLOOM_BLOCK_BITS 256
+// Size of a cache line in bytes; the column storage and the Bloom filter
+// within it are aligned to cache lines
+#define BUCKET_CACHE_LINE_SIZE 64
+// Number of low bits of a position that hold the row; the upper bits hold
+// the bucket of a superbucket
+#define BUCKET_POSITION_ROW_BITS 24
+
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <stdlib.h>
+#include <utility>
 #include <vector>
 
+#ifdef __AVX__
+// AVX Intrinsics (SIMD)
+#include <immintrin.h>
+#endif
+
 // https://github.com/vit-vit/CTPL/
 #include "ctpl_stl.h"
 
 /**
- * Base class for buckets.
+ * Type tag of a bucket.
  */
-class BBTreeBucket {
-  public:
-    virtual ~BBTreeBucket() {}
-    virtual bool IsRegularBucket() const = 0;
-    virtual bool IsFull(const size_t max_size) const = 0;
-    virtual std::vector<float> GetObject(const size_t index) const = 0;
-    virtual std::vector<float> GetRandomObject() const = 0;
-    virtual uint32_t GetTid(const size_t index) const = 0;
-    virtual size_t GetNumberOfObjects() const = 0;
-    virtual void InsertObject(const std::vector<float> feature_vector,
-                              const uint32_t object_id) = 0;
-    virtual void BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
-                            const std::vector<uint32_t> &object_ids,
-                            const size_t start,
-                            const size_t end) = 0;
-    virtual bool DeleteObject(const std::vector<float> feature_vector) = 0;
-    virtual int32_t SearchObject(const std::vector<float> &search_object) const = 0;
-    virtual void SearchRange(std::vector<uint32_t> &results,
-                             const std::vector<float> &lower_boundary,
-                             const std::vector<float> &upper_boundary) = 0;
-  private:
-    std::vector<std::vector<float> > data_objects;
-    std::vector<uint32_t> tids;
+enum BBTreeBucketType : uint8_t {
+  BBTREE_REGULAR_BUCKET = 0,
+  BBTREE_SUPER_BUCKET = 1
+};
+
+class BBTreeSuperBucket;
+
+/**
+ * Distance metric of nearest neighbor queries.
+ */
+enum BBTreeMetric : uint8_t {
+  // Euclidean distance
+  BBTREE_METRIC_L2 = 0,
+  // Manhattan distance
+  BBTREE_METRIC_L1 = 1,
+  // Chebyshev distance
+  BBTREE_METRIC_LINF = 2
 };
 
 /**
- * Regular bucket that can hold up to BUCKET_MAX data objects.
+ * Aggregates of one dimension over the matching data objects of a range
+ * query. min and max are only meaningful if count > 0.
  */
-class BBTreeRegularBucket : public BBTreeBucket {
+struct BBTreeAggregate {
+  size_t count;
+  float min;
+  float max;
+  double sum;
+};
+
+/**
+ * Tagged bucket that is stored inline in the contiguous bucket directory
+ * of BBTree.
+ *
+ * A regular bucket stores its data objects column-wise: the values of
+ * dimension d are located at data[d * capacity ... d * capacity + count),
+ * followed by the tids of all data objects. A superbucket refers to
+ * a BBTreeSuperBucket consisting of z regular buckets.
+ *
+ * If the hash index is enabled, the tids are followed by an open-addressing
+ * hash table of the full data objects, which maps them to their positions.
+ * Point queries and deletes then probe a constant number of slots instead of
+ * scanning the bucket. If the Bloom filter is enabled, it follows next and
+ * lets point queries reject most data objects that are not stored without
+ * touching the columns.
+ *
+ * A data object is addressed by its position: the index of its bucket within
+ * a superbucket (0 for regular buckets) in the upper bits and its row in the
+ * lower BUCKET_POSITION_ROW_BITS bits. Deletes move the last data object of
+ * the (sub-)bucket to the position of the deleted one.
+ *
+ * The header (counts, type tag, flags and pointers) is 32 bytes large, so
+ * two bucket headers share a cache line. The zone maps are not part of the
+ * header: their size depends on the number of dimensions, and BBTree keeps
+ * them in a separate contiguous array, such that filtering buckets by their
+ * zone maps touches neither headers nor data. All operations dispatch on the
+ * type tag instead of calling virtual methods, which allows the scan kernels
+ * below to be inlined into the scan loops of BBTree.
+ */
+class BBTreeBucket {
   public:
-    BBTreeRegularBucket() : count(0) {}
-    bool IsRegularBucket() const;
+    BBTreeBucket() : count(0), capacity(0), dimensions(0),
+                     type(BBTREE_REGULAR_BUCKET), hashed(false),
+                     filtered(false), data(NULL),
+                     super_bucket(NULL) {}
+    ~BBTreeBucket();
+
+    inline bool IsRegularBucket() const;
+    inline size_t GetNumberOfObjects() const;
     bool IsFull(const size_t max_size) const;
     std::vector<float> GetObject(const size_t index) const;
     std::vector<float> GetRandomObject() const;
     uint32_t GetTid(const size_t index) const;
-    size_t GetNumberOfObjects() const;
-    std::vector<std::vector<float> >& GetDataObjects();
-    std::vector<uint32_t>& GetTids();
-    void InsertObject(const std::vector<float> feature_vector,
-                      const uint32_t object_id);
+    inline float GetValue(const size_t index, const size_t dimension) const;
+    inline size_t GetNumberOfRegularBuckets() const;
+    inline const BBTreeBucket& GetRegularBucket(const size_t bucket_id) const;
+    BBTreeSuperBucket* GetSuperBucket() const;
+    uint32_t InsertObject(const std::vector<float> &feature_vector,
+                          const uint32_t object_id);
     void BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
                     const std::vector<uint32_t> &object_ids,
                     const size_t start,
                     const size_t end);
-    bool DeleteObject(const std::vector<float> feature_vector);
-    int32_t SearchObject(const std::vector<float> &search_object) const;
-    void SearchRange(std::vector<uint32_t> &results,
-                     const std::vector<float> &lower_boundary,
-                     const std::vector<float> &upper_boundary);
+    bool DeleteObject(const std::vector<float> &feature_vector);
+    int64_t FindPosition(const std::vector<float> &feature_vector) const;
+    bool IsValidPosition(const uint32_t position) const;
+    uint32_t GetTidAt(const uint32_t position) const;
+    std::vector<float> GetObjectAt(const uint32_t position) const;
+    bool CanUpdateAt(const uint32_t position,
+                     const std::vector<float> &feature_vector) const;
+    void UpdateObjectAt(const uint32_t position,
+                        const std::vector<float> &feature_vector);
+    void DeleteObjectAt(const uint32_t position);
+    size_t DeleteRange(const std::vector<float> &lower_boundary,
+                       const std::vector<float> &upper_boundary,
+                       std::vector<uint32_t> *deleted_tids);
+    inline int32_t SearchObject(const std::vector<float> &search_object) const;
+    inline void SearchRange(std::vector<uint32_t> &results,
+                            const std::vector<float> &lower_boundary,
+                            const std::vector<float> &upper_boundary) const;
+    inline size_t SelectRange(uint64_t *bitmap,
+                              const std::vector<float> &lower_boundary,
+                              const std::vector<float> &upper_boundary) const;
+    void MaterializeRows(const uint64_t *bitmap,
+                         std::vector<uint32_t> &tids,
+                         std::vector<float> *objects) const;
+    inline size_t CountRange(const std::vector<float> &lower_boundary,
+                             const std::vector<float> &upper_boundary) const;
+    inline void AggregateRange(const std::vector<float> &lower_boundary,
+                               const std::vector<float> &upper_boundary,
+                               const size_t dimension,
+                               BBTreeAggregate &aggregate) const;
+    inline void SearchRangeTopK(const std::vector<float> &lower_boundary,
+                                const std::vector<float> &upper_boundary,
+                                const size_t dimension,
+                                const size_t k,
+                                std::vector<std::pair<float, uint32_t> > &heap) const;
+    inline void SearchKNN(const std::vector<float> &search_object,
+                          const BBTreeMetric metric,
+                          const size_t k,
+                          std::vector<std::pair<float, uint32_t> > &heap) const;
+    inline void SearchRadius(const std::vector<float> &search_object,
+                             const BBTreeMetric metric,
+                             const float max_distance,
+                             std::vector<uint32_t> &results) const;
+    inline void JoinDistance(const BBTreeBucket &other,
+                             const BBTreeMetric metric,
+                             const float max_distance,
+                             std::vector<std::pair<uint32_t, uint32_t> > &results) const;
+    static inline float AccumulateDistance(const float distance,
+                                           const float difference,
+                                           const BBTreeMetric metric);
+    inline void SearchRanges(const std::vector<std::vector<float> > &lower_boundaries,
+                             const std::vector<std::vector<float> > &upper_boundaries,
+                             const std::vector<uint32_t> &boxes,
+                             std::vector<std::vector<uint32_t> > *results,
+                             std::vector<uint32_t> *union_results) const;
+    inline void GetAllTids(std::vector<uint32_t> &results) const;
+    inline void Prefetch(const bool tids_only) const;
+    void SetHashIndex(const bool enabled);
+    void SetBloomFilter(const bool enabled);
+    void MakeSuperBucket(BBTreeSuperBucket *super_bucket);
+    void Swap(BBTreeBucket &other);
+    void Clear();
   private:
-    size_t count;
-    std::vector<std::vector<float> > data_objects;
-    std::vector<uint32_t> tids;
+    // decodes selection bitmaps using the tids of the buckets
+    friend class BBTreeSelection;
+
+    // number of data objects (of all z buckets for superbuckets)
+    uint32_t count;
+    // number of data objects that fit into data
+    uint32_t capacity;
+    uint32_t dimensions;
+    BBTreeBucketType type;
+    // if set, the data objects of (all z buckets of) the bucket are hashed
+    bool hashed;
+    // if set, (all z buckets of) the bucket maintain a Bloom filter
+    bool filtered;
+    // columns of the data objects followed by their tids, the hash index and
+    // the Bloom filter
+    float* data;
+    BBTreeSuperBucket* super_bucket;
+
+    BBTreeBucket(const BBTreeBucket &other) = delete;
+    BBTreeBucket& operator=(const BBTreeBucket &other) = delete;
+
+    inline const float* getColumn(const size_t dimension) const;
+    inline const uint32_t* getTids() const;
+    static inline size_t getPositionRow(const uint32_t position);
+    inline int32_t findObject(const std::vector<float> &search_object) const;
+    inline uint32_t* getHashSlots() const;
+    inline size_t getHashMask() const;
+    static inline uint32_t hashValue(const uint32_t hash, const float value);
+    static inline uint32_t finalizeHash(const uint32_t hash);
+    inline uint32_t hashStoredObject(const size_t index) const;
+    inline uint32_t hashObject(const std::vector<float> &search_object) const;
+    inline bool isStoredObject(const size_t index,
+                               const std::vector<float> &search_object) const;
+    inline size_t findHashSlot(const std::vector<float> &search_object,
+                               const uint32_t hash) const;
+    size_t findHashSlotOfPosition(const size_t index) const;
+    void insertIntoHashIndex(const size_t index, const uint32_t hash);
+    void eraseFromHashIndex(const size_t slot);
+    inline size_t getBloomFilterOffset() const;
+    inline uint64_t* getBloomFilter() const;
+    inline size_t getNumberOfBloomWords() const;
+    inline uint64_t* getBloomBlock(const uint32_t hash) const;
+    inline bool bloomFilterContains(const uint32_t hash) const;
+    inline void addToBloomFilter(const uint32_t hash);
+    void rebuildHashStructures();
+    inline uint64_t getBlockMask(const size_t block,
+                                 const std::vector<float> &lower_boundary,
+                                 const std::vector<float> &upper_boundary) const;
+    inline void scanRange(std::vector<uint32_t> &results,
+                          const std::vector<float> &lower_boundary,
+                          const std::vector<float> &upper_boundary) const;
+    inline void getBlockDistances(const size_t block,
+                                  const size_t block_size,
+                                  const std::vector<float> &search_object,
+                                  const BBTreeMetric metric,
+                                  float *distances) const;
+    inline void scanKNN(const std::vector<float> &search_object,
+                        const BBTreeMetric metric,
+                        const size_t k,
+                        std::vector<std::pair<float, uint32_t> > &heap) const;
+    void reallocate(const size_t new_capacity);
 };
 
+static_assert(sizeof(BBTreeBucket) == 32,
+              "two bucket headers are expected to share a cache line");
+
 /**
  * Superbucket that consists of z regular buckets.
+ * The bucket of a data object is chosen according to its value in the
+ * delimiter dimension and the z-1 delimiter values.
  */
-class BBTreeSuperBucket : public BBTreeBucket {
+class BBTreeSuperBucket {
   public:
     BBTreeSuperBucket(size_t num_buckets,
-                     size_t delimiter_dimension,
-                     float* delimiter_values) :
+                      size_t delimiter_dimension,
+                      const std::vector<float> &delimiter_values) :
       num_buckets(num_buckets),
       delimiter_dimension(delimiter_dimension),
       delimiter_values(delimiter_values),
-      data_objects(new std::vector<std::vector<float> >[num_buckets]),
-      tids(new std::vector<uint32_t>[num_buckets]) {
-      this->count = 0;
-    }
+      buckets(new BBTreeBucket[num_buckets]) {}
 
     ~BBTreeSuperBucket() {
-      delete [] this->delimiter_values;
-      delete [] this->data_objects;
-      delete [] this->tids;
+      delete [] this->buckets;
     }
 
-    bool IsRegularBucket() const;
-    bool IsFull(const size_t max_size) const;
-    std::vector<float> GetObject(const size_t index) const;
-    std::vector<float> GetRandomObject() const;
-    uint32_t GetTid(const size_t index) const;
-    size_t GetNumberOfObjects() const;
-    std::vector<std::vector<float> >& GetDataObjects(const size_t bucket_id);
-    std::vector<uint32_t>& GetTids(const size_t bucket_id);
-    void InsertObject(const std::vector<float> feature_vector,
-                      const uint32_t object_id);
-    void BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
-                    const std::vector<uint32_t> &object_ids,
-                    const size_t start,
-                    const size_t end);
-    bool DeleteObject(const std::vector<float> feature_vector);
-    int32_t SearchObject(const std::vector<float> &search_object) const;
-    void SearchRange(std::vector<uint32_t> &results,
-                     const std::vector<float> &lower_boundary,
-                     const std::vector<float> &upper_boundary);
-  private:
-    size_t count;
     size_t num_buckets;
     size_t delimiter_dimension;
-    float* delimiter_values;
-    std::vector<std::vector<float> > *data_objects;
-    std::vector<uint32_t> *tids;
+    std::vector<float> delimiter_values;
+    BBTreeBucket* buckets;
 
-    size_t getBucket(const std::vector<float> &feature_vector) const;
+    inline size_t getBucket(const std::vector<float> &feature_vector) const;
+    inline bool isRelevantForRange(const size_t bucket_id,
+                                   const std::vector<float> &lower_boundary,
+                                   const std::vector<float> &upper_boundary) const;
+    inline float getIntervalDistance(const size_t bucket_id,
+                                     const float value) const;
 };
 
+/**
+ * BBTreeBucket::IsRegularBucket() returns true for regular buckets and false
+ * for superbuckets.
+ */
+inline bool BBTreeBucket::IsRegularBucket() const {
+  return (this->type == BBTREE_REGULAR_BUCKET);
+}
+
+/**
+ * BBTreeBucket::GetNumberOfObjects() returns the number of data objects
+ * currently stored in the bucket.
+ */
+inline size_t BBTreeBucket::GetNumberOfObjects() const {
+  return this->count;
+}
+
+/**
+ * BBTreeBucket::GetValue(i, d) returns the value of the i'th data object of
+ * a regular bucket in dimension d.
+ */
+inline float BBTreeBucket::GetValue(const size_t index,
+                                    const size_t dimension) const {
+  return this->data[dimension * this->capacity + index];
+}
+
+/**
+ * BBTreeBucket::GetNumberOfRegularBuckets() returns z for superbuckets and
+ * 1 for regular buckets.
+ */
+inline size_t BBTreeBucket::GetNumberOfRegularBuckets() const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      return this->super_bucket->num_buckets;
+    default:
+      return 1;
+  }
+}
+
+/**
+ * BBTreeBucket::GetRegularBucket(i) returns the i'th of the z buckets of
+ * a superbucket, or the bucket itself if it is a regular bucket.
+ */
+inline const BBTreeBucket& BBTreeBucket::GetRegularBucket(const size_t bucket_id) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      return this->super_bucket->buckets[bucket_id];
+    default:
+      return *this;
+  }
+}
+
+/**
+ * BBTreeBucket::getColumn(d) returns the values of all data objects of
+ * a regular bucket in dimension d.
+ */
+inline const float* BBTreeBucket::getColumn(const size_t dimension) const {
+  return this->data + dimension * this->capacity;
+}
+
+/**
+ * BBTreeBucket::getTids() returns the tids of all data objects of a regular
+ * bucket.
+ */
+inline const uint32_t* BBTreeBucket::getTids() const {
+  return (const uint32_t*) (this->data + this->dimensions * this->capacity);
+}
+
+/**
+ * BBTreeBucket::getHashSlots() returns the slots of the hash index of
+ * a regular bucket. A slot holds the position of a data object plus one,
+ * or 0 if it is empty.
+ */
+inline uint32_t* BBTreeBucket::getHashSlots() const {
+  return (uint32_t*) (this->data + (this->dimensions + 1) * this->capacity);
+}
+
+/**
+ * BBTreeBucket::getHashMask() returns the number of hash index slots minus
+ * one (the capacity is always a power of two).
+ */
+inline size_t BBTreeBucket::getHashMask() const {
+  return BUCKET_HASH_SLOTS_PER_OBJECT * this->capacity - 1;
+}
+
+/**
+ * BBTreeBucket::hashValue(hash, value) combines hash with the given value.
+ * -0.0 and 0.0 compare equal, so both are hashed like 0.0.
+ */
+inline uint32_t BBTreeBucket::hashValue(const uint32_t hash, const float value) {
+  const float normalized = (value == 0.0f) ? 0.0f : value;
+  uint32_t bits;
+  memcpy(&bits, &normalized, sizeof(bits));
+  const uint32_t combined = (hash ^ bits) * 0x9E3779B1u;
+  return combined ^ (combined >> 15);
+}
+
+/**
+ * BBTreeBucket::finalizeHash(hash) mixes all bits of a combined hash into
+ * the low bits that select the hash index slot.
+ */
+inline uint32_t BBTreeBucket::finalizeHash(const uint32_t hash) {
+  uint32_t result = hash ^ (hash >> 16);
+  result *= 0x85EBCA6Bu;
+  return result ^ (result >> 13);
+}
+
+/**
+ * BBTreeBucket::hashStoredObject(i) returns the hash of the i'th data object
+ * of a regular bucket.
+ */
+inline uint32_t BBTreeBucket::hashStoredObject(const size_t index) const {
+  uint32_t hash = 0;
+  for (size_t j = 0; j < this->dimensions; ++j)
+    hash = BBTreeBucket::hashValue(hash, this->GetValue(index, j));
+  return BBTreeBucket::finalizeHash(hash);
+}
+
+/**
+ * BBTreeBucket::hashObject(search_object) returns the hash of the given data
+ * object; it equals hashStoredObject(i) if the i'th data object is equal.
+ */
+inline uint32_t BBTreeBucket::hashObject(const std::vector<float> &search_object) const {
+  uint32_t hash = 0;
+  for (size_t j = 0; j < this->dimensions; ++j)
+    hash = BBTreeBucket::hashValue(hash, search_object[j]);
+  return BBTreeBucket::finalizeHash(hash);
+}
+
+/**
+ * BBTreeBucket::isStoredObject(i, search_object) returns true if the i'th
+ * data object of a regular bucket equals the given one.
+ */
+inline bool BBTreeBucket::isStoredObject(const size_t index,
+                                         const std::vector<float> &search_object) const {
+  for (size_t j = 0; j < this->dimensions; ++j) {
+    if (this->GetValue(index, j) != search_object[j])
+      return false;
+  }
+  return true;
+}
+
+/**
+ * BBTreeBucket::findHashSlot(search_object, hash) returns the hash index slot
+ * that refers to the given data object with the given hash, or the empty slot
+ * where the probe ended if it is not stored.
+ */
+inline size_t BBTreeBucket::findHashSlot(const std::vector<float> &search_object,
+                                         const uint32_t hash) const {
+  const uint32_t* slots = this->getHashSlots();
+  const size_t mask = this->getHashMask();
+
+  size_t slot = hash & mask;
+  while (slots[slot] != 0 &&
+         !this->isStoredObject(slots[slot] - 1, search_object)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/**
+ * BBTreeBucket::getBloomFilterOffset() returns the offset (in floats) of the
+ * Bloom filter within the column storage of a regular bucket, which is
+ * rounded up to the next cache line.
+ */
+inline size_t BBTreeBucket::getBloomFilterOffset() const {
+  const size_t hash_slots = this->hashed ?
+    BUCKET_HASH_SLOTS_PER_OBJECT * this->capacity : 0;
+  const size_t line = BUCKET_CACHE_LINE_SIZE / sizeof(float);
+  return ((this->dimensions + 1) * this->capacity + hash_slots + line - 1) /
+         line * line;
+}
+
+/**
+ * BBTreeBucket::getBloomFilter() returns the Bloom filter of a regular bucket.
+ */
+inline uint64_t* BBTreeBucket::getBloomFilter() const {
+  return (uint64_t*) (this->data + this->getBloomFilterOffset());
+}
+
+/**
+ * BBTreeBucket::getNumberOfBloomWords() returns the size of the Bloom filter
+ * of a regular bucket in 64-bit words; it consists of at least one block.
+ */
+inline size_t BBTreeBucket::getNumberOfBloomWords() const {
+  const size_t blocks = std::max((size_t) 1,
+    (size_t) (this->capacity * BUCKET_BLOOM_BITS_PER_OBJECT / BUCKET_BLOOM_BLOCK_BITS));
+  return blocks * (BUCKET_BLOOM_BLOCK_BITS / 64);
+}
+
+/**
+ * BBTreeBucket::getBloomBlock(hash) returns the Bloom filter block that
+ * a data object with the given hash is recorded in.
+ */
+inline uint64_t* BBTreeBucket::getBloomBlock(const uint32_t hash) const {
+  const size_t num_blocks = this->getNumberOfBloomWords() /
+                            (BUCKET_BLOOM_BLOCK_BITS / 64);
+  const size_t block = ((uint64_t) hash * num_blocks) >> 32;
+  return this->getBloomFilter() + block * (BUCKET_BLOOM_BLOCK_BITS / 64);
+}
+
+/**
+ * BBTreeBucket::bloomFilterContains(hash) returns false if no data object
+ * with the given hash has been inserted since the Bloom filter was built.
+ * The four bits of a data object lie in the same block, so a lookup touches
+ * a single cache line.
+ */
+inline bool BBTreeBucket::bloomFilterContains(const uint32_t hash) const {
+  const uint64_t* block = this->getBloomBlock(hash);
+  const uint32_t bits = BBTreeBucket::finalizeHash(hash ^ 0x5BD1E995u);
+  for (size_t i = 0; i < 4; ++i) {
+    const size_t bit = (bits >> (8 * i)) & 255;
+    if ((block[bit >> 6] & ((uint64_t) 1 << (bit & 63))) == 0)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * BBTreeBucket::addToBloomFilter(hash) records a data object with the given
+ * hash in the Bloom filter.
+ */
+inline void BBTreeBucket::addToBloomFilter(const uint32_t hash) {
+  uint64_t* block = this->getBloomBlock(hash);
+  const uint32_t bits = BBTreeBucket::finalizeHash(hash ^ 0x5BD1E995u);
+  for (size_t i = 0; i < 4; ++i) {
+    const size_t bit = (bits >> (8 * i)) & 255;
+    block[bit >> 6] |= ((uint64_t) 1 << (bit & 63));
+  }
+}
+
+/**
+ * BBTreeBucket::getPositionRow(position) returns the row of a position within
+ * its (sub-)bucket.
+ */
+inline size_t BBTreeBucket::getPositionRow(const uint32_t position) {
+  return position & (((uint32_t) 1 << BUCKET_POSITION_ROW_BITS) - 1);
+}
+
+/**
+ * BBTreeBucket::findObject(search_object) returns the position of the given
+ * data object in a regular bucket, or -1 if it is not stored.
+ * With a Bloom filter, it first rejects data objects the filter does not
+ * contain. With a hash index, it probes the hash index. Otherwise, it scans
+ * the first column and compares the remaining dimensions only for data
+ * objects that match in the first one.
+ */
+inline int32_t BBTreeBucket::findObject(const std::vector<float> &search_object) const {
+  const size_t count = this->count;
+  if (count == 0)
+    return -1;
+  if (this->hashed || this->filtered) {
+    const uint32_t hash = this->hashObject(search_object);
+    if (this->filtered && !this->bloomFilterContains(hash))
+      return -1;
+    if (this->hashed) {
+      const size_t slot = this->findHashSlot(search_object, hash);
+      return (int32_t) this->getHashSlots()[slot] - 1;
+    }
+  }
+  const float* first_column = this->getColumn(0);
+  const float first_value = search_object[0];
+
+  for (size_t i = 0; i < count; ++i) {
+    if (first_column[i] != first_value)
+      continue;
+    if (this->isStoredObject(i, search_object))
+      return (int32_t) i;
+  }
+
+  return -1;
+}
+
+/**
+ * BBTreeBucket::SearchObject(search_object) executes a point query.
+ * If the given point query object is found, it returns its tid.
+ * If no matching object is found, it returns -1.
+ */
+inline int32_t BBTreeBucket::SearchObject(const std::vector<float> &search_object) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET: {
+      const BBTreeBucket &bucket =
+        this->super_bucket->buckets[this->super_bucket->getBucket(search_object)];
+      const int32_t index = bucket.findObject(search_object);
+      return (index == -1) ? -1 : bucket.getTids()[index];
+    }
+    default: {
+      const int32_t index = this->findObject(search_object);
+      return (index == -1) ? -1 : this->getTids()[index];
+    }
+  }
+}
+
+/**
+ * BBTreeBucket::getBlockMask(block,lower_bounds,upper_bounds) is the range
+ * query kernel of regular buckets.
+ * It returns a bitmask of the data objects of the block of 64 data objects
+ * starting at row block that match the range query. It processes the block
+ * column by column and skips the remaining dimensions as soon as no data
+ * object of the block qualifies anymore.
+ */
+inline uint64_t BBTreeBucket::getBlockMask(const size_t block,
+                                           const std::vector<float> &lower_boundary,
+                                           const std::vector<float> &upper_boundary) const {
+  const size_t count = this->count;
+  const size_t block_size = (count - block < 64) ? (count - block) : 64;
+  uint64_t mask = (block_size == 64) ? ~((uint64_t) 0) :
+                                       ((((uint64_t) 1) << block_size) - 1);
+  for (size_t j = 0; j < this->dimensions && mask != 0; ++j) {
+    const float* column = this->getColumn(j) + block;
+    const float lower = lower_boundary[j];
+    const float upper = upper_boundary[j];
+    uint64_t dimension_mask = 0;
+    size_t i = 0;
+#ifdef __AVX__
+    const __m256 lower_vec = _mm256_set1_ps(lower);
+    const __m256 upper_vec = _mm256_set1_ps(upper);
+    for (; i + 8 <= block_size; i += 8) {
+      const __m256 values = _mm256_loadu_ps(column + i);
+      const __m256 match = _mm256_and_ps(
+        _mm256_cmp_ps(values, lower_vec, _CMP_GE_OQ),
+        _mm256_cmp_ps(values, upper_vec, _CMP_LE_OQ));
+      dimension_mask |= ((uint64_t) _mm256_movemask_ps(match)) << i;
+    }
+#endif
+    for (; i < block_size; ++i) {
+      dimension_mask |= ((uint64_t) (column[i] >= lower &&
+                                     column[i] <= upper)) << i;
+    }
+    mask &= dimension_mask;
+  }
+  return mask;
+}
+
+/**
+ * BBTreeBucket::scanRange(results,lower_bounds,upper_bounds) executes a range
+ * query on a regular bucket block by block and appends the tids of the
+ * matching data objects to results.
+ */
+inline void BBTreeBucket::scanRange(std::vector<uint32_t> &results,
+                                    const std::vector<float> &lower_boundary,
+                                    const std::vector<float> &upper_boundary) const {
+  const uint32_t* tids = this->getTids();
+
+  for (size_t block = 0; block < this->count; block += 64) {
+    uint64_t mask = this->getBlockMask(block, lower_boundary, upper_boundary);
+    while (mask != 0) {
+      results.push_back(tids[block + __builtin_ctzll(mask)]);
+      mask &= mask - 1;
+    }
+  }
+}
+
+/**
+ * BBTreeBucket::SelectRange(bitmap,lower_bounds,upper_bounds) executes a range
+ * query on a regular bucket and stores a selection bitmap with one bit per
+ * row in the given ceil(count / 64) words. It returns the number of matching
+ * data objects; no tids are touched.
+ */
+inline size_t BBTreeBucket::SelectRange(uint64_t *bitmap,
+                                        const std::vector<float> &lower_boundary,
+                                        const std::vector<float> &upper_boundary) const {
+  size_t matches = 0;
+  for (size_t block = 0; block < this->count; block += 64) {
+    const uint64_t mask = this->getBlockMask(block, lower_boundary, upper_boundary);
+    bitmap[block / 64] = mask;
+    matches += __builtin_popcountll(mask);
+  }
+  return matches;
+}
+
+/**
+ * BBTreeBucket::SearchRange(results,lower_bounds,upper_bounds) executes
+ * a range query and stores the tids of all matching data objects in the given
+ * std::vector results.
+ * For superbuckets, it exploits the delimiter dimension and values to scan
+ * only the relevant buckets.
+ */
+inline void BBTreeBucket::SearchRange(std::vector<uint32_t> &results,
+                                      const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i) {
+        if (this->super_bucket->isRelevantForRange(i, lower_boundary,
+                                                   upper_boundary)) {
+          this->super_bucket->buckets[i].scanRange(results, lower_boundary,
+                                                   upper_boundary);
+        }
+      }
+      break;
+    default:
+      this->scanRange(results, lower_boundary, upper_boundary);
+  }
+}
+
+/**
+ * BBTreeBucket::CountRange(lower_bounds,upper_bounds) returns the number of
+ * data objects that match the given range query without touching their tids.
+ */
+inline size_t BBTreeBucket::CountRange(const std::vector<float> &lower_boundary,
+                                       const std::vector<float> &upper_boundary) const {
+  size_t matches = 0;
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i) {
+        if (this->super_bucket->isRelevantForRange(i, lower_boundary,
+                                                   upper_boundary)) {
+          matches += this->super_bucket->buckets[i].CountRange(lower_boundary,
+                                                               upper_boundary);
+        }
+      }
+      break;
+    default:
+      for (size_t block = 0; block < this->count; block += 64) {
+        matches += __builtin_popcountll(this->getBlockMask(block, lower_boundary,
+                                                           upper_boundary));
+      }
+  }
+  return matches;
+}
+
+/**
+ * BBTreeBucket::AggregateRange(lower_bounds,upper_bounds,dimension,aggregate)
+ * adds the values of the given dimension of all data objects that match the
+ * given range query to aggregate.
+ */
+inline void BBTreeBucket::AggregateRange(const std::vector<float> &lower_boundary,
+                                         const std::vector<float> &upper_boundary,
+                                         const size_t dimension,
+                                         BBTreeAggregate &aggregate) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i) {
+        if (this->super_bucket->isRelevantForRange(i, lower_boundary,
+                                                   upper_boundary)) {
+          this->super_bucket->buckets[i].AggregateRange(lower_boundary,
+                                                        upper_boundary,
+                                                        dimension, aggregate);
+        }
+      }
+      break;
+    default:
+      const float* column = this->getColumn(dimension);
+      for (size_t block = 0; block < this->count; block += 64) {
+        uint64_t mask = this->getBlockMask(block, lower_boundary, upper_boundary);
+        aggregate.count += __builtin_popcountll(mask);
+        while (mask != 0) {
+          const float value = column[block + __builtin_ctzll(mask)];
+          aggregate.min = std::min(aggregate.min, value);
+          aggregate.max = std::max(aggregate.max, value);
+          aggregate.sum += value;
+          mask &= mask - 1;
+        }
+      }
+  }
+}
+
+/**
+ * BBTreeBucket::SearchRangeTopK(lower_bounds,upper_bounds,dimension,k,heap)
+ * executes a range query and keeps the k matching data objects with the
+ * smallest values in the given dimension in heap, a max-heap of
+ * (value, tid) pairs that may already hold matches of other buckets.
+ */
+inline void BBTreeBucket::SearchRangeTopK(const std::vector<float> &lower_boundary,
+                                          const std::vector<float> &upper_boundary,
+                                          const size_t dimension,
+                                          const size_t k,
+                                          std::vector<std::pair<float, uint32_t> > &heap) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i) {
+        if (this->super_bucket->isRelevantForRange(i, lower_boundary,
+                                                   upper_boundary)) {
+          this->super_bucket->buckets[i].SearchRangeTopK(lower_boundary,
+                                                         upper_boundary,
+                                                         dimension, k, heap);
+        }
+      }
+      break;
+    default:
+      const float* column = this->getColumn(dimension);
+      const uint32_t* tids = this->getTids();
+      for (size_t block = 0; block < this->count; block += 64) {
+        uint64_t mask = this->getBlockMask(block, lower_boundary, upper_boundary);
+        while (mask != 0) {
+          const size_t row = block + __builtin_ctzll(mask);
+          const std::pair<float, uint32_t> match(column[row], tids[row]);
+          if (heap.size() < k) {
+            heap.push_back(match);
+            std::push_heap(heap.begin(), heap.end());
+          } else if (match < heap.front()) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = match;
+            std::push_heap(heap.begin(), heap.end());
+          }
+          mask &= mask - 1;
+        }
+      }
+  }
+}
+
+/**
+ * BBTreeBucket::SearchKNN(search_object,metric,k,heap) keeps the k data
+ * objects with the smallest distances to search_object in heap, a max-heap of
+ * (distance, tid) pairs that may already hold data objects of other buckets.
+ * L2 distances are stored squared.
+ * For superbuckets, buckets whose interval in the delimiter dimension is
+ * farther away than the k-th distance of a full heap are skipped.
+ */
+inline void BBTreeBucket::SearchKNN(const std::vector<float> &search_object,
+                                    const BBTreeMetric metric,
+                                    const size_t k,
+                                    std::vector<std::pair<float, uint32_t> > &heap) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i) {
+        const float difference = this->super_bucket->getIntervalDistance(i,
+          search_object[this->super_bucket->delimiter_dimension]);
+        if (heap.size() == k &&
+            BBTreeBucket::AccumulateDistance(0.0f, difference, metric) >
+              heap.front().first) {
+          continue;
+        }
+        this->super_bucket->buckets[i].scanKNN(search_object, metric, k, heap);
+      }
+      break;
+    default:
+      this->scanKNN(search_object, metric, k, heap);
+  }
+}
+
+/**
+ * BBTreeBucket::SearchRadius(search_object,metric,max_distance,results)
+ * appends the tids of all data objects whose distance to search_object is at
+ * most max_distance (squared for L2) to results.
+ * For superbuckets, buckets whose interval in the delimiter dimension is
+ * farther away than max_distance are skipped.
+ */
+inline void BBTreeBucket::SearchRadius(const std::vector<float> &search_object,
+                                       const BBTreeMetric metric,
+                                       const float max_distance,
+                                       std::vector<uint32_t> &results) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i) {
+        const float difference = this->super_bucket->getIntervalDistance(i,
+          search_object[this->super_bucket->delimiter_dimension]);
+        if (BBTreeBucket::AccumulateDistance(0.0f, difference, metric) <=
+              max_distance) {
+          this->super_bucket->buckets[i].SearchRadius(search_object, metric,
+                                                      max_distance, results);
+        }
+      }
+      break;
+    default:
+      const uint32_t* tids = this->getTids();
+      float distances[64];
+      for (size_t block = 0; block < this->count; block += 64) {
+        const size_t block_size = (this->count - block < 64) ? (this->count - block) : 64;
+        this->getBlockDistances(block, block_size, search_object, metric,
+                                distances);
+        for (size_t i = 0; i < block_size; ++i) {
+          if (distances[i] <= max_distance)
+            results.push_back(tids[block + i]);
+        }
+      }
+  }
+}
+
+/**
+ * BBTreeBucket::JoinDistance(other,metric,max_distance,results) appends the
+ * pairs of tids (this bucket, other bucket) of all data objects whose
+ * distance is at most max_distance (squared for L2) to results.
+ * Every data object of this bucket probes the other bucket with the
+ * vectorized distance kernel of SearchRadius().
+ */
+inline void BBTreeBucket::JoinDistance(const BBTreeBucket &other,
+                                       const BBTreeMetric metric,
+                                       const float max_distance,
+                                       std::vector<std::pair<uint32_t, uint32_t> > &results) const {
+  std::vector<float> search_object;
+  std::vector<uint32_t> matches;
+  for (size_t b = 0; b < this->GetNumberOfRegularBuckets(); ++b) {
+    const BBTreeBucket &bucket = this->GetRegularBucket(b);
+    const uint32_t* tids = bucket.getTids();
+    search_object.resize(bucket.dimensions);
+    for (size_t i = 0; i < bucket.count; ++i) {
+      for (size_t j = 0; j < bucket.dimensions; ++j)
+        search_object[j] = bucket.GetValue(i, j);
+      matches.clear();
+      other.SearchRadius(search_object, metric, max_distance, matches);
+      for (size_t m = 0; m < matches.size(); ++m)
+        results.push_back(std::make_pair(tids[i], matches[m]));
+    }
+  }
+}
+
+/**
+ * BBTreeBucket::AccumulateDistance(distance,difference,metric) adds the
+ * difference of two data objects in one dimension to their partial distance.
+ */
+inline float BBTreeBucket::AccumulateDistance(const float distance,
+                                              const float difference,
+                                              const BBTreeMetric metric) {
+  switch (metric) {
+    case BBTREE_METRIC_L1:
+      return distance + std::fabs(difference);
+    case BBTREE_METRIC_LINF:
+      return std::max(distance, std::fabs(difference));
+    default:
+      return distance + difference * difference;
+  }
+}
+
+/**
+ * BBTreeBucket::getBlockDistances(block,block_size,search_object,metric,distances)
+ * computes the distances of the data objects block to block+block_size-1 of
+ * a regular bucket to search_object column by column (L2 distances squared).
+ */
+inline void BBTreeBucket::getBlockDistances(const size_t block,
+                                            const size_t block_size,
+                                            const std::vector<float> &search_object,
+                                            const BBTreeMetric metric,
+                                            float *distances) const {
+  for (size_t i = 0; i < block_size; ++i)
+    distances[i] = 0.0f;
+  for (size_t j = 0; j < this->dimensions; ++j) {
+    const float* column = this->getColumn(j) + block;
+    const float value = search_object[j];
+    size_t i = 0;
+#ifdef __AVX__
+    const __m256 value_vec = _mm256_set1_ps(value);
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    for (; i + 8 <= block_size; i += 8) {
+      const __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(column + i),
+                                              value_vec);
+      __m256 distance = _mm256_loadu_ps(distances + i);
+      switch (metric) {
+        case BBTREE_METRIC_L1:
+          distance = _mm256_add_ps(distance,
+                                   _mm256_andnot_ps(sign_mask, difference));
+          break;
+        case BBTREE_METRIC_LINF:
+          distance = _mm256_max_ps(distance,
+                                   _mm256_andnot_ps(sign_mask, difference));
+          break;
+        default:
+          distance = _mm256_add_ps(distance,
+                                   _mm256_mul_ps(difference, difference));
+      }
+      _mm256_storeu_ps(distances + i, distance);
+    }
+#endif
+    for (; i < block_size; ++i) {
+      distances[i] = BBTreeBucket::AccumulateDistance(distances[i],
+                                                      column[i] - value,
+                                                      metric);
+    }
+  }
+}
+
+/**
+ * BBTreeBucket::scanKNN(search_object,metric,k,heap) computes the distances
+ * of the data objects of a regular bucket in blocks of 64 and adds those that
+ * are closer than the k-th distance of heap to heap.
+ */
+inline void BBTreeBucket::scanKNN(const std::vector<float> &search_object,
+                                  const BBTreeMetric metric,
+                                  const size_t k,
+                                  std::vector<std::pair<float, uint32_t> > &heap) const {
+  const uint32_t* tids = this->getTids();
+  float distances[64];
+
+  for (size_t block = 0; block < this->count; block += 64) {
+    const size_t block_size = (this->count - block < 64) ? (this->count - block) : 64;
+    this->getBlockDistances(block, block_size, search_object, metric, distances);
+    for (size_t i = 0; i < block_size; ++i) {
+      const std::pair<float, uint32_t> candidate(distances[i], tids[block + i]);
+      if (heap.size() < k) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end());
+      } else if (candidate < heap.front()) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end());
+      }
+    }
+  }
+}
+
+/**
+ * BBTreeBucket::SearchRanges(lower_bounds,upper_bounds,boxes,results,union_results)
+ * executes the range queries (boxes) with the given indexes in a single scan:
+ * every block of 64 data objects is tested against all boxes while it resides
+ * in the cache. Unless NULL, the matches of box b are appended to results[b]
+ * and the matches of any box to union_results (each data object once).
+ */
+inline void BBTreeBucket::SearchRanges(const std::vector<std::vector<float> > &lower_boundaries,
+                                       const std::vector<std::vector<float> > &upper_boundaries,
+                                       const std::vector<uint32_t> &boxes,
+                                       std::vector<std::vector<uint32_t> > *results,
+                                       std::vector<uint32_t> *union_results) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i) {
+        for (size_t b = 0; b < boxes.size(); ++b) {
+          if (this->super_bucket->isRelevantForRange(i, lower_boundaries[boxes[b]],
+                                                     upper_boundaries[boxes[b]])) {
+            this->super_bucket->buckets[i].SearchRanges(lower_boundaries,
+                                                        upper_boundaries,
+                                                        boxes, results,
+                                                        union_results);
+            break;
+          }
+        }
+      }
+      break;
+    default:
+      const uint32_t* tids = this->getTids();
+      for (size_t block = 0; block < this->count; block += 64) {
+        uint64_t any_mask = 0;
+        for (size_t b = 0; b < boxes.size(); ++b) {
+          uint64_t mask = this->getBlockMask(block, lower_boundaries[boxes[b]],
+                                             upper_boundaries[boxes[b]]);
+          any_mask |= mask;
+          if (results == NULL)
+            continue;
+          while (mask != 0) {
+            (*results)[boxes[b]].push_back(tids[block + __builtin_ctzll(mask)]);
+            mask &= mask - 1;
+          }
+        }
+        if (union_results == NULL)
+          continue;
+        while (any_mask != 0) {
+          union_results->push_back(tids[block + __builtin_ctzll(any_mask)]);
+          any_mask &= any_mask - 1;
+        }
+      }
+  }
+}
+
+/**
+ * BBTreeBucket::GetAllTids(results) appends the tids of all data objects
+ * to results. It is used for buckets that are fully covered by a query.
+ */
+inline void BBTreeBucket::GetAllTids(std::vector<uint32_t> &results) const {
+  for (size_t i = 0; i < this->GetNumberOfRegularBuckets(); ++i) {
+    const BBTreeBucket &bucket = this->GetRegularBucket(i);
+    const uint32_t* tids = bucket.getTids();
+    results.insert(results.end(), tids, tids + bucket.count);
+  }
+}
+
+/**
+ * BBTreeBucket::Prefetch(tids_only) prefetches the first cache line of every
+ * column and of the tids (or only of the tids) into the cache.
+ * For superbuckets, it prefetches the headers of the z buckets.
+ */
+inline void BBTreeBucket::Prefetch(const bool tids_only) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      __builtin_prefetch(this->super_bucket);
+      __builtin_prefetch(this->super_bucket->buckets);
+      break;
+    default:
+      if (this->count == 0)
+        return;
+      if (!tids_only) {
+        for (size_t j = 0; j < this->dimensions; ++j)
+          __builtin_prefetch(this->getColumn(j));
+      }
+      __builtin_prefetch(this->getTids());
+  }
+}
+
+/**
+ * According to the delimiter dimension and values of the superbucket,
+ * BBTreeSuperBucket::getBucket(feature_vector) returns the bucket
+ * relevant for the given feature vector.
+ */
+inline size_t BBTreeSuperBucket::getBucket(const std::vector<float> &feature_vector) const {
+  size_t bucket_id = 0;
+  for (size_t i = 0; i < (this->num_buckets - 1); ++i) {
+    if (feature_vector[this->delimiter_dimension] <= this->delimiter_values[i]) {
+      break;
+    } else {
+      bucket_id++;
+    }
+  }
+
+  return bucket_id;
+}
+
+/**
+ * BBTreeSuperBucket::isRelevantForRange(i,lower_bounds,upper_bounds) returns
+ * true if the i'th bucket may hold data objects of the given range query.
+ * The i'th bucket holds the values in (delimiter_values[i-1],
+ * delimiter_values[i]] of the delimiter dimension.
+ */
+inline bool BBTreeSuperBucket::isRelevantForRange(const size_t bucket_id,
+                                                  const std::vector<float> &lower_boundary,
+                                                  const std::vector<float> &upper_boundary) const {
+  const float lower = lower_boundary[this->delimiter_dimension];
+  const float upper = upper_boundary[this->delimiter_dimension];
+
+  if (bucket_id > 0 && this->delimiter_values[bucket_id - 1] >= upper)
+    return false;
+  if (bucket_id < this->num_buckets - 1 &&
+      this->delimiter_values[bucket_id] < lower)
+    return false;
+  return true;
+}
+
+/**
+ * BBTreeSuperBucket::getIntervalDistance(i,value) returns the distance of the
+ * given value of the delimiter dimension to the interval of the i'th bucket.
+ */
+inline float BBTreeSuperBucket::getIntervalDistance(const size_t bucket_id,
+                                                    const float value) const {
+  if (bucket_id > 0 && value < this->delimiter_values[bucket_id - 1])
+    return this->delimiter_values[bucket_id - 1] - value;
+  if (bucket_id < this->num_buckets - 1 && value > this->delimiter_values[bucket_id])
+    return value - this->delimiter_values[bucket_id];
+  return 0.0f;
+}
+
 #endif
@@ -0,0 +1,106 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREEHYBRIDINDEX
+#define BBTREEHYBRIDINDEX
+#pragma once
+
+// Maximum number of data objects per partition of the column store
+#define HYBRID_PARTITION_SIZE 65536
+// Number of selectivity classes; class i covers selectivities in
+// (2^-(i+1), 2^-i]
+#define HYBRID_SELECTIVITY_BINS 24
+// Number of runtimes of each access path observed per class before the
+// faster one is chosen
+#define HYBRID_MIN_OBSERVATIONS 2
+// Every n'th query of a class runs on the slower access path to detect
+// shifts of the crossover
+#define HYBRID_EXPLORE_INTERVAL 32
+// Weight of a new runtime in the moving averages
+#define HYBRID_LEARNING_RATE 0.2
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BBTree;
+class BBTreeBucket;
+
+/**
+ * Access path of a range query.
+ */
+enum BBTreeAccessPath {
+  BBTREE_ACCESS_TREE,
+  BBTREE_ACCESS_SCAN
+};
+
+/**
+ * Index that keeps a BB-Tree plus an optional column-store copy of its data
+ * objects, and runs every range query on the cheaper access path: the
+ * multi-threaded BB-Tree search for selective queries, or a multi-threaded
+ * SIMD scan of the column store for unselective ones.
+ *
+ * The choice is based on the selectivity estimated by
+ * BBTree::EstimateRange(). For every class of selectivities, the index keeps
+ * moving averages of the observed runtimes of both access paths and picks
+ * the faster one, so the crossover selectivity is learned from the hardware
+ * and data at hand.
+ * The column store is a copy: after modifying the BB-Tree, it has to be
+ * refreshed with SetColumnStore(true).
+ *
+ * Example usage:
+ *   BBTreeHybridIndex index(*bbtree);
+ *   index.SetColumnStore(true);
+ *   std::vector<uint32_t> results = index.SearchRange(lower_boundary,
+ *                                                     upper_boundary);
+ */
+class BBTreeHybridIndex {
+  public:
+    explicit BBTreeHybridIndex(BBTree &bbtree);
+    ~BBTreeHybridIndex();
+
+    void SetColumnStore(const bool enabled);
+    std::vector<uint32_t> SearchRange(const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary);
+    std::vector<uint32_t> SearchRangeScan(const std::vector<float> &lower_boundary,
+                                          const std::vector<float> &upper_boundary);
+    BBTreeAccessPath GetLastAccessPath() const;
+    double GetCrossover() const;
+  private:
+    BBTree &bbtree;
+    // column store, partitioned into regular buckets
+    BBTreeBucket* partitions;
+    size_t num_partitions;
+
+    // moving averages of the runtimes (in ms) and numbers of observations
+    // per selectivity class and access path
+    double runtimes[2][HYBRID_SELECTIVITY_BINS];
+    size_t observations[2][HYBRID_SELECTIVITY_BINS];
+    BBTreeAccessPath last_access_path;
+
+    BBTreeHybridIndex(const BBTreeHybridIndex &other) = delete;
+    BBTreeHybridIndex& operator=(const BBTreeHybridIndex &other) = delete;
+
+    static size_t getSelectivityBin(const double selectivity);
+    BBTreeAccessPath chooseAccessPath(const size_t bin) const;
+    void observeRuntime(const BBTreeAccessPath path,
+                        const size_t bin,
+                        const double runtime);
+    static void ScanPartitions(int thread_id,
+                               BBTreeHybridIndex *index,
+                               std::vector<uint32_t> &results,
+                               const std::vector<float> &lower_boundary,
+                               const std::vector<float> &upper_boundary,
+                               const size_t start,
+                               const size_t end);
+};
+
+#endif
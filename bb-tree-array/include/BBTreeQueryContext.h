@@ -0,0 +1,68 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREEQUERYCONTEXT
+#define BBTREEQUERYCONTEXT
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+/**
+ * Reusable result and scratch buffers of range queries.
+ *
+ * A range query that is executed with a context clears its buffers instead
+ * of allocating new ones, so once the buffers have grown to the size of the
+ * largest query, further queries do not allocate memory on the heap (except
+ * for the tasks of the thread pool).
+ * A context must not be used by multiple queries at the same time.
+ *
+ * Example usage:
+ *   BBTreeQueryContext context;
+ *   for (...) {
+ *     bbtree->SearchRangeMT(lower_boundary, upper_boundary, context);
+ *     const std::vector<uint32_t> &results = context.GetResults();
+ *   }
+ */
+class BBTreeQueryContext {
+  public:
+    BBTreeQueryContext() {}
+
+    inline const std::vector<uint32_t>& GetResults() const;
+  private:
+    friend class BBTree;
+
+    // tids of the matching data objects of the last query
+    std::vector<uint32_t> results;
+    // buckets relevant for the last query
+    std::vector<size_t> match_buckets;
+    // inner nodes of the next level while descending the tree
+    std::vector<size_t> next_nodes;
+    // buckets of match_buckets, superbuckets twice (multi-threading only)
+    std::vector<size_t> partitions;
+    std::vector<std::future<void> > futures;
+    std::vector<std::vector<uint32_t> > thread_results;
+
+    BBTreeQueryContext(const BBTreeQueryContext &other) = delete;
+    BBTreeQueryContext& operator=(const BBTreeQueryContext &other) = delete;
+};
+
+/**
+ * BBTreeQueryContext::GetResults() returns the tids of the matching data
+ * objects of the last range query executed with this context.
+ */
+inline const std::vector<uint32_t>& BBTreeQueryContext::GetResults() const {
+  return this->results;
+}
+
+#endif
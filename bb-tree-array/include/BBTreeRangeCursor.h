@@ -0,0 +1,97 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREERANGECURSOR
+#define BBTREERANGECURSOR
+#pragma once
+
+// Maximum number of result batches buffered by a multi-threaded cursor
+// before its producers block
+#define CURSOR_QUEUE_CAPACITY 64
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <vector>
+
+class BBTree;
+
+/**
+ * Matching data objects of one bucket of a range query.
+ */
+struct BBTreeResultBatch {
+  std::vector<uint32_t> tids;
+  // feature vectors of the matching data objects (row by row), if requested
+  std::vector<float> objects;
+  size_t dimensions;
+};
+
+/**
+ * Pull iterator over the results of a range query, which yields the matching
+ * data objects bucket by bucket while the query is still running.
+ *
+ * A single-threaded cursor scans the next bucket on every call of Next().
+ * A multi-threaded cursor scans buckets on the thread pool of the BB-Tree and
+ * buffers at most CURSOR_QUEUE_CAPACITY batches; if the consumer falls
+ * behind, the producers block (backpressure).
+ * Destroying a cursor cancels the remaining scan. The BB-Tree must not be
+ * modified while a cursor is open.
+ *
+ * Example usage:
+ *   BBTreeRangeCursor cursor(*bbtree, lower_boundary, upper_boundary,
+ *                            false, true);
+ *   BBTreeResultBatch batch;
+ *   while (cursor.Next(batch)) { ... }
+ */
+class BBTreeRangeCursor {
+  public:
+    BBTreeRangeCursor(BBTree &bbtree,
+                      const std::vector<float> &lower_boundary,
+                      const std::vector<float> &upper_boundary,
+                      const bool with_objects,
+                      const bool multithreaded);
+    ~BBTreeRangeCursor();
+
+    bool Next(BBTreeResultBatch &batch);
+  private:
+    BBTree &bbtree;
+    const std::vector<float> lower_boundary;
+    const std::vector<float> upper_boundary;
+    const bool with_objects;
+    const bool multithreaded;
+    std::vector<size_t> match_buckets;
+    // next bucket of match_buckets to be scanned
+    std::atomic<size_t> next_bucket;
+    // selection bitmap used by the single-threaded cursor
+    std::vector<uint64_t> bitmap;
+
+    // state shared with the producers of a multi-threaded cursor
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<BBTreeResultBatch> queue;
+    size_t active_producers;
+    // set once the cursor is destroyed; producers check it before every
+    // bucket, such that they stop scanning early
+    std::atomic<bool> cancelled;
+    std::vector<std::future<void> > producers;
+
+    BBTreeRangeCursor(const BBTreeRangeCursor &other) = delete;
+    BBTreeRangeCursor& operator=(const BBTreeRangeCursor &other) = delete;
+
+    static void Produce(int thread_id, BBTreeRangeCursor *cursor);
+};
+
+#endif
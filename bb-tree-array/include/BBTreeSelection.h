@@ -0,0 +1,96 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREESELECTION
+#define BBTREESELECTION
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BBTreeBucket.h"
+#include "BBTreeTidSet.h"
+
+/**
+ * Result of a range query in bitmap form (late materialization).
+ *
+ * For every scanned regular (sub-)bucket, it holds a selection bitmap with
+ * one bit per row. Tids are decoded only when the result is iterated,
+ * materialized or converted into a BBTreeTidSet; counting only requires
+ * the bitmaps.
+ * A selection refers to the buckets of the BB-Tree and is valid until the
+ * BB-Tree is modified.
+ *
+ * Example usage:
+ *   BBTreeSelection selection;
+ *   bbtree->SearchRange(lower_boundary, upper_boundary, selection);
+ *   size_t num_matches = selection.Count();
+ */
+class BBTreeSelection {
+  public:
+    BBTreeSelection() : num_matches(0) {}
+
+    size_t Count() const;
+    template <typename Function>
+    void ForEach(Function function) const;
+    void Materialize(std::vector<uint32_t> &results) const;
+    BBTreeTidSet ToTidSet() const;
+    size_t GetSizeInBytes() const;
+    void Clear();
+  private:
+    friend class BBTree;
+
+    /**
+     * Scanned regular (sub-)bucket and the offset of its selection bitmap.
+     */
+    struct Entry {
+      const BBTreeBucket* bucket;
+      size_t offset;
+      // if set, all data objects of the bucket match
+      bool contained;
+    };
+
+    std::vector<Entry> entries;
+    // selection bitmaps of all entries
+    std::vector<uint64_t> words;
+    size_t num_matches;
+
+    void addBucket(const BBTreeBucket *bucket, const bool contained);
+    void allocate();
+    size_t selectEntries(const size_t start,
+                         const size_t end,
+                         const std::vector<float> &lower_boundary,
+                         const std::vector<float> &upper_boundary);
+};
+
+/**
+ * BBTreeSelection::ForEach(function) decodes the selection bitmaps and calls
+ * function(tid) for all matching data objects.
+ */
+template <typename Function>
+void BBTreeSelection::ForEach(Function function) const {
+  for (size_t i = 0; i < this->entries.size(); ++i) {
+    const BBTreeBucket &bucket = *this->entries[i].bucket;
+    const uint32_t* tids = bucket.getTids();
+    const size_t num_words = (bucket.count + 63) / 64;
+    const uint64_t* words = this->words.data() + this->entries[i].offset;
+    for (size_t w = 0; w < num_words; ++w) {
+      uint64_t word = words[w];
+      while (word != 0) {
+        function(tids[w * 64 + __builtin_ctzll(word)]);
+        word &= word - 1;
+      }
+    }
+  }
+}
+
+#endif
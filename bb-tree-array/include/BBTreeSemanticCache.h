@@ -0,0 +1,134 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREESEMANTICCACHE
+#define BBTREESEMANTICCACHE
+#pragma once
+
+// Default memory budget of the cached query boxes in bytes
+#define SEMANTIC_CACHE_BUDGET (64 * 1024 * 1024)
+// Maximum number of cached query boxes
+#define SEMANTIC_CACHE_MAX_ENTRIES 64
+// Minimum fraction of a range query that a cached box has to cover to
+// answer the query with remainder queries
+#define SEMANTIC_CACHE_MIN_OVERLAP 0.25
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <vector>
+
+class BBTree;
+
+/**
+ * Semantic cache of range queries on a BB-Tree. It keeps the boxes of
+ * recent range queries together with their matching data objects and uses
+ * them to answer later queries:
+ *  - a query that is contained in a cached box (hit) is answered by
+ *    filtering the cached data objects without accessing any bucket,
+ *  - a query that overlaps a cached box (partial hit) is answered by
+ *    filtering the cached data objects and running remainder queries for
+ *    the uncovered region only,
+ *  - all other queries are executed on the BB-Tree (miss).
+ * Results of partial hits and misses are cached as new boxes; boxes are
+ * evicted in LRU order once SEMANTIC_CACHE_MAX_ENTRIES or the memory budget
+ * is exceeded.
+ *
+ * Every box records the versions of the buckets that its query reads (see
+ * BBTreeResultCache). Boxes that were cached before a rebuild of the
+ * BB-Tree are dropped when they are encountered; the bucket versions are
+ * only checked for boxes that would answer a query, and boxes whose buckets
+ * have been modified since are dropped then.
+ *
+ * Example usage:
+ *   BBTreeSemanticCache cache(*bbtree);
+ *   std::vector<uint32_t> results = cache.SearchRangeMT(lower_boundary,
+ *                                                       upper_boundary);
+ */
+class BBTreeSemanticCache {
+  public:
+    explicit BBTreeSemanticCache(BBTree &bbtree,
+                                 const size_t budget = SEMANTIC_CACHE_BUDGET);
+
+    std::vector<uint32_t> SearchRange(const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary);
+    std::vector<uint32_t> SearchRangeMT(const std::vector<float> &lower_boundary,
+                                        const std::vector<float> &upper_boundary);
+    void Clear();
+    size_t GetHits() const;
+    size_t GetPartialHits() const;
+    size_t GetMisses() const;
+    size_t GetRemainderQueries() const;
+    size_t GetNumberOfEntries() const;
+    size_t GetSizeInBytes() const;
+  private:
+    /**
+     * Cached query box and its matching data objects.
+     */
+    struct Entry {
+      std::vector<float> lower_boundary;
+      std::vector<float> upper_boundary;
+      std::vector<uint32_t> tids;
+      // feature vectors of the matching data objects (row by row)
+      std::vector<float> objects;
+      // buckets read by the query and their versions at caching time
+      std::vector<size_t> buckets;
+      std::vector<uint64_t> versions;
+      uint64_t structure_version;
+      size_t bytes;
+    };
+
+    BBTree &bbtree;
+    const size_t budget;
+    // cached boxes, most recently used first
+    std::list<Entry> entries;
+    size_t size_in_bytes;
+    size_t hits;
+    size_t partial_hits;
+    size_t misses;
+    size_t remainder_queries;
+
+    std::vector<uint32_t> searchRange(const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary,
+                                      const bool multithreaded);
+    bool isValid(const Entry &entry) const;
+    static bool contains(const Entry &entry,
+                         const std::vector<float> &lower_boundary,
+                         const std::vector<float> &upper_boundary);
+    static double getOverlap(const std::vector<float> &lower_boundary,
+                             const std::vector<float> &upper_boundary,
+                             const std::vector<float> &data_lower,
+                             const std::vector<float> &data_upper,
+                             const Entry &entry);
+    void getDataBounds(std::vector<float> &data_lower,
+                       std::vector<float> &data_upper) const;
+    static void getRemainder(const std::vector<float> &lower_boundary,
+                             const std::vector<float> &upper_boundary,
+                             const Entry &entry,
+                             std::vector<std::vector<float> > &lower_boundaries,
+                             std::vector<std::vector<float> > &upper_boundaries);
+    static void filterEntry(const Entry &entry,
+                            const std::vector<float> &lower_boundary,
+                            const std::vector<float> &upper_boundary,
+                            std::vector<uint32_t> &tids,
+                            std::vector<float> *objects);
+    void searchTree(const std::vector<float> &lower_boundary,
+                    const std::vector<float> &upper_boundary,
+                    const bool multithreaded,
+                    std::vector<uint32_t> &tids,
+                    std::vector<float> &objects);
+    void insert(const std::vector<float> &lower_boundary,
+                const std::vector<float> &upper_boundary,
+                std::vector<uint32_t> &tids,
+                std::vector<float> &objects);
+};
+
+#endif
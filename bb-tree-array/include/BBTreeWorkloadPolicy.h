@@ -0,0 +1,86 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREEWORKLOADPOLICY
+#define BBTREEWORKLOADPOLICY
+#pragma once
+
+// Weight of a monitored query relative to the next more recent one
+#define WORKLOAD_POLICY_DECAY 0.95
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "BBTreeReplacementPolicy.h"
+
+class BBTree;
+
+/**
+ * Replacement policy for the buffer pool of a BB-Tree that uses the
+ * workload monitor of the tree instead of access recency alone.
+ *
+ * The score of a bucket estimates how likely the next range queries read
+ * it: the sum over the monitored queries of the fraction of the bucket's
+ * zone map that the query covers, where the i'th most recent query is
+ * weighted by WORKLOAD_POLICY_DECAY^i. Scores are computed when they are
+ * first needed and afterwards decayed and extended by newly monitored
+ * queries only. A score is computed anew once the zone map of its bucket
+ * may have changed, i.e., its bucket version or the bucket directory has
+ * changed.
+ *
+ * Evict() never chooses buckets that the running range query still has to
+ * read, unless all evictable buckets are such; then it evicts the one that
+ * is read last. Otherwise, it evicts the bucket with the lowest score; ties
+ * (e.g., before any query has been monitored) are broken in LRU order.
+ *
+ * Example usage:
+ *   bbtree->SetBufferPool("/tmp/bbtree.pages", num_frames,
+ *                         new BBTreeWorkloadPolicy(*bbtree));
+ */
+class BBTreeWorkloadPolicy : public BBTreeReplacementPolicy {
+  public:
+    explicit BBTreeWorkloadPolicy(const BBTree &bbtree,
+                                  const double decay = WORKLOAD_POLICY_DECAY);
+
+    void Insert(const uint64_t key);
+    void Access(const uint64_t key);
+    void Remove(const uint64_t key);
+    bool Evict(const std::function<bool(uint64_t)> &is_evictable,
+               uint64_t &victim);
+    const char* GetName() const;
+  private:
+    const BBTree &bbtree;
+    const double decay;
+    // resident buckets, most recently used first
+    std::list<uint64_t> order;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> positions;
+    // per-bucket scores, the number of monitored queries they reflect, and
+    // the bucket versions they were computed for
+    std::vector<double> scores;
+    std::vector<size_t> scored_queries;
+    std::vector<uint64_t> scored_versions;
+    uint64_t scored_structure_version;
+    // per-bucket position at which the running range query reads it, and the
+    // sequence number of the range query (see BBTree::pending_queries) whose
+    // positions these are
+    std::vector<size_t> next_reads;
+    size_t next_reads_query;
+
+    double getScore(const size_t bucket_id);
+    double getOverlap(const size_t bucket_id, const size_t query) const;
+    void collectNextReads();
+};
+
+#endif
@@ -0,0 +1,158 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeBatchExecutor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include "BBTree.h"
+
+/**
+ * BBTreeBatchExecutor(bbtree, window_microseconds, max_queries,
+ * multithreaded) starts the dispatcher thread of an executor for the given
+ * BB-Tree. If multithreaded is set, every batch scans its buckets on the
+ * thread pool of the BB-Tree.
+ */
+BBTreeBatchExecutor::BBTreeBatchExecutor(BBTree &bbtree,
+                                         const size_t window_microseconds,
+                                         const size_t max_queries,
+                                         const bool multithreaded) :
+  bbtree(bbtree), window_microseconds(window_microseconds),
+  max_queries(max_queries), multithreaded(multithreaded), stopped(false),
+  num_batches(0), num_queries(0) {
+  this->dispatcher = std::thread(&BBTreeBatchExecutor::dispatch, this);
+}
+
+/**
+ * ~BBTreeBatchExecutor() executes the pending queries and stops the
+ * dispatcher thread.
+ */
+BBTreeBatchExecutor::~BBTreeBatchExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopped = true;
+  }
+  this->not_empty.notify_one();
+  this->dispatcher.join();
+}
+
+/**
+ * BBTreeBatchExecutor::SubmitRange(lower_boundary, upper_boundary) adds the
+ * specified range query to the current batch.
+ * It returns a future of the tids of the matching objects.
+ */
+std::future<std::vector<uint32_t> > BBTreeBatchExecutor::SubmitRange(const std::vector<float> &lower_boundary,
+                                                                     const std::vector<float> &upper_boundary) {
+  PendingQuery query;
+  query.lower_boundary = lower_boundary;
+  query.upper_boundary = upper_boundary;
+  std::future<std::vector<uint32_t> > results = query.results.get_future();
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->pending.push_back(std::move(query));
+  }
+  this->not_empty.notify_one();
+
+  return results;
+}
+
+/**
+ * BBTreeBatchExecutor::SearchRange(lower_boundary, upper_boundary) executes
+ * the specified range query as part of the current batch and waits for it.
+ * It returns the tids of the matching objects.
+ */
+std::vector<uint32_t> BBTreeBatchExecutor::SearchRange(const std::vector<float> &lower_boundary,
+                                                       const std::vector<float> &upper_boundary) {
+  return this->SubmitRange(lower_boundary, upper_boundary).get();
+}
+
+/**
+ * BBTreeBatchExecutor::GetNumberOfBatches() returns the number of batches
+ * executed so far.
+ */
+size_t BBTreeBatchExecutor::GetNumberOfBatches() const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->num_batches;
+}
+
+/**
+ * BBTreeBatchExecutor::GetNumberOfQueries() returns the number of range
+ * queries executed so far.
+ */
+size_t BBTreeBatchExecutor::GetNumberOfQueries() const {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->num_queries;
+}
+
+/**
+ * BBTreeBatchExecutor::dispatch() is the loop of the dispatcher thread. It
+ * waits for the first query of a batch, closes the batch after the window
+ * elapsed or the batch is full, and executes up to max_queries queries of
+ * it. On shutdown, it executes the remaining queries before it returns.
+ */
+void BBTreeBatchExecutor::dispatch() {
+  std::vector<PendingQuery> batch;
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true) {
+    this->not_empty.wait(lock, [this] {
+      return this->stopped || !this->pending.empty();
+    });
+    if (this->pending.empty())
+      break;
+
+    const std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::microseconds(this->window_microseconds);
+    this->not_empty.wait_until(lock, deadline, [this] {
+      return this->stopped || this->pending.size() >= this->max_queries;
+    });
+
+    // queries beyond the maximum batch size stay pending for the next batch
+    const size_t batch_size = std::min(this->pending.size(),
+                                       std::max(this->max_queries, (size_t) 1));
+    batch.insert(batch.end(),
+                 std::make_move_iterator(this->pending.begin()),
+                 std::make_move_iterator(this->pending.begin() + batch_size));
+    this->pending.erase(this->pending.begin(),
+                        this->pending.begin() + batch_size);
+    lock.unlock();
+    this->executeBatch(batch);
+    batch.clear();
+    lock.lock();
+  }
+}
+
+/**
+ * BBTreeBatchExecutor::executeBatch(batch) executes all queries of a batch
+ * in a single traversal and a single scan of every relevant bucket, and
+ * hands the results over to the waiting clients.
+ */
+void BBTreeBatchExecutor::executeBatch(std::vector<PendingQuery> &batch) {
+  std::vector<std::vector<float> > lower_boundaries(batch.size());
+  std::vector<std::vector<float> > upper_boundaries(batch.size());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    lower_boundaries[i].swap(batch[i].lower_boundary);
+    upper_boundaries[i].swap(batch[i].upper_boundary);
+  }
+
+  std::vector<std::vector<uint32_t> > results = this->multithreaded ?
+    this->bbtree.SearchRangesMT(lower_boundaries, upper_boundaries) :
+    this->bbtree.SearchRanges(lower_boundaries, upper_boundaries);
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->num_batches++;
+    this->num_queries += batch.size();
+  }
+  for (size_t i = 0; i < batch.size(); ++i)
+    batch[i].results.set_value(std::move(results[i]));
+}
@@ -6,390 +6,550 @@
 *  Used solely for scholastic work in course CSCE 614 for
 *  the course research project. Adaptations and additions
 *  are marked with //ADDED ... //ADDED.
-*  
+*
 *********************************************************/
 
 #include "BBTreeBucket.h"
 
+#include <algorithm>
+#include <cstring>
+#include <new>
+
 /**
- * BBTreeRegularBucket::IsRegularBucket() always returns true.
+ * BBTreeBucket::~BBTreeBucket() releases the column storage and, for
+ * superbuckets, the z buckets.
  */
-bool BBTreeRegularBucket::IsRegularBucket() const {
-  return true;
+BBTreeBucket::~BBTreeBucket() {
+  this->Clear();
 }
 
 /**
- * BBTreeRegularBucket::IsFull(max_size) returns true if the bucket holds
- * more than max_size data objects, and false if not.
+ * BBTreeBucket::IsFull(max_size) returns true if a regular bucket holds
+ * more than max_size data objects, or if the z buckets of a superbucket hold
+ * more than z * max_size data objects in total, and false if not.
  */
-bool BBTreeRegularBucket::IsFull(const size_t max_size) const {
-  return (this->data_objects.size() >= max_size);
+bool BBTreeBucket::IsFull(const size_t max_size) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      return (this->count >= (this->super_bucket->num_buckets * max_size));
+    default:
+      return (this->count >= max_size);
+  }
 }
 
 /**
- * BBTreeRegularBucket::GetObject(i) returns the i'th object of the
- * stored data objects.
+ * BBTreeBucket::GetObject(i) returns the i'th stored data object.
+ * The data objects of a superbucket are numbered bucket by bucket.
  */
-std::vector<float> BBTreeRegularBucket::GetObject(const size_t index) const {
-  return this->data_objects[index];
+std::vector<float> BBTreeBucket::GetObject(const size_t index) const {
+  size_t offset = index;
+
+  for (size_t i = 0; i < this->GetNumberOfRegularBuckets(); ++i) {
+    const BBTreeBucket &bucket = this->GetRegularBucket(i);
+    if (offset < bucket.count) {
+      std::vector<float> feature_vector(bucket.dimensions);
+      for (size_t j = 0; j < bucket.dimensions; ++j)
+        feature_vector[j] = bucket.GetValue(offset, j);
+      return feature_vector;
+    }
+    offset -= bucket.count;
+  }
+
+  assert(false);
+  return std::vector<float>();
 }
 
 /**
- * BBTreeRegularBucket::GetRandomObject() returns a random data objects.
+ * BBTreeBucket::GetRandomObject() returns a random data object.
  */
-std::vector<float> BBTreeRegularBucket::GetRandomObject() const {
-  return this->data_objects[rand() % this->count];
+std::vector<float> BBTreeBucket::GetRandomObject() const {
+  return this->GetObject(rand() % this->count);
 }
 
 /**
- * BBTreeRegularBucket::GetTid(i) returns the tid of the
- * i'th stored data object.
+ * BBTreeBucket::GetTid(i) returns the tid of the i'th stored data object.
+ * The data objects of a superbucket are numbered bucket by bucket.
  */
-uint32_t BBTreeRegularBucket::GetTid(const size_t index) const {
-  return this->tids[index];
+uint32_t BBTreeBucket::GetTid(const size_t index) const {
+  size_t offset = index;
+
+  for (size_t i = 0; i < this->GetNumberOfRegularBuckets(); ++i) {
+    const BBTreeBucket &bucket = this->GetRegularBucket(i);
+    if (offset < bucket.count)
+      return bucket.getTids()[offset];
+    offset -= bucket.count;
+  }
+
+  assert(false);
+  return 0;
 }
 
 /**
- * BBTreeRegularBucket::GetNumberOfObjects() returns the number of data objects
- * currently stored in the bucket.
+ * BBTreeBucket::GetSuperBucket() returns the superbucket representation of
+ * a superbucket, and NULL for regular buckets.
  */
-size_t BBTreeRegularBucket::GetNumberOfObjects() const {
-  return this->data_objects.size();
+BBTreeSuperBucket* BBTreeBucket::GetSuperBucket() const {
+  return this->super_bucket;
 }
 
 /**
- * BBTreeRegularBucket::GetDataObjects() returns all stored data objects.
- * Beware: For performance reasons, it returns the reference, not a copy!
+ * BBTreeBucket::reallocate(new_capacity) moves the column storage of
+ * a regular bucket to a new allocation for new_capacity data objects
+ * (plus its hash index and Bloom filter, if enabled). The allocation is
+ * aligned to a cache line, such that no Bloom filter block straddles two.
  */
-std::vector<std::vector<float> >& BBTreeRegularBucket::GetDataObjects() {
-  return this->data_objects;
+void BBTreeBucket::reallocate(const size_t new_capacity) {
+  const size_t old_capacity = this->capacity;
+  this->capacity = new_capacity;
+  const size_t bloom_words = this->filtered ?
+    this->getNumberOfBloomWords() : 0;
+  void* allocation = NULL;
+  if (posix_memalign(&allocation, BUCKET_CACHE_LINE_SIZE,
+                     (this->getBloomFilterOffset() + 2 * bloom_words) *
+                     sizeof(float)) != 0)
+    throw std::bad_alloc();
+  float* new_data = (float*) allocation;
+
+  // copy columns and tids (the tids form the last "column")
+  for (size_t j = 0; j <= this->dimensions; ++j) {
+    memcpy(new_data + j * new_capacity,
+           this->data + j * old_capacity,
+           this->count * sizeof(float));
+  }
+
+  free(this->data);
+  this->data = new_data;
+  if (this->hashed || this->filtered)
+    this->rebuildHashStructures();
 }
 
 /**
- * BBTreeRegularBucket::GetTids() returns all stored tids.
- * Beware: For performance reasons, it returns the reference, not a copy!
+ * BBTreeBucket::MaterializeRows(bitmap,tids,objects) appends the tids of all
+ * rows of a regular bucket that are set in the given selection bitmap to
+ * tids and, unless objects is NULL, their feature vectors to objects.
  */
-std::vector<uint32_t>& BBTreeRegularBucket::GetTids() {
-  return this->tids;
+void BBTreeBucket::MaterializeRows(const uint64_t *bitmap,
+                                   std::vector<uint32_t> &tids,
+                                   std::vector<float> *objects) const {
+  const uint32_t* bucket_tids = this->getTids();
+
+  for (size_t block = 0; block < this->count; block += 64) {
+    uint64_t mask = bitmap[block / 64];
+    while (mask != 0) {
+      const size_t row = block + __builtin_ctzll(mask);
+      tids.push_back(bucket_tids[row]);
+      if (objects != NULL) {
+        for (size_t j = 0; j < this->dimensions; ++j)
+          objects->push_back(this->getColumn(j)[row]);
+      }
+      mask &= mask - 1;
+    }
+  }
 }
 
 /**
- * BBTreeRegularBucket::InsertObject(feature_vector, tid) inserts the given
- * data object with the given tid.
+ * BBTreeBucket::SetHashIndex(enabled) enables or disables the hash index of
+ * a regular bucket, or of all z buckets of a superbucket.
  */
-void BBTreeRegularBucket::InsertObject(const std::vector<float> feature_vector,
-                                      const uint32_t object_id) {
-  this->data_objects.push_back(feature_vector);
-  this->tids.push_back(object_id);
-  this->count++;
+void BBTreeBucket::SetHashIndex(const bool enabled) {
+  if (this->hashed == enabled)
+    return;
+  this->hashed = enabled;
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i)
+        this->super_bucket->buckets[i].SetHashIndex(enabled);
+      break;
+    default:
+      // allocate or release the hash index slots
+      if (this->data != NULL)
+        this->reallocate(this->capacity);
+  }
 }
 
 /**
- * BBTreeRegularBucket::BulkInsert(feature_vectors, tids) inserts the given
- * data objects with the given tids.
+ * BBTreeBucket::SetBloomFilter(enabled) enables or disables the Bloom filter
+ * of a regular bucket, or of all z buckets of a superbucket.
  */
-void BBTreeRegularBucket::BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
-                                    const std::vector<uint32_t> &object_ids,
-                                    const size_t start,
-                                    const size_t end) {
-  this->count = end - start;
-  this->data_objects.insert(this->data_objects.end(),
-                            feature_vectors.begin() + start,
-                            feature_vectors.begin() + end);
-  this->tids.insert(this->tids.end(),
-                    object_ids.begin() + start,
-                    object_ids.begin() + end);
+void BBTreeBucket::SetBloomFilter(const bool enabled) {
+  if (this->filtered == enabled)
+    return;
+  this->filtered = enabled;
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      for (size_t i = 0; i < this->super_bucket->num_buckets; ++i)
+        this->super_bucket->buckets[i].SetBloomFilter(enabled);
+      break;
+    default:
+      // allocate or release the Bloom filter
+      if (this->data != NULL)
+        this->reallocate(this->capacity);
+  }
 }
 
 /**
- * BBTreeRegularBucket::SearchObject(search_object) executes a point query.
- * It the given point query object is found, it returns its tid.
- * If no matching object is found, it returns -1.
+ * BBTreeBucket::rebuildHashStructures() clears the hash index and the Bloom
+ * filter (if enabled) of a regular bucket and inserts all data objects.
+ * Deleted data objects remain in the Bloom filter until it is rebuilt.
  */
-int32_t BBTreeRegularBucket::SearchObject(const std::vector<float> &search_object) const {
-  bool match;
-
+void BBTreeBucket::rebuildHashStructures() {
+  if (this->hashed) {
+    memset(this->getHashSlots(), 0,
+           (this->getHashMask() + 1) * sizeof(uint32_t));
+  }
+  if (this->filtered) {
+    memset(this->getBloomFilter(), 0,
+           this->getNumberOfBloomWords() * sizeof(uint64_t));
+  }
   for (size_t i = 0; i < this->count; ++i) {
-    match = true;
-    for (size_t j = 0; j < search_object.size(); ++j) {
-      if (this->data_objects[i][j] != search_object[j]) {
-        match = false;
-        break;
-      }
-    }
-    if (match) {
-      return this->tids[i];
-    }
+    const uint32_t hash = this->hashStoredObject(i);
+    if (this->hashed)
+      this->insertIntoHashIndex(i, hash);
+    if (this->filtered)
+      this->addToBloomFilter(hash);
   }
-
-  return -1;
 }
 
 /**
- * BBTreeRegularBucket::SearchRange(results,lower_bounds,upper_bounds) executes
- * a range query and stores the tids of all matching data objects in the given
- * std::vector results.
+ * BBTreeBucket::insertIntoHashIndex(i, hash) adds the i'th data object of
+ * a regular bucket, which has the given hash, to its hash index (linear
+ * probing).
  */
-void BBTreeRegularBucket::SearchRange(std::vector<uint32_t> &results,
-                                     const std::vector<float> &lower_boundary,
-                                     const std::vector<float> &upper_boundary) {
-  bool match;
-
-  for (size_t i = 0; i < this->count; ++i) {
-    match = true;
-    for (size_t j = 0; j < lower_boundary.size(); ++j) {
-      if (this->data_objects[i][j] < lower_boundary[j] ||
-          this->data_objects[i][j] > upper_boundary[j]) {
-        match = false;
-        break;
-      }
-    }
-    if (match) {
-      results.push_back(this->tids[i]);
-    }
-  }
+void BBTreeBucket::insertIntoHashIndex(const size_t index, const uint32_t hash) {
+  uint32_t* slots = this->getHashSlots();
+  const size_t mask = this->getHashMask();
+  size_t slot = hash & mask;
+  while (slots[slot] != 0)
+    slot = (slot + 1) & mask;
+  slots[slot] = index + 1;
 }
 
 /**
- * BBTreeRegularBucket::DeleteObject(feature_vector) determines if the specified
- * feature vector exists in the bucket.
- * If it exists, it deletes it and returns true. Otherwise, it returns false.
+ * BBTreeBucket::findHashSlotOfPosition(i) returns the hash index slot that
+ * refers to the i'th data object of a regular bucket.
  */
-bool BBTreeRegularBucket::DeleteObject(const std::vector<float> feature_vector) {
-  for (size_t i = 0; i < this->count; ++i) {
-    bool match = true;
-    for (size_t j = 0; j < feature_vector.size(); ++j) {
-      if (this->data_objects[i][j] != feature_vector[j]) {
-        match = false;
-        break;
-      }
-    }
-    if (match) { // data object has been found
-      this->data_objects[i] = this->data_objects.back();
-      this->tids[i] = this->tids.back();
-      this->data_objects.pop_back();
-      this->tids.pop_back();
-      this->count--;
-      return true;
-    }
-  }
-
-  // data object has not been found
-  return false;
+size_t BBTreeBucket::findHashSlotOfPosition(const size_t index) const {
+  const uint32_t* slots = this->getHashSlots();
+  const size_t mask = this->getHashMask();
+  size_t slot = this->hashStoredObject(index) & mask;
+  while (slots[slot] != index + 1)
+    slot = (slot + 1) & mask;
+  return slot;
 }
 
 /**
- * BBTreeSuperBucket::IsRegularBucket() always returns false.
+ * BBTreeBucket::eraseFromHashIndex(slot) empties the given hash index slot.
+ * It uses backward-shift deletion: following entries of the probe sequence
+ * move up unless they would move before their home slot, so no tombstones
+ * are required.
  */
-bool BBTreeSuperBucket::IsRegularBucket() const {
-  return false;
+void BBTreeBucket::eraseFromHashIndex(const size_t slot) {
+  uint32_t* slots = this->getHashSlots();
+  const size_t mask = this->getHashMask();
+  size_t hole = slot;
+  size_t next = slot;
+
+  while (true) {
+    next = (next + 1) & mask;
+    if (slots[next] == 0)
+      break;
+    const size_t home = this->hashStoredObject(slots[next] - 1) & mask;
+    // keep the entry if its home slot lies cyclically in (hole, next]
+    const bool keep = (hole <= next) ? (hole < home && home <= next) :
+                                       (hole < home || home <= next);
+    if (keep)
+      continue;
+    slots[hole] = slots[next];
+    hole = next;
+  }
+  slots[hole] = 0;
 }
 
 /**
- * BBTreeSuperBucket::IsFull(max_size) returns true if the z
- * buckets hold more than max_size data objects in total,
- * and false if not.
+ * BBTreeBucket::InsertObject(feature_vector, tid) inserts the given
+ * data object with the given tid and returns its position.
+ * Superbuckets insert it into the bucket that is chosen according to the
+ * delimiter dimension and the z-1 delimiter values.
  */
-bool BBTreeSuperBucket::IsFull(const size_t max_size) const {
-  return (this->count >= (this->num_buckets * max_size));
+uint32_t BBTreeBucket::InsertObject(const std::vector<float> &feature_vector,
+                                    const uint32_t object_id) {
+  if (this->type == BBTREE_SUPER_BUCKET) {
+    const size_t bucket_id = this->super_bucket->getBucket(feature_vector);
+    const uint32_t row = this->super_bucket->buckets[bucket_id]
+                           .InsertObject(feature_vector, object_id);
+    this->count++;
+    return (bucket_id << BUCKET_POSITION_ROW_BITS) | row;
+  }
+
+  if (this->data == NULL)
+    this->dimensions = feature_vector.size();
+  if (this->count == this->capacity) {
+    this->reallocate((this->capacity == 0) ? BUCKET_INITIAL_CAPACITY :
+                                             2 * this->capacity);
+  }
+  assert(this->count < ((uint32_t) 1 << BUCKET_POSITION_ROW_BITS));
+  for (size_t j = 0; j < this->dimensions; ++j)
+    this->data[j * this->capacity + this->count] = feature_vector[j];
+  ((uint32_t*) this->getTids())[this->count] = object_id;
+  if (this->hashed || this->filtered) {
+    const uint32_t hash = this->hashStoredObject(this->count);
+    if (this->hashed)
+      this->insertIntoHashIndex(this->count, hash);
+    if (this->filtered)
+      this->addToBloomFilter(hash);
+  }
+
+  return this->count++;
 }
 
 /**
- * BBTreeSuperBucket::GetObject(i) returns the i'th data object
- * of the first bucket.
+ * BBTreeBucket::BulkInsert(feature_vectors, tids, start, end) inserts the
+ * given data objects with the given tids.
  */
-std::vector<float> BBTreeSuperBucket::GetObject(const size_t index) const {
-  return this->data_objects[0][index];
+void BBTreeBucket::BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
+                              const std::vector<uint32_t> &object_ids,
+                              const size_t start,
+                              const size_t end) {
+  for (size_t i = start; i < end; ++i)
+    this->InsertObject(feature_vectors[i], object_ids[i]);
 }
 
 /**
- * BBTreeSuperBucket::GetRandomObject() returns a data object
- * randomly chosen from the z buckets.
+ * BBTreeBucket::DeleteObject(feature_vector) determines if the specified
+ * feature vector exists in the bucket.
+ * If it exists, it deletes it and returns true. Otherwise, it returns false.
+ * The last data object of the (sub-)bucket takes the place of the deleted one.
  */
-std::vector<float> BBTreeSuperBucket::GetRandomObject() const {
-  size_t bucket = rand() % this->num_buckets;
-  while (this->data_objects[bucket].size() == 0) {
-    bucket = rand() % this->num_buckets;
-  }
-  return this->data_objects[bucket][rand() % this->data_objects[bucket].size()];
+bool BBTreeBucket::DeleteObject(const std::vector<float> &feature_vector) {
+  const int64_t position = this->FindPosition(feature_vector);
+  if (position == -1) // data object has not been found
+    return false;
+
+  this->DeleteObjectAt((uint32_t) position);
+  return true;
 }
 
 /**
- * BBTreeSuperBucket::getTid(i) returns the tid of the i'th data object
- * of the first bucket.
+ * BBTreeBucket::FindPosition(feature_vector) returns the position of the
+ * given data object, or -1 if it is not stored.
  */
-uint32_t BBTreeSuperBucket::GetTid(const size_t index) const {
-  return this->tids[0][index];
+int64_t BBTreeBucket::FindPosition(const std::vector<float> &feature_vector) const {
+  if (this->type == BBTREE_SUPER_BUCKET) {
+    const size_t bucket_id = this->super_bucket->getBucket(feature_vector);
+    const int32_t row = this->super_bucket->buckets[bucket_id]
+                          .findObject(feature_vector);
+    return (row == -1) ? -1 :
+           (int64_t) ((bucket_id << BUCKET_POSITION_ROW_BITS) | row);
+  }
+
+  return this->findObject(feature_vector);
 }
 
 /**
- * BBTreeSuperBucket::getNumberOfObjects() gets the total number of data objects
- * stored in all z buckets.
+ * BBTreeBucket::IsValidPosition(position) returns true if a data object is
+ * stored at the given position.
  */
-size_t BBTreeSuperBucket::GetNumberOfObjects() const {
-  return this->count;
+bool BBTreeBucket::IsValidPosition(const uint32_t position) const {
+  const size_t bucket_id = position >> BUCKET_POSITION_ROW_BITS;
+  if (bucket_id >= this->GetNumberOfRegularBuckets())
+    return false;
+  return (BBTreeBucket::getPositionRow(position) <
+          this->GetRegularBucket(bucket_id).count);
 }
 
 /**
- * BBTreeSuperBucket::GetDataObjects(bucket_id) returns the data objects of the
- * bucket_id'th bucket.
- * Beware: For performance reasons it returns a reference, not a copy.
+ * BBTreeBucket::GetTidAt(position) returns the tid of the data object at the
+ * given position.
  */
-std::vector<std::vector<float> >& BBTreeSuperBucket::GetDataObjects(const size_t bucket_id) {
-  return this->data_objects[bucket_id];
+uint32_t BBTreeBucket::GetTidAt(const uint32_t position) const {
+  const BBTreeBucket &bucket =
+    this->GetRegularBucket(position >> BUCKET_POSITION_ROW_BITS);
+  return bucket.getTids()[BBTreeBucket::getPositionRow(position)];
 }
 
-
 /**
- * BBTreeSuperBucket::GetTids(bucket_id) returns the tids of the
- * bucket_id'th bucket.
- * Beware: For performance reasons it returns a reference, not a copy.
+ * BBTreeBucket::GetObjectAt(position) returns the data object at the given
+ * position.
  */
-std::vector<uint32_t>& BBTreeSuperBucket::GetTids(const size_t bucket_id) {
-  return this->tids[bucket_id];
+std::vector<float> BBTreeBucket::GetObjectAt(const uint32_t position) const {
+  const BBTreeBucket &bucket =
+    this->GetRegularBucket(position >> BUCKET_POSITION_ROW_BITS);
+  const size_t row = BBTreeBucket::getPositionRow(position);
+  std::vector<float> feature_vector(bucket.dimensions);
+  for (size_t j = 0; j < bucket.dimensions; ++j)
+    feature_vector[j] = bucket.GetValue(row, j);
+  return feature_vector;
 }
 
 /**
- * BBTreeSuperBucket::InsertObject(feature_vector, object_id) inserts
- * the given feature vector with the given tid into the super bucket.
- * The actual bucket (of the z buckets) is chosen according to the delimiter
- * dimension and the z-1 delimiter values of the superbucket.
+ * BBTreeBucket::CanUpdateAt(position, feature_vector) returns true if the data
+ * object at the given position may be replaced by the given one in place,
+ * i.e., if a superbucket would insert it into the same bucket.
  */
-void BBTreeSuperBucket::InsertObject(const std::vector<float> feature_vector,
-                                    const uint32_t object_id) {
-  const size_t bucket_id = this->getBucket(feature_vector);
-  this->data_objects[bucket_id].push_back(feature_vector);
-  this->tids[bucket_id].push_back(object_id);
-  this->count++;
+bool BBTreeBucket::CanUpdateAt(const uint32_t position,
+                               const std::vector<float> &feature_vector) const {
+  switch (this->type) {
+    case BBTREE_SUPER_BUCKET:
+      return (this->super_bucket->getBucket(feature_vector) ==
+              (position >> BUCKET_POSITION_ROW_BITS));
+    default:
+      return true;
+  }
 }
 
 /**
- * BBTreeSuperBucket::BulkInsert(feature_vectors, tids) inserts the given
- * data objects with the given tids.
+ * BBTreeBucket::UpdateObjectAt(position, feature_vector) replaces the values
+ * of the data object at the given position by the given ones; its tid and
+ * position do not change.
  */
-void BBTreeSuperBucket::BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
-                                  const std::vector<uint32_t> &object_ids,
-                                  const size_t start,
-                                  const size_t end) {
-  // TODO
+void BBTreeBucket::UpdateObjectAt(const uint32_t position,
+                                  const std::vector<float> &feature_vector) {
+  assert(this->CanUpdateAt(position, feature_vector));
+  if (this->type == BBTREE_SUPER_BUCKET) {
+    this->super_bucket->buckets[position >> BUCKET_POSITION_ROW_BITS]
+      .UpdateObjectAt(BBTreeBucket::getPositionRow(position), feature_vector);
+    return;
+  }
+
+  const size_t row = position;
+  if (this->hashed)
+    this->eraseFromHashIndex(this->findHashSlotOfPosition(row));
+  for (size_t j = 0; j < this->dimensions; ++j)
+    this->data[j * this->capacity + row] = feature_vector[j];
+  if (this->hashed || this->filtered) {
+    const uint32_t hash = this->hashStoredObject(row);
+    if (this->hashed)
+      this->insertIntoHashIndex(row, hash);
+    if (this->filtered)
+      this->addToBloomFilter(hash);
+  }
 }
 
 /**
- * BBTreeSuperBucket::SearchObject(search_objects) executes the given point query.
- * If the point query object is found, it returns its tid. Otherwise,
- * it returns -1.
+ * BBTreeBucket::DeleteObjectAt(position) deletes the data object at the given
+ * position.
+ * The last data object of the (sub-)bucket takes the place of the deleted one.
  */
-int32_t BBTreeSuperBucket::SearchObject(const std::vector<float> &search_object) const {
-  bool match;
-  const size_t bucket_id = this->getBucket(search_object);
-
-  for (size_t i = 0; i < this->data_objects[bucket_id].size(); ++i) {
-    match = true;
-    for (size_t j = 0; j < search_object.size(); ++j) {
-      if (this->data_objects[bucket_id][i][j] != search_object[j]) {
-        match = false;
-        break;
-      }
-    }
-    if (match) {
-      return this->tids[bucket_id][i];
-    }
+void BBTreeBucket::DeleteObjectAt(const uint32_t position) {
+  if (this->type == BBTREE_SUPER_BUCKET) {
+    this->super_bucket->buckets[position >> BUCKET_POSITION_ROW_BITS]
+      .DeleteObjectAt(BBTreeBucket::getPositionRow(position));
+    this->count--;
+    return;
   }
 
-  return -1;
+  const size_t index = position;
+  const size_t last = this->count - 1;
+  uint32_t* tids = (uint32_t*) this->getTids();
+  if (this->hashed) {
+    this->eraseFromHashIndex(this->findHashSlotOfPosition(index));
+    // the last data object moves to the position of the deleted one
+    if (index != last)
+      this->getHashSlots()[this->findHashSlotOfPosition(last)] = index + 1;
+  }
+  for (size_t j = 0; j < this->dimensions; ++j)
+    this->data[j * this->capacity + index] = this->data[j * this->capacity + last];
+  tids[index] = tids[last];
+  this->count--;
 }
 
 /**
- * BBTreeSuperBucket::SearchRange(results,lower_bounds,upper_bounds) executes
- * the given range query and stores all matching data objects in the
- * std::vector results.
- * It exploits the delimiter dimension and values to execute the range query
- * only on the subset of relevant buckets.
+ * BBTreeBucket::DeleteRange(lower_bounds,upper_bounds,deleted_tids) deletes
+ * all data objects that match the given range query in a single pass, which
+ * compacts the remaining data objects in place (keeping their order).
+ * Unless NULL, the tids of the deleted data objects are appended to
+ * deleted_tids. It returns the number of deleted data objects.
  */
-void BBTreeSuperBucket::SearchRange(std::vector<uint32_t> &results,
-								                   const std::vector<float> &lower_boundary,
-                                   const std::vector<float> &upper_boundary) {
-  bool match;
-  std::vector<size_t> buckets;
-
-  if (this->delimiter_values[0] >= lower_boundary[this->delimiter_dimension]) {
-    buckets.push_back(0);
-  }
-  for (size_t i = 1; i < (this->num_buckets - 2); ++i) {
-    if (this->delimiter_values[i] >= lower_boundary[this->delimiter_dimension] &&
-        this->delimiter_values[i-1] <= upper_boundary[this->delimiter_dimension]) {
-      buckets.push_back(i);
+size_t BBTreeBucket::DeleteRange(const std::vector<float> &lower_boundary,
+                                 const std::vector<float> &upper_boundary,
+                                 std::vector<uint32_t> *deleted_tids) {
+  if (this->type == BBTREE_SUPER_BUCKET) {
+    size_t deleted = 0;
+    for (size_t i = 0; i < this->super_bucket->num_buckets; ++i) {
+      if (this->super_bucket->isRelevantForRange(i, lower_boundary,
+                                                 upper_boundary)) {
+        deleted += this->super_bucket->buckets[i].DeleteRange(lower_boundary,
+                                                              upper_boundary,
+                                                              deleted_tids);
+      }
     }
-  }
-  if (this->delimiter_values[this->num_buckets - 2] <
-      upper_boundary[this->delimiter_dimension]) {
-    buckets.push_back(this->num_buckets - 1);
+    this->count -= deleted;
+    return deleted;
   }
 
-  for (size_t i = 0; i < buckets.size(); ++i) {
-    const size_t cur_bucket = buckets[i];
-    for (size_t j = 0; j < this->data_objects[cur_bucket].size(); ++j) {
-      match = true;
-      for (size_t k = 0; k < lower_boundary.size(); ++k) {
-        if (this->data_objects[cur_bucket][j][k] < lower_boundary[k] ||
-            this->data_objects[cur_bucket][j][k] > upper_boundary[k]) {
-          match = false;
-          break;
-        }
+  uint32_t* tids = (uint32_t*) this->getTids();
+  size_t kept = 0;
+  for (size_t block = 0; block < this->count; block += 64) {
+    const uint64_t mask = this->getBlockMask(block, lower_boundary,
+                                             upper_boundary);
+    const size_t block_size = (this->count - block < 64) ? (this->count - block) : 64;
+    for (size_t i = 0; i < block_size; ++i) {
+      const size_t row = block + i;
+      if ((mask >> i) & 1) {
+        if (deleted_tids != NULL)
+          deleted_tids->push_back(tids[row]);
+        continue;
       }
-      if (match) {
-        results.push_back(this->tids[cur_bucket][j]);
+      if (kept != row) {
+        for (size_t j = 0; j < this->dimensions; ++j)
+          this->data[j * this->capacity + kept] = this->data[j * this->capacity + row];
+        tids[kept] = tids[row];
       }
+      kept++;
     }
   }
-}
 
+  const size_t deleted = this->count - kept;
+  this->count = kept;
+  if (deleted > 0 && (this->hashed || this->filtered))
+    this->rebuildHashStructures();
+
+  return deleted;
+}
 
 /**
- * BBTreeSuperBucket::DeleteObject(feature_vector) deletes the given
- * feature vector from the superbucket.
- * If the feature vector has been found and deleted, it returns true.
- * Otherwise, it returns false.
+ * BBTreeBucket::MakeSuperBucket(super_bucket) turns an empty regular bucket
+ * into a superbucket that consists of the given buckets.
+ * The given buckets adopt the hash index and Bloom filter settings of the
+ * bucket.
  */
-bool BBTreeSuperBucket::DeleteObject(const std::vector<float> feature_vector) {
-  const size_t bucket_id = this->getBucket(feature_vector);
-
-  for (size_t i = 0; i < this->data_objects[bucket_id].size(); ++i) {
-    bool match = true;
-    for (size_t j = 0; j < feature_vector.size(); ++j) {
-      if (this->data_objects[bucket_id][i][j] != feature_vector[j]) {
-        match = false;
-        break;
-      }
-    }
-    if (match) { // feature vector has been found
-      this->data_objects[bucket_id][i] = this->data_objects[bucket_id].back();
-      this->tids[bucket_id][i] = this->tids[bucket_id].back();
-      this->data_objects[bucket_id].pop_back();
-      this->tids[bucket_id].pop_back();
-      this->count--;
-      return true;
-    }
+void BBTreeBucket::MakeSuperBucket(BBTreeSuperBucket *super_bucket) {
+  assert(this->count == 0);
+  this->Clear();
+  this->type = BBTREE_SUPER_BUCKET;
+  this->super_bucket = super_bucket;
+  for (size_t i = 0; i < super_bucket->num_buckets; ++i) {
+    super_bucket->buckets[i].SetHashIndex(this->hashed);
+    super_bucket->buckets[i].SetBloomFilter(this->filtered);
+    this->count += super_bucket->buckets[i].count;
   }
-
-  // feature vector has not been found
-  return false;
 }
 
 /**
- * According to the delimiter dimension and values of the superbucket,
- * BBTreeSuperBucket::getBucket(feature_vector) returns the bucket
- * relevant for the given feature vector.
+ * BBTreeBucket::Swap(other) exchanges the contents of two buckets.
  */
-inline size_t BBTreeSuperBucket::getBucket(const std::vector<float> &feature_vector) const {
-  size_t bucket_id = 0;
-  for (size_t i = 0; i < (this->num_buckets - 1); ++i) {
-    if (feature_vector[this->delimiter_dimension] <= this->delimiter_values[i]) {
-      break;
-    } else {
-      bucket_id++;
-    }
-  }
+void BBTreeBucket::Swap(BBTreeBucket &other) {
+  std::swap(this->count, other.count);
+  std::swap(this->capacity, other.capacity);
+  std::swap(this->dimensions, other.dimensions);
+  std::swap(this->type, other.type);
+  std::swap(this->hashed, other.hashed);
+  std::swap(this->filtered, other.filtered);
+  std::swap(this->data, other.data);
+  std::swap(this->super_bucket, other.super_bucket);
+}
 
-  return bucket_id;
+/**
+ * BBTreeBucket::Clear() deletes all data objects and turns the bucket into
+ * an empty regular bucket. The hash index and Bloom filter settings are
+ * kept.
+ */
+void BBTreeBucket::Clear() {
+  free(this->data);
+  delete this->super_bucket;
+  this->data = NULL;
+  this->super_bucket = NULL;
+  this->count = 0;
+  this->capacity = 0;
+  this->type = BBTREE_REGULAR_BUCKET;
 }
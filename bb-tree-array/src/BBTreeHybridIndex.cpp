@@ -0,0 +1,252 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeHybridIndex.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "BBTree.h"
+
+/**
+ * BBTreeHybridIndex(bbtree) creates a hybrid index on top of the given
+ * BB-Tree. Without a column store, all range queries use the BB-Tree.
+ */
+BBTreeHybridIndex::BBTreeHybridIndex(BBTree &bbtree) :
+  bbtree(bbtree), partitions(NULL), num_partitions(0),
+  last_access_path(BBTREE_ACCESS_TREE) {
+  for (size_t i = 0; i < HYBRID_SELECTIVITY_BINS; ++i) {
+    this->runtimes[BBTREE_ACCESS_TREE][i] = 0.0;
+    this->runtimes[BBTREE_ACCESS_SCAN][i] = 0.0;
+    this->observations[BBTREE_ACCESS_TREE][i] = 0;
+    this->observations[BBTREE_ACCESS_SCAN][i] = 0;
+  }
+}
+
+/**
+ * ~BBTreeHybridIndex() releases the column store. The BB-Tree is kept.
+ */
+BBTreeHybridIndex::~BBTreeHybridIndex() {
+  delete [] this->partitions;
+}
+
+/**
+ * BBTreeHybridIndex::SetColumnStore(enabled) (re-)builds the column-store
+ * copy of all data objects of the BB-Tree, or releases it.
+ */
+void BBTreeHybridIndex::SetColumnStore(const bool enabled) {
+  delete [] this->partitions;
+  this->partitions = NULL;
+  this->num_partitions = 0;
+  if (!enabled)
+    return;
+
+  std::vector<std::vector<float> > objects;
+  std::vector<uint32_t> tids;
+  objects.reserve(this->bbtree.getCount());
+  tids.reserve(this->bbtree.getCount());
+  for (size_t i = 0; i < this->bbtree.num_buckets; ++i) {
+    const BBTreeBucket &bucket = this->bbtree.buckets[i];
+    for (size_t z = 0; z < bucket.GetNumberOfRegularBuckets(); ++z) {
+      const BBTreeBucket &sub_bucket = bucket.GetRegularBucket(z);
+      for (size_t j = 0; j < sub_bucket.GetNumberOfObjects(); ++j) {
+        objects.push_back(sub_bucket.GetObject(j));
+        tids.push_back(sub_bucket.GetTid(j));
+      }
+    }
+  }
+
+  // at least one partition per thread
+  const size_t num_threads = std::max((size_t) 1, this->bbtree.num_threads);
+  const size_t partition_size = std::max((size_t) 1,
+    std::min((size_t) HYBRID_PARTITION_SIZE,
+             (objects.size() + num_threads - 1) / num_threads));
+  this->num_partitions = (objects.size() + partition_size - 1) / partition_size;
+  this->partitions = new BBTreeBucket[this->num_partitions];
+  for (size_t p = 0; p < this->num_partitions; ++p) {
+    const size_t start = p * partition_size;
+    const size_t end = std::min(objects.size(), start + partition_size);
+    this->partitions[p].BulkInsert(objects, tids, start, end);
+  }
+}
+
+/**
+ * BBTreeHybridIndex::SearchRange(lower_boundary, upper_boundary) executes
+ * a range query on the access path that is expected to be faster for its
+ * estimated selectivity, and records the runtime.
+ * It returns the tids of the matching objects.
+ */
+std::vector<uint32_t> BBTreeHybridIndex::SearchRange(const std::vector<float> &lower_boundary,
+                                                     const std::vector<float> &upper_boundary) {
+  const size_t count = this->bbtree.getCount();
+  const BBTreeEstimate estimate = this->bbtree.EstimateRange(lower_boundary,
+                                                             upper_boundary);
+  const size_t bin = BBTreeHybridIndex::getSelectivityBin(
+    (count == 0) ? 0.0 : estimate.rows / count);
+  this->last_access_path = this->chooseAccessPath(bin);
+
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  std::vector<uint32_t> results =
+    (this->last_access_path == BBTREE_ACCESS_SCAN) ?
+      this->SearchRangeScan(lower_boundary, upper_boundary) :
+      this->bbtree.SearchRangeMT(lower_boundary, upper_boundary);
+  this->observeRuntime(this->last_access_path, bin,
+    std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count());
+
+  return results;
+}
+
+/**
+ * BBTreeHybridIndex::SearchRangeScan(lower_boundary, upper_boundary)
+ * executes a range query by scanning all partitions of the column store
+ * in parallel (requires the column store).
+ * It returns the tids of the matching objects.
+ */
+std::vector<uint32_t> BBTreeHybridIndex::SearchRangeScan(const std::vector<float> &lower_boundary,
+                                                         const std::vector<float> &upper_boundary) {
+  assert(this->partitions != NULL);
+  std::vector<uint32_t> results;
+  const size_t num_threads = this->bbtree.num_threads;
+  // take the current thread into account
+  const size_t dop = (this->num_partitions == 0) ? 0 :
+    ((this->num_partitions < num_threads) ? this->num_partitions : num_threads) - 1;
+  const size_t partition_size = this->num_partitions / (dop + 1);
+
+  std::future<void> *futures = new std::future<void>[dop];
+  std::vector<std::vector<uint32_t> > thread_results(dop);
+  for (size_t i = 0; i < dop; ++i) {
+    futures[i] = this->bbtree.thread_pool->push(std::ref(BBTreeHybridIndex::ScanPartitions),
+                                                this,
+                                                std::ref(thread_results[i]),
+                                                std::ref(lower_boundary),
+                                                std::ref(upper_boundary),
+                                                i * partition_size,
+                                                (i+1) * partition_size);
+  }
+
+  // do something useful with this thread :-)
+  BBTreeHybridIndex::ScanPartitions(0, this, results, lower_boundary,
+                                    upper_boundary, dop * partition_size,
+                                    this->num_partitions);
+
+  // collect results from threads
+  for (size_t i = 0; i < dop; ++i) {
+    futures[i].get();
+    results.insert(std::end(results),
+                   std::begin(thread_results[i]),
+                   std::end(thread_results[i]));
+  }
+  delete [] futures;
+
+  return results;
+}
+
+/**
+ * BBTreeHybridIndex::GetLastAccessPath() returns the access path chosen for
+ * the last range query.
+ */
+BBTreeAccessPath BBTreeHybridIndex::GetLastAccessPath() const {
+  return this->last_access_path;
+}
+
+/**
+ * BBTreeHybridIndex::GetCrossover() returns the learned crossover
+ * selectivity: the scan has been observed to be faster for all classes of
+ * selectivities above it (classes without observations are skipped). It
+ * returns 1 if the BB-Tree is faster for the least selective class.
+ */
+double BBTreeHybridIndex::GetCrossover() const {
+  double crossover = 1.0;
+  for (size_t i = 0; i < HYBRID_SELECTIVITY_BINS; ++i) {
+    if (this->observations[BBTREE_ACCESS_TREE][i] < HYBRID_MIN_OBSERVATIONS ||
+        this->observations[BBTREE_ACCESS_SCAN][i] < HYBRID_MIN_OBSERVATIONS) {
+      continue;
+    }
+    if (this->runtimes[BBTREE_ACCESS_SCAN][i] >= this->runtimes[BBTREE_ACCESS_TREE][i])
+      break;
+    crossover = std::pow(2.0, -(double) (i + 1));
+  }
+  return crossover;
+}
+
+/**
+ * BBTreeHybridIndex::getSelectivityBin(selectivity) returns the class of the
+ * given selectivity: class i covers (2^-(i+1), 2^-i], and the last class all
+ * smaller selectivities.
+ */
+size_t BBTreeHybridIndex::getSelectivityBin(const double selectivity) {
+  if (selectivity <= 0.0)
+    return HYBRID_SELECTIVITY_BINS - 1;
+  const double bin = std::floor(-std::log2(selectivity));
+  if (bin <= 0.0)
+    return 0;
+  return std::min((size_t) bin, (size_t) HYBRID_SELECTIVITY_BINS - 1);
+}
+
+/**
+ * BBTreeHybridIndex::chooseAccessPath(bin) returns the access path for a range
+ * query of the given selectivity class. Both paths are tried until they have
+ * been observed HYBRID_MIN_OBSERVATIONS times; afterwards, the faster one is
+ * chosen except for every HYBRID_EXPLORE_INTERVAL'th query.
+ */
+BBTreeAccessPath BBTreeHybridIndex::chooseAccessPath(const size_t bin) const {
+  if (this->partitions == NULL)
+    return BBTREE_ACCESS_TREE;
+
+  const size_t tree_observations = this->observations[BBTREE_ACCESS_TREE][bin];
+  const size_t scan_observations = this->observations[BBTREE_ACCESS_SCAN][bin];
+  if (tree_observations < HYBRID_MIN_OBSERVATIONS)
+    return BBTREE_ACCESS_TREE;
+  if (scan_observations < HYBRID_MIN_OBSERVATIONS)
+    return BBTREE_ACCESS_SCAN;
+
+  const BBTreeAccessPath faster =
+    (this->runtimes[BBTREE_ACCESS_SCAN][bin] < this->runtimes[BBTREE_ACCESS_TREE][bin]) ?
+      BBTREE_ACCESS_SCAN : BBTREE_ACCESS_TREE;
+  if ((tree_observations + scan_observations) % HYBRID_EXPLORE_INTERVAL == 0)
+    return (faster == BBTREE_ACCESS_SCAN) ? BBTREE_ACCESS_TREE : BBTREE_ACCESS_SCAN;
+  return faster;
+}
+
+/**
+ * BBTreeHybridIndex::observeRuntime(path, bin, runtime) adds the runtime of
+ * a range query to the moving average of its access path and selectivity
+ * class.
+ */
+void BBTreeHybridIndex::observeRuntime(const BBTreeAccessPath path,
+                                       const size_t bin,
+                                       const double runtime) {
+  double &average = this->runtimes[path][bin];
+  if (this->observations[path][bin] == 0)
+    average = runtime;
+  else
+    average += HYBRID_LEARNING_RATE * (runtime - average);
+  this->observations[path][bin]++;
+}
+
+/**
+ * BBTreeHybridIndex::ScanPartitions(id,index,results,lower_bounds,upper_bounds,start,end)
+ * scans the partitions start to end of the column store with the SIMD range
+ * kernel of BBTreeBucket and stores the tids of the matching objects in the
+ * std::vector results.
+ */
+void BBTreeHybridIndex::ScanPartitions(int thread_id,
+                                       BBTreeHybridIndex *index,
+                                       std::vector<uint32_t> &results,
+                                       const std::vector<float> &lower_boundary,
+                                       const std::vector<float> &upper_boundary,
+                                       const size_t start,
+                                       const size_t end) {
+  for (size_t p = start; p < end; ++p)
+    index->partitions[p].SearchRange(results, lower_boundary, upper_boundary);
+}
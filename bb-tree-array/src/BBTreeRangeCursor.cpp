@@ -0,0 +1,125 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeRangeCursor.h"
+
+#include "BBTree.h"
+
+/**
+ * BBTreeRangeCursor(bbtree, lower_boundary, upper_boundary, with_objects,
+ * multithreaded) opens a cursor over the results of the specified range
+ * query. If with_objects is set, the batches contain the feature vectors of
+ * the matching data objects. A multi-threaded cursor starts scanning
+ * immediately.
+ */
+BBTreeRangeCursor::BBTreeRangeCursor(BBTree &bbtree,
+                                     const std::vector<float> &lower_boundary,
+                                     const std::vector<float> &upper_boundary,
+                                     const bool with_objects,
+                                     const bool multithreaded) :
+  bbtree(bbtree), lower_boundary(lower_boundary),
+  upper_boundary(upper_boundary), with_objects(with_objects),
+  multithreaded(multithreaded), next_bucket(0), active_producers(0),
+  cancelled(false) {
+  bbtree.planCursor(lower_boundary, upper_boundary, this->match_buckets);
+
+  if (this->multithreaded) {
+    const size_t num_producers = std::min(this->match_buckets.size(),
+                                          bbtree.num_threads);
+    this->active_producers = num_producers;
+    for (size_t i = 0; i < num_producers; ++i) {
+      this->producers.push_back(
+        bbtree.thread_pool->push(std::ref(BBTreeRangeCursor::Produce), this));
+    }
+  }
+}
+
+/**
+ * ~BBTreeRangeCursor() cancels the producers of a multi-threaded cursor and
+ * waits for them to finish.
+ */
+BBTreeRangeCursor::~BBTreeRangeCursor() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->cancelled = true;
+  }
+  this->not_full.notify_all();
+  for (size_t i = 0; i < this->producers.size(); ++i)
+    this->producers[i].get();
+}
+
+/**
+ * BBTreeRangeCursor::Next(batch) stores the next non-empty batch of matching
+ * data objects in batch. It returns false if all results have been returned.
+ * A multi-threaded cursor blocks until a producer has delivered a batch.
+ */
+bool BBTreeRangeCursor::Next(BBTreeResultBatch &batch) {
+  if (!this->multithreaded) {
+    while (this->next_bucket < this->match_buckets.size()) {
+      this->bbtree.scanBucketBatch(this->match_buckets[this->next_bucket++],
+                                   this->lower_boundary, this->upper_boundary,
+                                   this->with_objects, batch, this->bitmap);
+      if (!batch.tids.empty())
+        return true;
+    }
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->not_empty.wait(lock, [this] {
+    return !this->queue.empty() || this->active_producers == 0;
+  });
+  if (this->queue.empty())
+    return false;
+  std::swap(batch, this->queue.front());
+  this->queue.pop_front();
+  lock.unlock();
+  this->not_full.notify_one();
+  return true;
+}
+
+/**
+ * BBTreeRangeCursor::Produce(id, cursor) is run by the producers of
+ * a multi-threaded cursor. Producers take the next unscanned bucket, scan it
+ * and append the matches to the queue, blocking while it is full. They stop
+ * before the next bucket once the cursor has been cancelled.
+ */
+void BBTreeRangeCursor::Produce(int thread_id, BBTreeRangeCursor *cursor) {
+  BBTreeResultBatch batch;
+  std::vector<uint64_t> bitmap;
+
+  while (!cursor->cancelled) {
+    const size_t i = cursor->next_bucket++;
+    if (i >= cursor->match_buckets.size())
+      break;
+    cursor->bbtree.scanBucketBatch(cursor->match_buckets[i],
+                                   cursor->lower_boundary,
+                                   cursor->upper_boundary,
+                                   cursor->with_objects, batch, bitmap);
+    if (batch.tids.empty())
+      continue;
+
+    std::unique_lock<std::mutex> lock(cursor->mutex);
+    cursor->not_full.wait(lock, [cursor] {
+      return cursor->queue.size() < CURSOR_QUEUE_CAPACITY || cursor->cancelled;
+    });
+    if (cursor->cancelled)
+      break;
+    cursor->queue.push_back(BBTreeResultBatch());
+    std::swap(cursor->queue.back(), batch);
+    lock.unlock();
+    cursor->not_empty.notify_one();
+  }
+
+  std::lock_guard<std::mutex> lock(cursor->mutex);
+  cursor->active_producers--;
+  cursor->not_empty.notify_all();
+}
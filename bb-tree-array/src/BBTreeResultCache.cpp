@@ -0,0 +1,283 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeResultCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "BBTree.h"
+
+/**
+ * BBTreeResultCache(bbtree, policy, budget) creates an empty cache for
+ * range queries on the given BB-Tree that holds up to budget bytes of
+ * results and evicts them by the given policy.
+ */
+BBTreeResultCache::BBTreeResultCache(BBTree &bbtree,
+                                     const BBTreeCachePolicy policy,
+                                     const size_t budget) :
+  bbtree(bbtree), policy(policy), budget(budget), next_id(0), clock(0),
+  inflation(0.0), size_in_bytes(0), hits(0), misses(0) {}
+
+/**
+ * BBTreeResultCache::SearchRange(lower_boundary, upper_boundary) returns the
+ * cached result of the specified range query if it is still valid, or
+ * executes it with BBTree::SearchRange() and caches its result.
+ * It returns the tids of the matching objects.
+ */
+std::vector<uint32_t> BBTreeResultCache::SearchRange(const std::vector<float> &lower_boundary,
+                                                     const std::vector<float> &upper_boundary) {
+  return this->searchRange(lower_boundary, upper_boundary, false);
+}
+
+/**
+ * BBTreeResultCache::SearchRangeMT(lower_boundary, upper_boundary) is the
+ * same as SearchRange(), but executes cache misses with
+ * BBTree::SearchRangeMT().
+ */
+std::vector<uint32_t> BBTreeResultCache::SearchRangeMT(const std::vector<float> &lower_boundary,
+                                                       const std::vector<float> &upper_boundary) {
+  return this->searchRange(lower_boundary, upper_boundary, true);
+}
+
+/**
+ * BBTreeResultCache::Clear() drops all cached results. The statistics are
+ * kept.
+ */
+void BBTreeResultCache::Clear() {
+  this->entries.clear();
+  this->index.clear();
+  this->eviction_order.clear();
+  this->inflation = 0.0;
+  this->size_in_bytes = 0;
+}
+
+/**
+ * BBTreeResultCache::GetHits() returns the number of range queries that have
+ * been answered from the cache.
+ */
+size_t BBTreeResultCache::GetHits() const {
+  return this->hits;
+}
+
+/**
+ * BBTreeResultCache::GetMisses() returns the number of range queries that
+ * have been executed on the BB-Tree.
+ */
+size_t BBTreeResultCache::GetMisses() const {
+  return this->misses;
+}
+
+/**
+ * BBTreeResultCache::GetNumberOfEntries() returns the number of cached
+ * results.
+ */
+size_t BBTreeResultCache::GetNumberOfEntries() const {
+  return this->entries.size();
+}
+
+/**
+ * BBTreeResultCache::GetSizeInBytes() returns the total size of the cached
+ * results, which does not exceed the memory budget.
+ */
+size_t BBTreeResultCache::GetSizeInBytes() const {
+  return this->size_in_bytes;
+}
+
+/**
+ * BBTreeResultCache::searchRange(lower_bounds,upper_bounds,multithreaded)
+ * answers a range query from the cache or from the BB-Tree.
+ */
+std::vector<uint32_t> BBTreeResultCache::searchRange(const std::vector<float> &lower_boundary,
+                                                     const std::vector<float> &upper_boundary,
+                                                     const bool multithreaded) {
+  const uint64_t hash = BBTreeResultCache::getHash(lower_boundary, upper_boundary);
+  uint64_t id;
+  Entry* entry = this->lookup(hash, lower_boundary, upper_boundary, id);
+  if (entry != NULL) {
+    if (this->isValid(*entry)) {
+      this->hits++;
+      this->touch(id, *entry);
+      return entry->tids.ToVector();
+    }
+    // some bucket of the result has been modified
+    this->erase(id);
+  }
+
+  this->misses++;
+  const std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+  std::vector<uint32_t> results = multithreaded ?
+    this->bbtree.SearchRangeMT(lower_boundary, upper_boundary) :
+    this->bbtree.SearchRange(lower_boundary, upper_boundary);
+  const double cost = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+  this->insert(hash, lower_boundary, upper_boundary, results, cost);
+
+  return results;
+}
+
+/**
+ * BBTreeResultCache::getHash(lower_bounds,upper_bounds) returns the hash of
+ * the boundaries of a range query quantized to a grid of width
+ * RESULT_CACHE_QUANTUM. Boundaries outside of the grid are hashed by value.
+ */
+uint64_t BBTreeResultCache::getHash(const std::vector<float> &lower_boundary,
+                                    const std::vector<float> &upper_boundary) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < 2 * lower_boundary.size(); ++i) {
+    const float value = (i < lower_boundary.size()) ?
+      lower_boundary[i] : upper_boundary[i - lower_boundary.size()];
+    const double cell = std::floor(value / RESULT_CACHE_QUANTUM);
+    uint64_t key;
+    if (std::fabs(cell) < 9.0e15) {
+      key = (uint64_t) (int64_t) cell;
+    } else {
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      key = bits;
+    }
+    // FNV-1a-style combination followed by a 64-bit finalizer
+    hash = (hash ^ key) * 1099511628211ULL;
+    hash ^= hash >> 33;
+  }
+  return hash;
+}
+
+/**
+ * BBTreeResultCache::lookup(hash,lower_bounds,upper_bounds,id) returns the
+ * cached entry of the range query with exactly the given boundaries and
+ * stores its id, or returns NULL.
+ */
+BBTreeResultCache::Entry* BBTreeResultCache::lookup(const uint64_t hash,
+                                                    const std::vector<float> &lower_boundary,
+                                                    const std::vector<float> &upper_boundary,
+                                                    uint64_t &id) {
+  auto range = this->index.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    Entry &entry = this->entries.find(it->second)->second;
+    if (entry.lower_boundary == lower_boundary &&
+        entry.upper_boundary == upper_boundary) {
+      id = it->second;
+      return &entry;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * BBTreeResultCache::isValid(entry) returns true if neither the bucket
+ * directory nor any bucket read by the cached range query has changed.
+ */
+bool BBTreeResultCache::isValid(const Entry &entry) const {
+  if (entry.structure_version != this->bbtree.structure_version)
+    return false;
+  for (size_t i = 0; i < entry.buckets.size(); ++i) {
+    if (this->bbtree.bucket_versions[entry.buckets[i]] != entry.versions[i])
+      return false;
+  }
+  return true;
+}
+
+/**
+ * BBTreeResultCache::insert(hash,lower_bounds,upper_bounds,results,cost)
+ * caches the result of a range query and evicts other results until the
+ * memory budget is met. Results larger than the budget are not cached.
+ */
+void BBTreeResultCache::insert(const uint64_t hash,
+                               const std::vector<float> &lower_boundary,
+                               const std::vector<float> &upper_boundary,
+                               const std::vector<uint32_t> &results,
+                               const double cost) {
+  Entry entry;
+  entry.lower_boundary = lower_boundary;
+  entry.upper_boundary = upper_boundary;
+  std::vector<uint32_t> sorted_results(results);
+  std::sort(sorted_results.begin(), sorted_results.end());
+  for (size_t i = 0; i < sorted_results.size(); ++i)
+    entry.tids.Add(sorted_results[i]);
+  entry.tids.Optimize();
+  this->bbtree.planCachedResult(lower_boundary, upper_boundary, entry.buckets);
+  entry.versions.resize(entry.buckets.size());
+  for (size_t i = 0; i < entry.buckets.size(); ++i)
+    entry.versions[i] = this->bbtree.bucket_versions[entry.buckets[i]];
+  entry.structure_version = this->bbtree.structure_version;
+  entry.hash = hash;
+  entry.bytes = sizeof(Entry) + entry.tids.GetSizeInBytes() +
+                2 * lower_boundary.size() * sizeof(float) +
+                entry.buckets.size() * (sizeof(size_t) + sizeof(uint64_t));
+  entry.cost = cost;
+  entry.frequency = 1;
+  if (entry.bytes > this->budget)
+    return;
+
+  // evict results with the lowest priorities
+  while (this->size_in_bytes + entry.bytes > this->budget) {
+    const std::pair<double, uint64_t> victim = *this->eviction_order.begin();
+    if (this->policy == BBTREE_CACHE_GREEDY_DUAL)
+      this->inflation = victim.first;
+    this->erase(victim.second);
+  }
+
+  const uint64_t id = this->next_id++;
+  entry.priority = this->getPriority(entry);
+  this->size_in_bytes += entry.bytes;
+  this->eviction_order.insert(std::make_pair(entry.priority, id));
+  this->index.insert(std::make_pair(hash, id));
+  this->entries[id] = std::move(entry);
+}
+
+/**
+ * BBTreeResultCache::touch(id, entry) updates the priority of a cached
+ * result after a hit.
+ */
+void BBTreeResultCache::touch(const uint64_t id, Entry &entry) {
+  this->eviction_order.erase(std::make_pair(entry.priority, id));
+  entry.frequency++;
+  entry.priority = this->getPriority(entry);
+  this->eviction_order.insert(std::make_pair(entry.priority, id));
+}
+
+/**
+ * BBTreeResultCache::getPriority(entry) returns the priority of a cached
+ * result that has just been inserted or hit: the time of the access (LRU),
+ * the number of accesses (LFU), or the aging value plus the runtime per
+ * byte (GreedyDual-Size).
+ */
+double BBTreeResultCache::getPriority(const Entry &entry) {
+  switch (this->policy) {
+    case BBTREE_CACHE_LFU:
+      return (double) entry.frequency;
+    case BBTREE_CACHE_GREEDY_DUAL:
+      return this->inflation + entry.cost / entry.bytes;
+    default:
+      return (double) ++this->clock;
+  }
+}
+
+/**
+ * BBTreeResultCache::erase(id) drops a cached result.
+ */
+void BBTreeResultCache::erase(const uint64_t id) {
+  auto entry = this->entries.find(id);
+  auto range = this->index.equal_range(entry->second.hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == id) {
+      this->index.erase(it);
+      break;
+    }
+  }
+  this->eviction_order.erase(std::make_pair(entry->second.priority, id));
+  this->size_in_bytes -= entry->second.bytes;
+  this->entries.erase(entry);
+}
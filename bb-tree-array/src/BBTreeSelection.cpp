@@ -0,0 +1,115 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeSelection.h"
+
+/**
+ * BBTreeSelection::Count() returns the number of matching data objects.
+ */
+size_t BBTreeSelection::Count() const {
+  return this->num_matches;
+}
+
+/**
+ * BBTreeSelection::Materialize(results) appends the tids of all matching data
+ * objects to results.
+ */
+void BBTreeSelection::Materialize(std::vector<uint32_t> &results) const {
+  results.reserve(results.size() + this->num_matches);
+  this->ForEach([&results](const uint32_t tid) { results.push_back(tid); });
+}
+
+/**
+ * BBTreeSelection::ToTidSet() returns the tids of all matching data objects
+ * as a compressed tid set.
+ */
+BBTreeTidSet BBTreeSelection::ToTidSet() const {
+  BBTreeTidSet tids;
+  this->ForEach([&tids](const uint32_t tid) { tids.Add(tid); });
+  tids.Optimize();
+  return tids;
+}
+
+/**
+ * BBTreeSelection::GetSizeInBytes() returns the memory occupied by the
+ * selection bitmaps and the bucket references.
+ */
+size_t BBTreeSelection::GetSizeInBytes() const {
+  return this->words.capacity() * sizeof(uint64_t) +
+         this->entries.capacity() * sizeof(Entry);
+}
+
+/**
+ * BBTreeSelection::Clear() removes all selection bitmaps; their memory is
+ * kept for the next query.
+ */
+void BBTreeSelection::Clear() {
+  this->entries.clear();
+  this->words.clear();
+  this->num_matches = 0;
+}
+
+/**
+ * BBTreeSelection::addBucket(bucket, contained) adds a regular (sub-)bucket
+ * that has to be scanned, or whose data objects all match if contained is
+ * set. Its selection bitmap follows the bitmaps of the previous buckets.
+ */
+void BBTreeSelection::addBucket(const BBTreeBucket *bucket,
+                                const bool contained) {
+  Entry entry;
+  entry.bucket = bucket;
+  entry.offset = this->entries.empty() ? 0 :
+    this->entries.back().offset +
+    (this->entries.back().bucket->GetNumberOfObjects() + 63) / 64;
+  entry.contained = contained;
+  this->entries.push_back(entry);
+}
+
+/**
+ * BBTreeSelection::allocate() allocates the (zeroed) selection bitmaps of
+ * all added buckets.
+ */
+void BBTreeSelection::allocate() {
+  const size_t num_words = this->entries.empty() ? 0 :
+    this->entries.back().offset +
+    (this->entries.back().bucket->GetNumberOfObjects() + 63) / 64;
+  this->words.assign(num_words, 0);
+}
+
+/**
+ * BBTreeSelection::selectEntries(start, end, lower_bounds, upper_bounds)
+ * computes the selection bitmaps of the buckets start to end and returns the
+ * number of matching data objects. Different threads may compute the bitmaps
+ * of disjoint ranges of buckets.
+ */
+size_t BBTreeSelection::selectEntries(const size_t start,
+                                      const size_t end,
+                                      const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary) {
+  size_t matches = 0;
+  for (size_t i = start; i < end; ++i) {
+    const Entry &entry = this->entries[i];
+    uint64_t* words = this->words.data() + entry.offset;
+    const size_t count = entry.bucket->GetNumberOfObjects();
+    if (i + 1 < end && !this->entries[i + 1].contained)
+      this->entries[i + 1].bucket->Prefetch(false);
+    if (entry.contained) {
+      for (size_t w = 0; w < count / 64; ++w)
+        words[w] = ~((uint64_t) 0);
+      if (count % 64 != 0)
+        words[count / 64] = (((uint64_t) 1) << (count % 64)) - 1;
+      matches += count;
+    } else {
+      matches += entry.bucket->SelectRange(words, lower_boundary, upper_boundary);
+    }
+  }
+  return matches;
+}
@@ -0,0 +1,254 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeTidSet.h"
+
+#include <algorithm>
+#include <iterator>
+
+/**
+ * BBTreeTidSet::Add(tid) adds the given tid to the set.
+ * Array containers are appended to if tids arrive in ascending order;
+ * otherwise, they turn into bitmap containers. Optimize() turns sparse
+ * bitmap containers back into arrays.
+ */
+void BBTreeTidSet::Add(const uint32_t tid) {
+  Container &container = this->getContainer(tid >> 16);
+  const uint16_t low = tid & 0xFFFF;
+
+  if (!container.isBitmap()) {
+    if (container.values.empty() || container.values.back() < low) {
+      if (container.values.size() < TIDSET_ARRAY_MAX) {
+        container.values.push_back(low);
+        container.cardinality++;
+        this->cardinality++;
+        return;
+      }
+    } else if (container.values.back() == low) {
+      return;
+    }
+    BBTreeTidSet::toBitmap(container);
+  }
+
+  uint64_t &word = container.bits[low >> 6];
+  const uint64_t bit = ((uint64_t) 1) << (low & 63);
+  if ((word & bit) == 0) {
+    word |= bit;
+    container.cardinality++;
+    this->cardinality++;
+  }
+}
+
+/**
+ * BBTreeTidSet::Contains(tid) returns true if the set contains the given tid.
+ */
+bool BBTreeTidSet::Contains(const uint32_t tid) const {
+  const uint16_t key = tid >> 16;
+  const uint16_t low = tid & 0xFFFF;
+  size_t first = 0;
+  size_t last = this->containers.size();
+
+  // binary search for the container
+  while (first < last) {
+    const size_t middle = (first + last) / 2;
+    if (this->containers[middle].key < key) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  if (first == this->containers.size() || this->containers[first].key != key)
+    return false;
+
+  const Container &container = this->containers[first];
+  if (container.isBitmap())
+    return (container.bits[low >> 6] >> (low & 63)) & 1;
+  return std::binary_search(container.values.begin(), container.values.end(), low);
+}
+
+/**
+ * BBTreeTidSet::Count() returns the number of tids in the set.
+ */
+size_t BBTreeTidSet::Count() const {
+  return this->cardinality;
+}
+
+/**
+ * BBTreeTidSet::Intersect(other) returns the set of tids contained in both
+ * sets. Containers are intersected pairwise: two bitmaps by AND-ing their
+ * words, two arrays by merging, and an array with a bitmap by probing.
+ */
+BBTreeTidSet BBTreeTidSet::Intersect(const BBTreeTidSet &other) const {
+  BBTreeTidSet result;
+  size_t i = 0;
+  size_t j = 0;
+
+  while (i < this->containers.size() && j < other.containers.size()) {
+    if (this->containers[i].key < other.containers[j].key) {
+      i++;
+    } else if (this->containers[i].key > other.containers[j].key) {
+      j++;
+    } else {
+      Container container;
+      container.key = this->containers[i].key;
+      BBTreeTidSet::intersectContainers(this->containers[i],
+                                        other.containers[j],
+                                        container);
+      if (container.cardinality > 0) {
+        result.cardinality += container.cardinality;
+        result.containers.push_back(Container());
+        std::swap(result.containers.back(), container);
+      }
+      i++;
+      j++;
+    }
+  }
+
+  return result;
+}
+
+/**
+ * BBTreeTidSet::ToVector() returns all tids of the set in ascending order.
+ */
+std::vector<uint32_t> BBTreeTidSet::ToVector() const {
+  std::vector<uint32_t> tids;
+  tids.reserve(this->cardinality);
+  this->ForEach([&tids](const uint32_t tid) { tids.push_back(tid); });
+  return tids;
+}
+
+/**
+ * BBTreeTidSet::Optimize() turns bitmap containers with at most
+ * TIDSET_ARRAY_MAX tids into array containers.
+ */
+void BBTreeTidSet::Optimize() {
+  for (size_t i = 0; i < this->containers.size(); ++i) {
+    if (this->containers[i].isBitmap() &&
+        this->containers[i].cardinality <= TIDSET_ARRAY_MAX) {
+      BBTreeTidSet::toArray(this->containers[i]);
+    }
+  }
+}
+
+/**
+ * BBTreeTidSet::GetSizeInBytes() returns the memory occupied by the
+ * containers.
+ */
+size_t BBTreeTidSet::GetSizeInBytes() const {
+  size_t size = this->containers.size() * sizeof(Container);
+  for (size_t i = 0; i < this->containers.size(); ++i) {
+    size += this->containers[i].values.capacity() * sizeof(uint16_t);
+    size += this->containers[i].bits.capacity() * sizeof(uint64_t);
+  }
+  return size;
+}
+
+/**
+ * BBTreeTidSet::Clear() removes all tids.
+ */
+void BBTreeTidSet::Clear() {
+  this->containers.clear();
+  this->cardinality = 0;
+}
+
+/**
+ * BBTreeTidSet::getContainer(key) returns the container of the given key and
+ * creates an empty array container if it does not exist.
+ * Consecutive tids mostly share the container, so the last container is
+ * checked first.
+ */
+BBTreeTidSet::Container& BBTreeTidSet::getContainer(const uint16_t key) {
+  if (!this->containers.empty() && this->containers.back().key == key)
+    return this->containers.back();
+
+  size_t first = 0;
+  size_t last = this->containers.size();
+  while (first < last) {
+    const size_t middle = (first + last) / 2;
+    if (this->containers[middle].key < key) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  if (first == this->containers.size() || this->containers[first].key != key) {
+    Container container;
+    container.key = key;
+    container.cardinality = 0;
+    this->containers.insert(this->containers.begin() + first, Container());
+    std::swap(this->containers[first], container);
+  }
+
+  return this->containers[first];
+}
+
+/**
+ * BBTreeTidSet::toBitmap(container) turns an array container into a bitmap
+ * container.
+ */
+void BBTreeTidSet::toBitmap(Container &container) {
+  container.bits.assign(TIDSET_BITMAP_WORDS, 0);
+  for (size_t i = 0; i < container.values.size(); ++i) {
+    const uint16_t low = container.values[i];
+    container.bits[low >> 6] |= ((uint64_t) 1) << (low & 63);
+  }
+  std::vector<uint16_t>().swap(container.values);
+}
+
+/**
+ * BBTreeTidSet::toArray(container) turns a bitmap container into an array
+ * container.
+ */
+void BBTreeTidSet::toArray(Container &container) {
+  container.values.clear();
+  container.values.reserve(container.cardinality);
+  for (size_t w = 0; w < TIDSET_BITMAP_WORDS; ++w) {
+    uint64_t word = container.bits[w];
+    while (word != 0) {
+      container.values.push_back(w * 64 + __builtin_ctzll(word));
+      word &= word - 1;
+    }
+  }
+  std::vector<uint64_t>().swap(container.bits);
+}
+
+/**
+ * BBTreeTidSet::intersectContainers(a, b, result) stores the intersection of
+ * two containers with the same key in result.
+ */
+void BBTreeTidSet::intersectContainers(const Container &a,
+                                       const Container &b,
+                                       Container &result) {
+  result.cardinality = 0;
+  if (a.isBitmap() && b.isBitmap()) {
+    result.bits.resize(TIDSET_BITMAP_WORDS);
+    for (size_t w = 0; w < TIDSET_BITMAP_WORDS; ++w) {
+      result.bits[w] = a.bits[w] & b.bits[w];
+      result.cardinality += __builtin_popcountll(result.bits[w]);
+    }
+    if (result.cardinality <= TIDSET_ARRAY_MAX)
+      BBTreeTidSet::toArray(result);
+  } else if (!a.isBitmap() && !b.isBitmap()) {
+    std::set_intersection(a.values.begin(), a.values.end(),
+                          b.values.begin(), b.values.end(),
+                          std::back_inserter(result.values));
+    result.cardinality = result.values.size();
+  } else {
+    const Container &array = a.isBitmap() ? b : a;
+    const Container &bitmap = a.isBitmap() ? a : b;
+    for (size_t i = 0; i < array.values.size(); ++i) {
+      const uint16_t low = array.values[i];
+      if ((bitmap.bits[low >> 6] >> (low & 63)) & 1)
+        result.values.push_back(low);
+    }
+    result.cardinality = result.values.size();
+  }
+}
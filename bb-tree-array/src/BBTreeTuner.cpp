@@ -0,0 +1,296 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeTuner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "BBTreeBucket.h"
+
+/**
+ * Reads a cache size like "48K" or "32M" from sysfs and returns it in bytes.
+ * Returns 0 if the file does not exist.
+ */
+static size_t readCacheSize(const std::string &path) {
+  std::ifstream file(path.c_str());
+  size_t size = 0;
+  char unit = 0;
+
+  if (!(file >> size))
+    return 0;
+  if (file >> unit) {
+    if (unit == 'K')
+      size *= 1024;
+    else if (unit == 'M')
+      size *= 1024 * 1024;
+    else if (unit == 'G')
+      size *= 1024 * 1024 * 1024;
+  }
+
+  return size;
+}
+
+/**
+ * Derives a range query from two random samples (like the synthetic range
+ * queries of the benchmarks).
+ */
+static void getCalibrationQuery(const std::vector<std::vector<float> > &samples,
+                                std::vector<float> &lower,
+                                std::vector<float> &upper) {
+  const std::vector<float> &first = samples[rand() % samples.size()];
+  const std::vector<float> &second = samples[rand() % samples.size()];
+  for (size_t j = 0; j < lower.size(); ++j) {
+    lower[j] = std::min(first[j], second[j]);
+    upper[j] = std::max(first[j], second[j]);
+  }
+}
+
+/**
+ * BBTreeTuner::ProbeCaches() determines the sizes of the L1 data cache, the
+ * L2 cache and the last-level cache.
+ * It reads the cache topology of the first CPU from sysfs and falls back
+ * to sysconf() and finally to common default values.
+ */
+BBTreeCacheInfo BBTreeTuner::ProbeCaches() {
+  BBTreeCacheInfo info;
+  info.line_size = 0;
+  info.l1d_size = 0;
+  info.l2_size = 0;
+  info.llc_size = 0;
+
+  for (size_t i = 0; i < 8; ++i) {
+    std::ostringstream dir;
+    dir << "/sys/devices/system/cpu/cpu0/cache/index" << i << "/";
+    std::ifstream level_file((dir.str() + "level").c_str());
+    std::ifstream type_file((dir.str() + "type").c_str());
+    size_t level = 0;
+    std::string type;
+    if (!(level_file >> level) || !(type_file >> type))
+      continue;
+    if (type == "Instruction")
+      continue;
+
+    const size_t size = readCacheSize(dir.str() + "size");
+    const size_t line_size = readCacheSize(dir.str() + "coherency_line_size");
+    if (line_size > 0)
+      info.line_size = line_size;
+    if (level == 1)
+      info.l1d_size = size;
+    else if (level == 2)
+      info.l2_size = size;
+    if (level >= 2 && size > info.llc_size)
+      info.llc_size = size;
+  }
+
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+  if (info.l1d_size == 0 && sysconf(_SC_LEVEL1_DCACHE_SIZE) > 0)
+    info.l1d_size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  if (info.l2_size == 0 && sysconf(_SC_LEVEL2_CACHE_SIZE) > 0)
+    info.l2_size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (info.llc_size == 0 && sysconf(_SC_LEVEL3_CACHE_SIZE) > 0)
+    info.llc_size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+  if (info.line_size == 0 && sysconf(_SC_LEVEL1_DCACHE_LINESIZE) > 0)
+    info.line_size = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+
+  if (info.line_size == 0)
+    info.line_size = 64;
+  if (info.l1d_size == 0)
+    info.l1d_size = 32 * 1024;
+  if (info.l2_size == 0)
+    info.l2_size = 256 * 1024;
+  if (info.llc_size < info.l2_size)
+    info.llc_size = std::max((size_t) (8 * 1024 * 1024), info.l2_size);
+
+  return info;
+}
+
+/**
+ * BBTreeTuner::getCaches() returns the cache sizes used by the last call of
+ * Tune().
+ */
+const BBTreeCacheInfo& BBTreeTuner::getCaches() const {
+  return this->caches;
+}
+
+/**
+ * BBTreeTuner::Tune(samples, dimensions, count) chooses the bucket sizes and
+ * the fanout for a BB-Tree that stores count data objects distributed like
+ * the given samples.
+ *
+ * Candidate average bucket sizes are powers of two whose buckets fit into
+ * the L2 cache. For every candidate, it measures the scan cost per data
+ * object when scanning a working set of min(data size, 2 * LLC) bytes in
+ * buckets of that size, and weighs it with the fraction of data objects
+ * a query has to scan in a tree with buckets of that size.
+ * Measurements are repeated only if the dimensionality changes or the
+ * working set size changes by more than a factor of two.
+ */
+BBTreeTuning BBTreeTuner::Tune(const std::vector<std::vector<float> > &samples,
+                               const size_t dimensions,
+                               const size_t count) {
+  if (!this->probed) {
+    this->caches = BBTreeTuner::ProbeCaches();
+    this->probed = true;
+  }
+  const BBTreeCacheInfo &caches = this->caches;
+  const size_t object_size = dimensions * sizeof(float) + sizeof(uint32_t);
+  size_t working_set = std::max(count, samples.size()) * object_size;
+  working_set = std::min(working_set, 2 * caches.llc_size);
+  working_set = std::min(working_set, (size_t) TUNER_MAX_WORKING_SET);
+
+  // re-calibrate if no (comparable) measurements exist
+  if (samples.size() > 0 &&
+      (this->candidates.empty() ||
+       this->calibrated_dimensions != dimensions ||
+       working_set > 2 * this->calibrated_bytes ||
+       2 * working_set < this->calibrated_bytes)) {
+    this->candidates.clear();
+    this->ns_per_object.clear();
+    this->selectivity = this->measureSelectivity(samples);
+    for (size_t size = TUNER_MIN_BUCKET_AVG; size <= TUNER_MAX_BUCKET_AVG;
+         size *= 2) {
+      // an average bucket has to fit into the L2 cache
+      if (size > TUNER_MIN_BUCKET_AVG && size * object_size > caches.l2_size)
+        break;
+      this->candidates.push_back(size);
+      this->ns_per_object.push_back(this->calibrate(samples, size,
+                                                    working_set));
+    }
+    this->calibrated_dimensions = dimensions;
+    this->calibrated_bytes = working_set;
+  }
+
+  // calibration requires at least one sample
+  assert(!this->candidates.empty());
+
+  // a range query that covers the fraction s of a dimension intersects about
+  // s + 1/k of the children of an inner node; smaller buckets add levels and
+  // hence prune more data objects, but may scan each object more slowly
+  const size_t delimiters_per_line = caches.line_size / sizeof(float);
+  const double fanout = (double) (delimiters_per_line + 1);
+  const double level_fraction = std::min(1.0, this->selectivity + 1.0 / fanout);
+  BBTreeTuning tuning;
+  double min_cost = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < this->candidates.size(); ++i) {
+    const double levels = std::max(0.0,
+      std::log((double) count / this->candidates[i]) / std::log(fanout));
+    const double scanned = std::pow(level_fraction, levels);
+    const double cost = scanned * (this->ns_per_object[i] +
+                                   TUNER_BUCKET_OVERHEAD / this->candidates[i]);
+    // prefer smaller buckets unless a larger one is clearly cheaper
+    if (cost * TUNER_COST_TOLERANCE < min_cost) {
+      min_cost = cost;
+      tuning.bucket_avg = this->candidates[i];
+      tuning.ns_per_object = this->ns_per_object[i];
+    }
+  }
+  tuning.bucket_max = tuning.bucket_avg * TUNER_BUCKET_MAX_FACTOR;
+
+  // an inner node holds the delimiters of whole cache lines; use wider nodes
+  // if the tree would otherwise have more levels than dimensions
+  const size_t num_buckets = count / tuning.bucket_avg;
+  tuning.delimiters_per_split = delimiters_per_line;
+  for (size_t lines = 1; lines <= TUNER_MAX_NODE_LINES; lines *= 2) {
+    tuning.delimiters_per_split = lines * delimiters_per_line;
+    size_t height = 0;
+    for (size_t tmp = num_buckets; tmp > 0;
+         tmp /= (tuning.delimiters_per_split + 1)) {
+      height++;
+    }
+    if (height <= dimensions)
+      break;
+  }
+
+  return tuning;
+}
+
+/**
+ * BBTreeTuner::calibrate(samples, bucket_size, working_set) fills buckets of
+ * size bucket_size with working_set bytes of sampled data objects, scans them
+ * in random order with range queries derived from the samples, and returns
+ * the average scan time per data object in nanoseconds.
+ */
+double BBTreeTuner::calibrate(const std::vector<std::vector<float> > &samples,
+                              const size_t bucket_size,
+                              const size_t working_set) const {
+  const size_t dimensions = samples[0].size();
+  const size_t object_size = dimensions * sizeof(float) + sizeof(uint32_t);
+  const size_t num_buckets =
+    std::max((size_t) 4, working_set / (bucket_size * object_size));
+
+  std::vector<std::vector<float> > objects(bucket_size);
+  std::vector<uint32_t> tids(bucket_size);
+  BBTreeBucket* buckets = new BBTreeBucket[num_buckets];
+  for (size_t i = 0; i < num_buckets; ++i) {
+    for (size_t j = 0; j < bucket_size; ++j) {
+      objects[j] = samples[rand() % samples.size()];
+      tids[j] = (uint32_t) (i * bucket_size + j);
+    }
+    buckets[i].BulkInsert(objects, tids, 0, bucket_size);
+  }
+  std::vector<size_t> order(num_buckets);
+  for (size_t i = 0; i < num_buckets; ++i)
+    order[i] = i;
+  std::random_shuffle(order.begin(), order.end());
+
+  double elapsed = 0.0;
+  std::vector<uint32_t> results;
+  std::vector<float> lower(dimensions);
+  std::vector<float> upper(dimensions);
+  for (size_t q = 0; q < TUNER_CALIBRATION_QUERIES; ++q) {
+    getCalibrationQuery(samples, lower, upper);
+    results.clear();
+    const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_buckets; ++i)
+      buckets[order[i]].SearchRange(results, lower, upper);
+    elapsed += std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start).count();
+  }
+
+  delete [] buckets;
+
+  return elapsed / (TUNER_CALIBRATION_QUERIES * num_buckets * bucket_size);
+}
+
+/**
+ * BBTreeTuner::measureSelectivity(samples) returns the average fraction of
+ * the samples that calibration queries select in a single dimension.
+ */
+double BBTreeTuner::measureSelectivity(const std::vector<std::vector<float> > &samples) const {
+  const size_t dimensions = samples[0].size();
+  std::vector<float> lower(dimensions);
+  std::vector<float> upper(dimensions);
+  size_t matches = 0;
+
+  for (size_t q = 0; q < TUNER_CALIBRATION_QUERIES; ++q) {
+    getCalibrationQuery(samples, lower, upper);
+    for (size_t i = 0; i < samples.size(); ++i) {
+      for (size_t j = 0; j < dimensions; ++j) {
+        if (samples[i][j] >= lower[j] && samples[i][j] <= upper[j])
+          matches++;
+      }
+    }
+  }
+
+  return (double) matches /
+         (double) (TUNER_CALIBRATION_QUERIES * samples.size() * dimensions);
+}
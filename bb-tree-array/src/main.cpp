@@ -9,12 +9,15 @@
 *  
 *********************************************************/
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <sstream>
 #include <sys/time.h>
+#include <thread>
 #include <unordered_map>
 
 #include "ctpl_stl.h"
@@ -66,6 +69,54 @@ static double getstddev(double* runtimes, size_t n) {
   return std_dev;
 }
 
+// does nothing with the result of a measured operation (see measure())
+struct NoCheck {
+  template <typename Result>
+  void operator()(size_t, const Result &) const {}
+};
+
+/**
+ * Executes run(i) for i = 0, ..., n-1 and measures the runtime of every
+ * execution (in seconds multiplied by scale, e.g., 1000 for milliseconds).
+ * After every execution, check(i, result) verifies its result without being
+ * measured. Prints the mean and the standard deviation of the runtimes and
+ * returns the mean.
+ *
+ * Example:
+ * measure(rq, 1000,
+ *   [&](size_t i) { return bbtree.CountRange(lb_queries[i], ub_queries[i]); },
+ *   [&](size_t i, size_t count) { assert(count == ...); });
+ */
+template <typename Run, typename Check>
+static double measure(const size_t n, const double scale, Run run,
+                      Check check) {
+  std::vector<double> runtimes(n);
+  for (size_t i = 0; i < n; ++i) {
+    const double start = gettime();
+    const auto result = run(i);
+    runtimes[i] = (gettime() - start) * scale;
+    check(i, result);
+  }
+  const double avg = getaverage(runtimes.data(), n);
+  std::cout << "Mean: " << avg << " Standard Deviation: " <<
+               getstddev(runtimes.data(), n) << std::endl;
+
+  return avg;
+}
+
+// measure(n, scale, run) is the same as above without checking the results.
+template <typename Run>
+static double measure(const size_t n, const double scale, Run run) {
+  return measure(n, scale, run, NoCheck());
+}
+
+// sorts the tids of a query result, such that results that were collected in
+// a different order can be compared.
+static std::vector<uint32_t> sorted(std::vector<uint32_t> tids) {
+  std::sort(tids.begin(), tids.end());
+  return tids;
+}
+
 int main(int argc, char* argv[]) {
   // random seed
   srand(0);
@@ -103,6 +154,26 @@ int main(int argc, char* argv[]) {
 
   // initialize
   BBTree bbtree(m, threads);
+  // BBTREE_AUTOTUNE=1 calibrates bucket sizes and fanout for this machine
+  if (getenv("BBTREE_AUTOTUNE") != NULL)
+    bbtree.SetAutoTuning(true);
+  // BBTREE_PREFETCH=<n> prefetches n buckets ahead in range scans
+  // (0 = adaptive to the bucket size)
+  if (getenv("BBTREE_PREFETCH") != NULL)
+    bbtree.SetPrefetchDistance(atoi(getenv("BBTREE_PREFETCH")));
+  // BBTREE_HASH_INDEX=1 maintains per-bucket hash indexes for point queries
+  if (getenv("BBTREE_HASH_INDEX") != NULL)
+    bbtree.SetHashIndex(true);
+  // BBTREE_BLOOM_FILTER=1 maintains per-bucket Bloom filters for point queries
+  if (getenv("BBTREE_BLOOM_FILTER") != NULL)
+    bbtree.SetBloomFilter(true);
+  // BBTREE_TID_DIRECTORY=1 maintains the tid directory and deletes by tid
+  const bool delete_by_tid = (getenv("BBTREE_TID_DIRECTORY") != NULL);
+  bbtree.SetTidDirectory(delete_by_tid);
+  // BBTREE_TRACE=<file> appends the bucket accesses to a trace for
+  // tools/simulator
+  if (getenv("BBTREE_TRACE") != NULL)
+    bbtree.SetTrace(getenv("BBTREE_TRACE"));
 
   // load or generate data objects
   if (atoi(argv[3]) == 3) { // dataset GENOMIC
@@ -124,6 +195,29 @@ int main(int argc, char* argv[]) {
     std::vector<float>(m, std::numeric_limits<float>::max()));
   // Generate or load rq queries
   if (atoi(argv[3]) == 3) { // dataset GENOMIC
+    // gmrqb query files (e.g., ../mdrq-analysis/gmrqb-mixed.queries) hold a
+    // line of lower and a line of upper boundaries per query; min and max
+    // leave a dimension unbounded
+    if (argc >= 5) {
+      std::ifstream queries(argv[4]);
+      std::cout << "Loading queries from '" << argv[4] << "'" << std::endl;
+      std::string lower_line;
+      std::string upper_line;
+      size_t i = 0;
+      while (i < rq && std::getline(queries, lower_line) &&
+             std::getline(queries, upper_line)) {
+        std::istringstream lower_tokens(lower_line);
+        std::istringstream upper_tokens(upper_line);
+        std::string token;
+        for (size_t j = 0; j < m && lower_tokens >> token; ++j)
+          if (token != "min")
+            lb_queries[i][j] = std::stof(token);
+        for (size_t j = 0; j < m && upper_tokens >> token; ++j)
+          if (token != "max")
+            ub_queries[i][j] = std::stof(token);
+        i++;
+      }
+    }
   } else { // generate synthetic range queries
     for (size_t i = 0; i < rq; ++i) {
       int first  = rand() % n;
@@ -145,69 +239,606 @@ int main(int argc, char* argv[]) {
   // shuffle data objects to achieve a random insertion order
   std::random_shuffle(data_points.begin(), data_points.end());
 
-  double *runtimes;
-  double start;
-
   std::cout << "BB-Tree [inserts]" << std::endl;
-  runtimes = new double[n];
-  for (size_t i = 0; i < n; ++i) {
-    start = gettime();
-    bbtree.InsertObject(data_points[i], (uint32_t) (i+1));
-    runtimes[i] = (gettime() - start) * 1000000;
-  }
-  std::cout << "Mean: " << getaverage(runtimes, n) << " Standard Deviation: " <<
-               getstddev(runtimes, n) << std::endl;
-  delete runtimes;
+  measure(n, 1000000,
+    [&](size_t i) {
+      bbtree.InsertObject(data_points[i], (uint32_t) (i+1));
+      return bbtree.getCount();
+    },
+    [&](size_t i, size_t count) { assert(i+1 == count); });
+  BBTreeTuning tuning = bbtree.getTuning();
+  std::cout << "Bucket Size (avg/max): " << tuning.bucket_avg << "/" <<
+               tuning.bucket_max << " Fanout: " <<
+               (tuning.delimiters_per_split + 1) << std::endl;
 
   std::cout << "BB-Tree [point queries]" << std::endl;
-  runtimes = new double[n];
-  for (size_t i = 0; i < n; ++i) {
-    start = gettime();
-    assert((i+1) == bbtree.SearchObject(data_points[i]));
-    runtimes[i] = (gettime() - start) * 1000000;
-  }
-  std::cout << "Mean: " << getaverage(runtimes, n) << " Standard Deviation: " <<
-               getstddev(runtimes, n) << std::endl;
-  delete runtimes;
+  measure(n, 1000000,
+    [&](size_t i) { return bbtree.SearchObject(data_points[i]); },
+    [&](size_t i, uint32_t tid) { assert((i+1) == tid); });
+
+  // batches of 1024 point queries; runtimes are reported per point query
+  // (the data objects of the last, partial batch are not queried)
+  std::cout << "BB-Tree [point queries/batched]" << std::endl;
+  const size_t batch_size = 1024;
+  std::vector<std::vector<float> > batch(batch_size, std::vector<float>(m));
+  std::vector<uint32_t> batch_results;
+  measure(n / batch_size, 1000000.0 / batch_size,
+    [&](size_t b) {
+      std::copy(data_points.begin() + b * batch_size,
+                data_points.begin() + (b + 1) * batch_size, batch.begin());
+      bbtree.SearchObjectBatch(batch, batch_results);
+      return batch_results.size();
+    },
+    [&](size_t b, size_t num_results) {
+      assert(num_results == batch_size);
+      for (size_t i = 0; i < batch_size; ++i)
+        assert(b * batch_size + i + 1 == batch_results[i]);
+    });
 
   std::cout << "BB-Tree [range queries]" << std::endl;
-  runtimes = new double[rq];
-  for (size_t i = 0; i < rq; ++i) {
-    start = gettime();
-    std::vector<uint32_t> results =  bbtree.SearchRange(lb_queries[i],
-                                                       ub_queries[i]);
-    runtimes[i] = (gettime() - start) * 1000;
-  }
-  std::cout << "Mean: " << getaverage(runtimes, rq) << " Standard Deviation: " <<
-               getstddev(runtimes, rq) << std::endl;
-  delete runtimes;
+  measure(rq, 1000,
+    [&](size_t i) { return bbtree.SearchRange(lb_queries[i], ub_queries[i]); });
 
   std::cout << "BB-Tree [range queries/multithreaded]" << std::endl;
-  runtimes = new double[rq];
-  for (size_t i = 0; i < rq; ++i) {
-    start = gettime();
-    std::vector<uint32_t> results =  bbtree.SearchRangeMT(lb_queries[i],
-                                                         ub_queries[i]);
-    runtimes[i] = (gettime() - start) * 1000;
+  measure(rq, 1000,
+    [&](size_t i) { return bbtree.SearchRangeMT(lb_queries[i], ub_queries[i]); });
+
+  // only the number of matches is computed
+  std::cout << "BB-Tree [range queries/count]" << std::endl;
+  measure(rq, 1000,
+    [&](size_t i) { return bbtree.CountRange(lb_queries[i], ub_queries[i]); },
+    [&](size_t i, size_t num_results) {
+      assert(num_results == bbtree.SearchRange(lb_queries[i], ub_queries[i]).size());
+    });
+
+  std::cout << "BB-Tree [range queries/aggregate]" << std::endl;
+  measure(rq, 1000,
+    [&](size_t i) {
+      return bbtree.AggregateRange(lb_queries[i], ub_queries[i], 0);
+    },
+    [&](size_t i, const BBTreeAggregate &aggregate) {
+      assert(aggregate.count == bbtree.CountRange(lb_queries[i], ub_queries[i]));
+    });
+
+  std::cout << "BB-Tree [range queries/limit 100]" << std::endl;
+  measure(rq, 1000,
+    [&](size_t i) {
+      return bbtree.SearchRangeLimit(lb_queries[i], ub_queries[i], 100);
+    },
+    [&](size_t i, const std::vector<uint32_t> &results) {
+      assert(results.size() == std::min((size_t) 100,
+                                        bbtree.CountRange(lb_queries[i], ub_queries[i])));
+    });
+
+  std::cout << "BB-Tree [range queries/top 10 by dimension 0]" << std::endl;
+  measure(rq, 1000,
+    [&](size_t i) {
+      return bbtree.SearchRangeTopK(lb_queries[i], ub_queries[i], 0, 10);
+    },
+    [&](size_t i, const std::vector<uint32_t> &results) {
+      assert(results.size() == std::min((size_t) 10,
+                                        bbtree.CountRange(lb_queries[i], ub_queries[i])));
+    });
+
+  // the lower boundaries of the range queries serve as query objects
+  std::cout << "BB-Tree [10-NN queries]" << std::endl;
+  measure(rq, 1000,
+    [&](size_t i) {
+      return bbtree.SearchKNN(lb_queries[i], 10, BBTREE_METRIC_L2);
+    },
+    [&](size_t i, const std::vector<uint32_t> &results) {
+      assert(results == bbtree.SearchKNNMT(lb_queries[i], 10, BBTREE_METRIC_L2));
+    });
+  // the distances of the neighbors of some queries have to match a full scan
+  for (size_t i = 0; i < std::min(rq, (size_t) 5); ++i) {
+    std::vector<double> distances(n);
+    for (size_t d = 0; d < n; ++d) {
+      distances[d] = 0.0;
+      for (size_t j = 0; j < m; ++j) {
+        const double difference = (double) data_points[d][j] - lb_queries[i][j];
+        distances[d] += difference * difference;
+      }
+    }
+    const size_t k = std::min(n, (size_t) 10);
+    std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+    std::vector<uint32_t> results = bbtree.SearchKNN(lb_queries[i], 10,
+                                                     BBTREE_METRIC_L2);
+    assert(results.size() == k);
+    for (size_t r = 0; r < k; ++r) {
+      double distance = 0.0;
+      for (size_t j = 0; j < m; ++j) {
+        const double difference = (double) data_points[results[r] - 1][j] -
+                                  lb_queries[i][j];
+        distance += difference * difference;
+      }
+      assert(std::abs(distance - distances[r]) <= 1e-5 * (1.0 + distances[r]));
+    }
   }
-  std::cout << "Mean: " << getaverage(runtimes, rq) << " Standard Deviation: " <<
-               getstddev(runtimes, rq) << std::endl;
-  delete runtimes;
 
-  std::cout << "BB-Tree [deletes]" << std::endl;
-  runtimes = new double[n];
-  for (size_t i = 0; i < n; ++i) {
-    std::vector<float> object_to_delete = data_points[i];
-    assert((i+1) == bbtree.SearchObject(object_to_delete));
-    size_t old_count = bbtree.getCount();
+  std::cout << "BB-Tree [10-NN queries/multithreaded]" << std::endl;
+  measure(rq, 1000,
+    [&](size_t i) {
+      return bbtree.SearchKNNMT(lb_queries[i], 10, BBTREE_METRIC_L2);
+    });
+
+  std::cout << "BB-Tree [fixed-radius queries]" << std::endl;
+  measure(rq, 1000,
+    [&](size_t i) { return bbtree.SearchFixedRadiusNN(lb_queries[i], 0.25); },
+    [&](size_t i, const std::vector<uint32_t> &results) {
+      assert(results.size() ==
+             bbtree.SearchFixedRadiusNNMT(lb_queries[i], 0.25, BBTREE_METRIC_L2).size());
+    });
+
+  std::cout << "BB-Tree [fixed-radius queries/multithreaded]" << std::endl;
+  measure(rq, 1000,
+    [&](size_t i) {
+      return bbtree.SearchFixedRadiusNNMT(lb_queries[i], 0.25, BBTREE_METRIC_L2);
+    });
+
+  // batches of 10 range queries share one traversal and one scan per bucket
+  std::cout << "BB-Tree [range queries/batches of 10]" << std::endl;
+  const size_t query_batch_size = 10;
+  std::vector<std::vector<float> > lower(query_batch_size, std::vector<float>(m));
+  std::vector<std::vector<float> > upper(query_batch_size, std::vector<float>(m));
+  measure(rq / query_batch_size, 1000.0 / query_batch_size,
+    [&](size_t i) {
+      std::copy(lb_queries.begin() + i * query_batch_size,
+                lb_queries.begin() + (i + 1) * query_batch_size, lower.begin());
+      std::copy(ub_queries.begin() + i * query_batch_size,
+                ub_queries.begin() + (i + 1) * query_batch_size, upper.begin());
+      return bbtree.SearchRanges(lower, upper);
+    },
+    [&](size_t i, const std::vector<std::vector<uint32_t> > &results) {
+      assert(results.size() == query_batch_size);
+      for (size_t j = 0; j < query_batch_size; ++j) {
+        const size_t q = i * query_batch_size + j;
+        assert(sorted(results[j]) ==
+               sorted(bbtree.SearchRange(lb_queries[q], ub_queries[q])));
+      }
+    });
+
+  // concurrent clients whose range queries are batched into shared scans
+  std::cout << "BB-Tree [range queries/8 clients/shared scans]" << std::endl;
+  {
+    const size_t num_clients = 8;
+    BBTreeBatchExecutor executor(bbtree);
+    std::vector<std::thread> clients;
+    // every client writes the results of its own queries only
+    std::vector<std::vector<uint32_t> > executor_results(rq);
+    const double start = gettime();
+    for (size_t c = 0; c < num_clients; ++c) {
+      clients.push_back(std::thread([&, c]() {
+        for (size_t i = c; i < rq; i += num_clients)
+          executor_results[i] = executor.SearchRange(lb_queries[i], ub_queries[i]);
+      }));
+    }
+    for (size_t c = 0; c < num_clients; ++c)
+      clients[c].join();
+    const double runtime = (gettime() - start) * 1000;
+    std::cout << "Mean: " << runtime / rq << " Batches: " <<
+                 executor.GetNumberOfBatches() << std::endl;
+    for (size_t i = 0; i < rq; ++i)
+      assert(sorted(executor_results[i]) ==
+             sorted(bbtree.SearchRange(lb_queries[i], ub_queries[i])));
+  }
+
+  // joins of all range queries at once and of the lower query corners
+  std::cout << "BB-Tree [box join/multithreaded]" << std::endl;
+  double start = gettime();
+  std::vector<std::pair<uint32_t, uint32_t> > join_results =
+    bbtree.JoinBoxesMT(lb_queries, ub_queries);
+  std::cout << "Runtime: " << (gettime() - start) * 1000 << " Pairs: " <<
+               join_results.size() << std::endl;
+
+  // the pairs of the first boxes have to match a nested loop over the data
+  const size_t num_checked_joins = std::min(rq, (size_t) 10);
+  {
+    std::vector<std::vector<uint32_t> > box_tids(num_checked_joins);
+    for (size_t r = 0; r < join_results.size(); ++r)
+      if (join_results[r].first < num_checked_joins)
+        box_tids[join_results[r].first].push_back(join_results[r].second);
+    for (size_t b = 0; b < num_checked_joins; ++b) {
+      std::vector<uint32_t> expected;
+      for (size_t d = 0; d < n; ++d) {
+        bool inside = true;
+        for (size_t j = 0; j < m && inside; ++j)
+          inside = (data_points[d][j] >= lb_queries[b][j] &&
+                    data_points[d][j] <= ub_queries[b][j]);
+        if (inside)
+          expected.push_back(d + 1);
+      }
+      assert(sorted(box_tids[b]) == expected);
+    }
+  }
+
+  std::cout << "BB-Tree [epsilon-distance join/multithreaded]" << std::endl;
+  {
+    const float epsilon = 0.05;
+    BBTree probe(m, threads);
+    for (size_t i = 0; i < rq; ++i)
+      probe.InsertObject(lb_queries[i], i);
     start = gettime();
-    assert(true == bbtree.DeleteObject(object_to_delete));
-    runtimes[i] = (gettime() - start) * 1000000;
-    assert(old_count-1 == bbtree.getCount());
+    join_results = bbtree.JoinDistanceMT(probe, epsilon, BBTREE_METRIC_L2);
+    std::cout << "Runtime: " << (gettime() - start) * 1000 << " Pairs: " <<
+                 join_results.size() << std::endl;
+
+    // the pairs of the first probes have to match a nested loop over the
+    // data; distances within rounding errors of epsilon may go either way
+    std::vector<std::vector<uint32_t> > probe_tids(num_checked_joins);
+    for (size_t r = 0; r < join_results.size(); ++r)
+      if (join_results[r].second < num_checked_joins)
+        probe_tids[join_results[r].second].push_back(join_results[r].first);
+    const double max_distance = (double) epsilon * epsilon;
+    for (size_t p = 0; p < num_checked_joins; ++p) {
+      std::vector<double> distances(n, 0.0);
+      for (size_t d = 0; d < n; ++d) {
+        for (size_t j = 0; j < m; ++j) {
+          const double difference = (double) data_points[d][j] - lb_queries[p][j];
+          distances[d] += difference * difference;
+        }
+      }
+      const std::vector<uint32_t> tids = sorted(probe_tids[p]);
+      assert(std::adjacent_find(tids.begin(), tids.end()) == tids.end());
+      for (size_t r = 0; r < tids.size(); ++r)
+        assert(distances[tids[r] - 1] <= max_distance * (1 + 1e-5));
+      for (size_t d = 0; d < n; ++d)
+        if (distances[d] < max_distance * (1 - 1e-5))
+          assert(std::binary_search(tids.begin(), tids.end(), d + 1));
+    }
+  }
+
+  // estimates are compared against the actual result sizes (q-error)
+  std::cout << "BB-Tree [range estimates]" << std::endl;
+  std::vector<double> q_errors(rq);
+  double estimated_buckets = 0;
+  measure(rq, 1000000,
+    [&](size_t i) { return bbtree.EstimateRange(lb_queries[i], ub_queries[i]); },
+    [&](size_t i, const BBTreeEstimate &estimate) {
+      const double actual = bbtree.CountRange(lb_queries[i], ub_queries[i]);
+      q_errors[i] = std::max(estimate.rows + 1, actual + 1) /
+                    std::min(estimate.rows + 1, actual + 1);
+      estimated_buckets += estimate.buckets;
+    });
+  std::sort(q_errors.begin(), q_errors.end());
+  std::cout << "Buckets: " << estimated_buckets / rq << std::endl;
+  std::cout << "Q-error: Mean: " << getaverage(q_errors.data(), rq) <<
+               " Median: " << q_errors[rq / 2] << " 95th: " <<
+               q_errors[rq * 95 / 100] << " Max: " << q_errors[rq - 1] <<
+               std::endl;
+
+  // the hybrid index learns when a column scan beats the BB-Tree
+  {
+    BBTreeHybridIndex hybrid(bbtree);
+    hybrid.SetColumnStore(true);
+
+    std::cout << "BB-Tree [range queries/column scan]" << std::endl;
+    measure(rq, 1000,
+      [&](size_t i) { return hybrid.SearchRangeScan(lb_queries[i], ub_queries[i]); },
+      [&](size_t i, const std::vector<uint32_t> &results) {
+        assert(sorted(results) ==
+               sorted(bbtree.SearchRange(lb_queries[i], ub_queries[i])));
+      });
+
+    std::cout << "BB-Tree [range queries/hybrid]" << std::endl;
+    size_t num_scans = 0;
+    measure(rq, 1000,
+      [&](size_t i) { return hybrid.SearchRange(lb_queries[i], ub_queries[i]); },
+      [&](size_t i, const std::vector<uint32_t> &results) {
+        if (hybrid.GetLastAccessPath() == BBTREE_ACCESS_SCAN)
+          num_scans++;
+        // both access paths have to return the same data objects
+        assert(sorted(results) ==
+               sorted(bbtree.SearchRange(lb_queries[i], ub_queries[i])));
+      });
+    std::cout << "Scans: " << num_scans << " Crossover: " <<
+                 hybrid.GetCrossover() << std::endl;
+  }
+
+  // repeated range queries (skewed towards the first ones) are answered
+  // from result caches with a budget that only fits a part of the results
+  {
+    const BBTreeCachePolicy policies[3] = {BBTREE_CACHE_LRU, BBTREE_CACHE_LFU,
+                                           BBTREE_CACHE_GREEDY_DUAL};
+    const char* policy_names[3] = {"lru", "lfu", "greedy-dual"};
+    const size_t num_cached_queries = 4 * rq;
+    std::vector<size_t> cached_queries(num_cached_queries);
+    for (size_t p = 0; p < 3; ++p) {
+      BBTreeResultCache cache(bbtree, policies[p], RESULT_CACHE_BUDGET / 16);
+      std::cout << "BB-Tree [range queries/result cache/" << policy_names[p] <<
+                   "]" << std::endl;
+      for (size_t i = 0; i < num_cached_queries; ++i)
+        cached_queries[i] = rand() % (1 + rand() % rq);
+      measure(num_cached_queries, 1000,
+        [&](size_t i) {
+          const size_t q = cached_queries[i];
+          return cache.SearchRangeMT(lb_queries[q], ub_queries[q]);
+        },
+        [&](size_t i, const std::vector<uint32_t> &results) {
+          const size_t q = cached_queries[i];
+          assert(results.size() == bbtree.CountRange(lb_queries[q], ub_queries[q]));
+        });
+      std::cout << "Hit ratio: " << (double) cache.GetHits() / num_cached_queries <<
+                   " Bytes: " << cache.GetSizeInBytes() << std::endl;
+    }
+  }
+
+  // every range query is refined by narrowing it three times and by shifting
+  // it in one dimension, as in an interactive analysis session
+  {
+    BBTreeSemanticCache semantic_cache(bbtree);
+    const size_t num_refined_queries = 5 * rq;
+    std::vector<std::vector<float> > lower_boundaries(num_refined_queries);
+    std::vector<std::vector<float> > upper_boundaries(num_refined_queries);
+    for (size_t i = 0; i < num_refined_queries; ++i) {
+      const size_t q = i / 5;
+      const size_t step = i % 5;
+      lower_boundaries[i] = lb_queries[q];
+      upper_boundaries[i] = ub_queries[q];
+      for (size_t j = 0; j < m; ++j) {
+        const float width = ub_queries[q][j] - lb_queries[q][j];
+        if (step == 4) {
+          if (j == q % m) {
+            lower_boundaries[i][j] += 0.25f * width;
+            upper_boundaries[i][j] += 0.25f * width;
+          }
+        } else {
+          lower_boundaries[i][j] += 0.1f * step * width;
+          upper_boundaries[i][j] -= 0.1f * step * width;
+        }
+      }
+    }
+    std::cout << "BB-Tree [range queries/semantic cache]" << std::endl;
+    measure(num_refined_queries, 1000,
+      [&](size_t i) {
+        return semantic_cache.SearchRangeMT(lower_boundaries[i], upper_boundaries[i]);
+      },
+      [&](size_t i, const std::vector<uint32_t> &results) {
+        assert(results.size() == bbtree.CountRange(lower_boundaries[i],
+                                                   upper_boundaries[i]));
+      });
+    std::cout << "Hit ratio: " << (double) semantic_cache.GetHits() / num_refined_queries <<
+                 " Partial hit ratio: " << (double) semantic_cache.GetPartialHits() / num_refined_queries <<
+                 std::endl;
+  }
+
+  // the buckets are moved into a file, of which only a few are kept
+  // resident, and the skewed range queries are repeated per replacement policy
+  {
+    const BBTreeReplacement replacements[6] = {BBTREE_REPLACEMENT_LRU,
+                                               BBTREE_REPLACEMENT_LFU,
+                                               BBTREE_REPLACEMENT_CLOCK,
+                                               BBTREE_REPLACEMENT_2Q,
+                                               BBTREE_REPLACEMENT_ARC,
+                                               BBTREE_REPLACEMENT_LIRS};
+    const size_t num_frames = 64;
+    const size_t num_pool_queries = 4 * rq;
+    std::vector<size_t> pool_queries(num_pool_queries);
+    // split the data objects into buckets of the average size, such that
+    // only a part of them fits into the frames
+    bbtree.RebuildDelimiters();
+    // in-memory results of the range queries, which the pooled ones have to
+    // match
+    std::vector<std::vector<uint32_t> > pool_references(rq);
+    for (size_t i = 0; i < rq; ++i)
+      pool_references[i] = sorted(bbtree.SearchRange(lb_queries[i], ub_queries[i]));
+    // the tid directory cannot be maintained while a buffer pool is set
+    bbtree.SetTidDirectory(false);
+    for (size_t p = 0; p < 6; ++p) {
+      bbtree.SetBufferPool("bbtree_buffer_pool.dat", num_frames, replacements[p]);
+      std::cout << "BB-Tree [range queries/buffer pool/" <<
+                   bbtree.GetBufferPool()->GetPolicyName() << "]" << std::endl;
+      for (size_t i = 0; i < num_pool_queries; ++i)
+        pool_queries[i] = rand() % (1 + rand() % rq);
+      measure(num_pool_queries, 1000,
+        [&](size_t i) {
+          const size_t q = pool_queries[i];
+          return bbtree.SearchRange(lb_queries[q], ub_queries[q]);
+        },
+        [&](size_t i, const std::vector<uint32_t> &results) {
+          assert(sorted(results) == pool_references[pool_queries[i]]);
+        });
+      const BBTreeBufferPool* buffer_pool = bbtree.GetBufferPool();
+      std::cout << "Hits: " << buffer_pool->GetHits() <<
+                   " Misses: " << buffer_pool->GetMisses() <<
+                   " Pages read: " << buffer_pool->GetPagesRead() << std::endl;
+    }
+
+    // copies of the first data objects are inserted into the pooled buckets
+    // under new tids, which are then split anew
+    std::cout << "BB-Tree [inserts/buffer pool]" << std::endl;
+    const size_t num_pool_inserts = n / 10;
+    measure(num_pool_inserts, 1000000,
+      [&](size_t i) {
+        bbtree.InsertObject(data_points[i], (uint32_t) (n+i+1));
+        return bbtree.getCount();
+      },
+      [&](size_t i, size_t count) { assert(n+i+1 == count); });
+    bbtree.RebuildDelimiters();
+    for (size_t i = 0; i < rq; ++i) {
+      std::vector<uint32_t> expected(pool_references[i]);
+      for (size_t r = 0; r < pool_references[i].size(); ++r)
+        if (pool_references[i][r] <= num_pool_inserts)
+          expected.push_back(n + pool_references[i][r]);
+      assert(sorted(bbtree.SearchRange(lb_queries[i], ub_queries[i])) ==
+             sorted(expected));
+    }
+    std::cout << "Pages read: " << bbtree.GetBufferPool()->GetPagesRead() <<
+                 " Pages written: " << bbtree.GetBufferPool()->GetPagesWritten() <<
+                 std::endl;
+    bbtree.DisableBufferPool();
+
+    // the copies are deleted by their tids
+    bbtree.SetTidDirectory(true);
+    for (size_t i = 0; i < num_pool_inserts; ++i)
+      assert(bbtree.DeleteByTid(n+i+1));
+    bbtree.SetTidDirectory(false);
+    assert(n == bbtree.getCount());
+    for (size_t i = 0; i < rq; ++i)
+      assert(sorted(bbtree.SearchRange(lb_queries[i], ub_queries[i])) ==
+             pool_references[i]);
   }
-  std::cout << "Mean: " << getaverage(runtimes, n) << " Standard Deviation: " <<
-               getstddev(runtimes, n) << std::endl << std::endl;
-  delete runtimes;
+
+  // mixed workload of recurring queries on hot regions and one-off queries:
+  // LRU against the replacement policy that follows the query monitor; the
+  // queries of a gmrqb file, which mixes the query types of the benchmark,
+  // are replayed in their order instead
+  {
+    const size_t num_frames = 64;
+    const size_t num_mixed_queries = 4 * rq;
+    std::vector<size_t> mixed_queries(num_mixed_queries);
+    for (size_t i = 0; i < num_mixed_queries; ++i) {
+      if (atoi(argv[3]) == 3)
+        mixed_queries[i] = i % rq;
+      else
+        mixed_queries[i] = (rand() % 3 != 0) ? rand() % (1 + rq / 10) : rand() % rq;
+    }
+    // in-memory results of the range queries, which the pooled ones have to
+    // match
+    std::vector<std::vector<uint32_t> > mixed_references(rq);
+    for (size_t i = 0; i < rq; ++i)
+      mixed_references[i] = sorted(bbtree.SearchRange(lb_queries[i], ub_queries[i]));
+    size_t misses[2];
+    for (size_t p = 0; p < 2; ++p) {
+      if (p == 0)
+        bbtree.SetBufferPool("bbtree_buffer_pool.dat", num_frames, BBTREE_REPLACEMENT_LRU);
+      else
+        bbtree.SetBufferPool("bbtree_buffer_pool.dat", num_frames, new BBTreeWorkloadPolicy(bbtree));
+      std::cout << "BB-Tree [range queries/buffer pool/mixed/" <<
+                   bbtree.GetBufferPool()->GetPolicyName() << "]" << std::endl;
+      measure(num_mixed_queries, 1000,
+        [&](size_t i) {
+          const size_t q = mixed_queries[i];
+          return bbtree.SearchRange(lb_queries[q], ub_queries[q]);
+        },
+        [&](size_t i, const std::vector<uint32_t> &results) {
+          assert(sorted(results) == mixed_references[mixed_queries[i]]);
+        });
+      const BBTreeBufferPool* buffer_pool = bbtree.GetBufferPool();
+      misses[p] = buffer_pool->GetMisses();
+      std::cout << "Hits: " << buffer_pool->GetHits() <<
+                   " Misses: " << buffer_pool->GetMisses() <<
+                   " Pages read: " << buffer_pool->GetPagesRead() << std::endl;
+    }
+    std::cout << "Miss reduction vs. LRU: " <<
+                 (misses[0] == 0 ? 0.0 : 100.0 * ((double) misses[0] - misses[1]) / misses[0]) <<
+                 "%" << std::endl;
+    bbtree.DisableBufferPool();
+    bbtree.SetTidDirectory(delete_by_tid);
+  }
+
+  // results are written into the reused buffers of a query context
+  std::cout << "BB-Tree [range queries/multithreaded/context]" << std::endl;
+  BBTreeQueryContext context;
+  measure(rq, 1000,
+    [&](size_t i) {
+      bbtree.SearchRangeMT(lb_queries[i], ub_queries[i], context);
+      return context.GetResults().size();
+    },
+    [&](size_t i, size_t num_results) {
+      assert(num_results == bbtree.SearchRange(lb_queries[i], ub_queries[i]).size());
+    });
+
+  // results are kept as selection bitmaps and only counted
+  std::cout << "BB-Tree [range queries/multithreaded/bitmap]" << std::endl;
+  BBTreeSelection selection;
+  measure(rq, 1000,
+    [&](size_t i) {
+      bbtree.SearchRangeMT(lb_queries[i], ub_queries[i], selection);
+      return selection.Count();
+    },
+    [&](size_t i, size_t num_results) {
+      assert(num_results == bbtree.SearchRange(lb_queries[i], ub_queries[i]).size());
+    });
+
+  // results are consumed bucket by bucket while the query is running
+  std::cout << "BB-Tree [range queries/multithreaded/streamed]" << std::endl;
+  std::vector<double> first_batch_runtimes(rq);
+  measure(rq, 1000,
+    [&](size_t i) {
+      size_t num_results = 0;
+      const double stream_start = gettime();
+      first_batch_runtimes[i] = 0;
+      bbtree.SearchRangeStreamMT(lb_queries[i], ub_queries[i],
+        [&](const BBTreeResultBatch &batch) {
+          if (num_results == 0)
+            first_batch_runtimes[i] = (gettime() - stream_start) * 1000;
+          num_results += batch.tids.size();
+          return true;
+        }, false);
+      return num_results;
+    },
+    [&](size_t i, size_t num_results) {
+      assert(num_results == bbtree.SearchRange(lb_queries[i], ub_queries[i]).size());
+    });
+  std::cout << "First batch: Mean: " << getaverage(first_batch_runtimes.data(), rq) <<
+               " Standard Deviation: " << getstddev(first_batch_runtimes.data(), rq) <<
+               std::endl;
+
+  std::cout << "BB-Tree [deletes]" << std::endl;
+  measure(n, 1000000,
+    [&](size_t i) {
+      return delete_by_tid ? bbtree.DeleteByTid(i+1) :
+                             bbtree.DeleteObject(data_points[i]);
+    },
+    [&](size_t i, bool deleted) {
+      assert(true == deleted);
+      assert((i+1) != bbtree.SearchObject(data_points[i]));
+      assert(n - i - 1 == bbtree.getCount());
+    });
+  std::cout << std::endl;
+
+  // range updates and deletes on the reloaded data objects
+  for (size_t i = 0; i < n; ++i)
+    bbtree.InsertObject(data_points[i], i+1);
+
+  // the updates mirror dimension 0, which moves data objects across the
+  // delimiters into other buckets; objects tracks the expected state
+  std::cout << "BB-Tree [range updates]" << std::endl;
+  std::vector<std::vector<float> > objects(data_points);
+  // matches of the next range update, counted before it is measured
+  size_t num_matches = bbtree.CountRange(lb_queries[0], ub_queries[0]);
+  measure(rq, 1000,
+    [&](size_t i) {
+      return bbtree.UpdateRange(lb_queries[i], ub_queries[i],
+        [&objects, o](uint32_t tid, std::vector<float> &feature_vector) {
+          feature_vector[0] = o - feature_vector[0];
+          objects[tid - 1] = feature_vector;
+        });
+    },
+    [&](size_t i, size_t num_updated) {
+      assert(num_updated == num_matches);
+      assert(n == bbtree.getCount());
+      if (i + 1 < rq)
+        num_matches = bbtree.CountRange(lb_queries[i + 1], ub_queries[i + 1]);
+      if (i >= 5)
+        return;
+      // compare the first updates with a full scan of the expected state
+      size_t num_expected = 0;
+      for (size_t d = 0; d < n; ++d) {
+        bool match = true;
+        for (size_t j = 0; j < m && match; ++j) {
+          match = (objects[d][j] >= lb_queries[i][j] &&
+                   objects[d][j] <= ub_queries[i][j]);
+        }
+        if (match)
+          num_expected++;
+        if (delete_by_tid)
+          assert(objects[d] == bbtree.GetObjectByTid(d+1));
+      }
+      assert(num_expected == bbtree.CountRange(lb_queries[i], ub_queries[i]));
+      assert(num_expected == bbtree.SearchRange(lb_queries[i], ub_queries[i]).size());
+    });
+
+  std::cout << "BB-Tree [range deletes]" << std::endl;
+  size_t num_deleted = 0;
+  measure(rq, 1000,
+    [&](size_t i) { return bbtree.DeleteRange(lb_queries[i], ub_queries[i]); },
+    [&](size_t i, size_t num_range_deleted) {
+      num_deleted += num_range_deleted;
+      assert(bbtree.SearchRange(lb_queries[i], ub_queries[i]).empty());
+    });
+  assert(n - num_deleted == bbtree.getCount());
+  std::cout << "Deleted: " << num_deleted << std::endl << std::endl;
 
   return 0;
 }
@@ -0,0 +1,271 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "BBTreeReplacementPolicy.h"
+
+// Default cache sizes in percent of the buckets of the largest epoch
+#define SIMULATOR_DEFAULT_SIZES {1, 5, 10, 25, 50}
+
+/**
+ * Bucket access of a trace written by BBTree::SetTrace().
+ * Bucket ids are only unique within an epoch, which ends whenever the
+ * bucket directory is replaced or a new trace starts; the key combines both.
+ */
+struct TraceAccess {
+  uint64_t key;
+  uint32_t epoch;
+  uint64_t bytes;
+};
+
+/**
+ * Hits of a replay of a trace against one cache configuration.
+ */
+struct SimulationResult {
+  size_t hits;
+  uint64_t hit_bytes;
+};
+
+/**
+ * Loads the bucket accesses of the trace at path and counts them per
+ * operation. It returns the number of epochs.
+ */
+static uint32_t loadtrace(const char* path,
+                          std::vector<TraceAccess> &accesses,
+                          std::unordered_map<char, size_t> &operations) {
+  std::ifstream trace(path);
+  if (!trace.is_open()) {
+    std::cerr << "Cannot open trace '" << path << "'" << std::endl;
+    exit(1);
+  }
+
+  uint32_t epoch = 0;
+  bool epoch_used = false;
+  std::string line;
+  while (std::getline(trace, line)) {
+    if (line.empty())
+      continue;
+    if (line[0] == 'R' || line[0] == 'T') {
+      // bucket ids of the next accesses refer to other buckets
+      if (epoch_used)
+        epoch++;
+      epoch_used = false;
+      continue;
+    }
+    std::istringstream iss(line);
+    char operation;
+    uint64_t bucket_id;
+    TraceAccess access;
+    if (!(iss >> operation >> bucket_id >> access.bytes))
+      continue;
+    access.key = (((uint64_t) epoch) << 32) | bucket_id;
+    access.epoch = epoch;
+    accesses.push_back(access);
+    operations[operation]++;
+    epoch_used = true;
+  }
+
+  return epoch_used ? epoch + 1 : epoch;
+}
+
+/**
+ * Replays the accesses against a cache of capacity buckets that evicts by
+ * the given policy. As in the buffer pool of BB-Tree, the accessed bucket is
+ * pinned while victims are chosen. The cache is emptied at every new epoch.
+ */
+static SimulationResult simulate(const std::vector<TraceAccess> &accesses,
+                                 BBTreeReplacementPolicy* policy,
+                                 const size_t capacity) {
+  SimulationResult result = {0, 0};
+  std::unordered_set<uint64_t> resident;
+  uint32_t epoch = 0;
+
+  for (size_t i = 0; i < accesses.size(); ++i) {
+    const TraceAccess &access = accesses[i];
+    if (access.epoch != epoch) {
+      for (auto it = resident.begin(); it != resident.end(); ++it)
+        policy->Remove(*it);
+      resident.clear();
+      epoch = access.epoch;
+    }
+    if (resident.count(access.key) > 0) {
+      result.hits++;
+      result.hit_bytes += access.bytes;
+      policy->Access(access.key);
+      continue;
+    }
+    resident.insert(access.key);
+    policy->Insert(access.key);
+    while (resident.size() > capacity) {
+      uint64_t victim;
+      if (!policy->Evict([&access](uint64_t key) { return key != access.key; },
+                         victim))
+        break;
+      resident.erase(victim);
+    }
+  }
+
+  return result;
+}
+
+/**
+ * Replays the accesses against a cache of capacity buckets that evicts the
+ * bucket whose next access is farthest in the future (Belady's OPT).
+ * next_accesses[i] is the position of the next access to the bucket of
+ * access i.
+ */
+static SimulationResult simulateopt(const std::vector<TraceAccess> &accesses,
+                                    const std::vector<size_t> &next_accesses,
+                                    const size_t capacity) {
+  SimulationResult result = {0, 0};
+  // resident buckets ordered by their next access
+  std::set<std::pair<size_t, uint64_t> > resident;
+  std::unordered_map<uint64_t, size_t> next_access;
+  uint32_t epoch = 0;
+
+  for (size_t i = 0; i < accesses.size(); ++i) {
+    const TraceAccess &access = accesses[i];
+    if (access.epoch != epoch) {
+      resident.clear();
+      next_access.clear();
+      epoch = access.epoch;
+    }
+    auto entry = next_access.find(access.key);
+    if (entry != next_access.end()) {
+      result.hits++;
+      result.hit_bytes += access.bytes;
+      resident.erase(std::make_pair(entry->second, access.key));
+      entry->second = next_accesses[i];
+    } else {
+      next_access[access.key] = next_accesses[i];
+    }
+    resident.insert(std::make_pair(next_accesses[i], access.key));
+    if (resident.size() > capacity) {
+      // the accessed bucket is pinned
+      auto victim = std::prev(resident.end());
+      if (victim->second == access.key)
+        victim = std::prev(victim);
+      next_access.erase(victim->second);
+      resident.erase(victim);
+    }
+  }
+
+  return result;
+}
+
+/**
+ * Replays a trace of bucket accesses (see BBTree::SetTrace()) against cache
+ * replacement policies and reports their hit ratios and byte hit ratios.
+ *
+ * Usage: simulator TRACE [SIZE ...]
+ * A SIZE is a number of buckets, or a percentage (e.g., 10%) of the
+ * buckets accessed in the epoch with the most buckets.
+ */
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " TRACE [SIZE ...]" << std::endl;
+    return 1;
+  }
+
+  std::vector<TraceAccess> accesses;
+  std::unordered_map<char, size_t> operations;
+  const uint32_t num_epochs = loadtrace(argv[1], accesses, operations);
+  uint64_t total_bytes = 0;
+  for (size_t i = 0; i < accesses.size(); ++i)
+    total_bytes += accesses[i].bytes;
+
+  // positions of the next accesses, and the buckets of the largest epoch
+  std::vector<size_t> next_accesses(accesses.size());
+  std::unordered_map<uint64_t, size_t> last_access;
+  for (size_t i = accesses.size(); i-- > 0; ) {
+    auto entry = last_access.find(accesses[i].key);
+    next_accesses[i] = (entry == last_access.end()) ?
+                       std::numeric_limits<size_t>::max() : entry->second;
+    last_access[accesses[i].key] = i;
+  }
+  std::vector<size_t> epoch_buckets(num_epochs, 0);
+  for (auto it = last_access.begin(); it != last_access.end(); ++it)
+    epoch_buckets[it->first >> 32]++;
+  size_t max_buckets = 0;
+  for (size_t i = 0; i < epoch_buckets.size(); ++i)
+    max_buckets = std::max(max_buckets, epoch_buckets[i]);
+
+  std::cout << "Trace: " << argv[1] << std::endl;
+  std::cout << "Accesses: " << accesses.size() << " (queries: " <<
+               operations['Q'] << ", inserts: " << operations['I'] <<
+               ", deletes: " << operations['D'] << ", updates: " <<
+               operations['U'] << ") Bytes: " << total_bytes << std::endl;
+  std::cout << "Epochs: " << num_epochs << " Distinct buckets: " <<
+               last_access.size() << " (max. per epoch: " << max_buckets <<
+               ")" << std::endl;
+  if (accesses.empty())
+    return 0;
+
+  std::vector<size_t> sizes;
+  for (int i = 2; i < argc; ++i) {
+    const size_t length = strlen(argv[i]);
+    if (length > 0 && argv[i][length - 1] == '%')
+      sizes.push_back((size_t) (max_buckets * atof(argv[i]) / 100.0));
+    else
+      sizes.push_back((size_t) atol(argv[i]));
+  }
+  if (sizes.empty()) {
+    const int percentages[] = SIMULATOR_DEFAULT_SIZES;
+    for (size_t i = 0; i < sizeof(percentages) / sizeof(int); ++i)
+      sizes.push_back(max_buckets * percentages[i] / 100);
+  }
+
+  const BBTreeReplacement replacements[6] = {BBTREE_REPLACEMENT_LRU,
+                                             BBTREE_REPLACEMENT_LFU,
+                                             BBTREE_REPLACEMENT_CLOCK,
+                                             BBTREE_REPLACEMENT_2Q,
+                                             BBTREE_REPLACEMENT_ARC,
+                                             BBTREE_REPLACEMENT_LIRS};
+  for (size_t s = 0; s < sizes.size(); ++s) {
+    // the accessed bucket has to fit
+    const size_t capacity = std::max(sizes[s], (size_t) 1);
+    std::cout << "Cache Size: " << capacity << " buckets" << std::endl;
+    for (size_t p = 0; p <= 6; ++p) {
+      SimulationResult result;
+      const char* policy_name;
+      if (p < 6) {
+        BBTreeReplacementPolicy* policy =
+          BBTreeReplacementPolicy::Create(replacements[p], capacity);
+        result = simulate(accesses, policy, capacity);
+        policy_name = policy->GetName();
+        delete policy;
+      } else {
+        result = simulateopt(accesses, next_accesses, capacity);
+        policy_name = "OPT";
+      }
+      std::cout << "  " << policy_name << " Hit Ratio: " <<
+                   (double) result.hits / accesses.size() <<
+                   " Byte Hit Ratio: " <<
+                   ((total_bytes > 0) ? (double) result.hit_bytes / total_bytes : 0.0) <<
+                   std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -18,9 +18,28 @@
 void BBTree::printStatistics() const {
   std::cout << "Tree Height: " << this->height << " Buckets: " <<
                this->num_buckets << std::endl;
+  std::cout << "Bucket Size (avg/max): " << this->bucket_avg << "/" <<
+               this->bucket_max << " Fanout: " <<
+               (this->delimiters_per_split + 1) <<
+               std::endl;
+  if (this->auto_tuning) {
+    std::cout << "Auto-tuned: " << this->tuned_scan_cost <<
+                 " ns per scanned object (L1d/L2/LLC: " <<
+                 this->tuner.getCaches().l1d_size / 1024 << "K/" <<
+                 this->tuner.getCaches().l2_size / 1024 << "K/" <<
+                 this->tuner.getCaches().llc_size / 1024 << "K)" << std::endl;
+  }
+  if (this->buffer_pool != NULL) {
+    std::cout << "Buffer Pool (" << this->buffer_pool->GetPolicyName() <<
+                 "): " << this->buffer_pool->GetNumberOfResidentBuckets() <<
+                 "/" << this->buffer_pool->GetNumberOfFrames() <<
+                 " resident buckets, " << this->buffer_pool->GetHits() <<
+                 " hits, " << this->buffer_pool->GetMisses() << " misses" <<
+                 std::endl;
+  }
   std::cout << "Bucket sizes:" << std::endl;
   for (size_t i = 0; i < this->num_buckets; ++i) {
-    std::cout << i << ":" << this->buckets[i]->GetNumberOfObjects() << " ";
+    std::cout << i << ":" << this->getNumberOfObjects(i) << " ";
     if (i != 0 && i % 24 == 0) {
       std::cout << std::endl;
     }
@@ -36,6 +55,65 @@ size_t BBTree::getCount() const {
   return this->count;
 }
 
+/**
+ * BBTree::SetAutoTuning(enabled) enables or disables the auto-tuning of the
+ * bucket sizes and the fanout.
+ * If enabled, BulkInsert() and every RebuildDelimiters() calibrate them for
+ * the current machine and data distribution; see BBTreeTuner.
+ */
+void BBTree::SetAutoTuning(const bool enabled) {
+  this->auto_tuning = enabled;
+}
+
+/**
+ * BBTree::getTuning() returns the bucket sizes and fanout currently in use.
+ */
+BBTreeTuning BBTree::getTuning() const {
+  BBTreeTuning tuning;
+  tuning.bucket_max = this->bucket_max;
+  tuning.bucket_avg = this->bucket_avg;
+  tuning.delimiters_per_split = this->delimiters_per_split;
+  tuning.ns_per_object = this->tuned_scan_cost;
+  return tuning;
+}
+
+/**
+ * BBTree::SetPrefetchDistance(distance) sets the number of buckets that range
+ * scans prefetch ahead of the bucket being scanned.
+ * With distance 0 (default), it adapts to the average bucket size such that
+ * about PREFETCH_LOOKAHEAD data objects are prefetched ahead.
+ */
+void BBTree::SetPrefetchDistance(const size_t distance) {
+  this->prefetch_distance = distance;
+}
+
+/**
+ * BBTree::SetHashIndex(enabled) enables or disables the hash indexes of all
+ * buckets, which map full data objects to their positions within a bucket.
+ * With hash indexes, point queries and deletes probe a constant number of
+ * slots per bucket instead of scanning it, at the cost of 8 bytes per data
+ * object and slightly slower inserts.
+ */
+void BBTree::SetHashIndex(const bool enabled) {
+  this->hash_index = enabled;
+  for (size_t i = 0; i < this->num_buckets; ++i)
+    this->buckets[i].SetHashIndex(enabled);
+}
+
+/**
+ * BBTree::SetBloomFilter(enabled) enables or disables the Bloom filters of
+ * all buckets. A point query or delete skips the scan of a bucket whose
+ * Bloom filter does not contain the data object, which makes misses cheap
+ * when several buckets are relevant due to duplicate delimiter values.
+ * Bloom filters are updated on inserts and rebuilt whenever buckets are
+ * rebuilt or transformed; deleted data objects only cause false positives.
+ */
+void BBTree::SetBloomFilter(const bool enabled) {
+  this->bloom_filter = enabled;
+  for (size_t i = 0; i < this->num_buckets; ++i)
+    this->buckets[i].SetBloomFilter(enabled);
+}
+
 /**
  * BBTree::InsertObject(feature_vector,id) inserts the data object with the
  * given identifier into the BB-Tree instance.
@@ -50,15 +128,24 @@ void BBTree::InsertObject(const std::vector<float> feature_vector,
   // get the bucket that the new data object is inserted into
   const size_t matching_bucket = this->getBucketOfFeatureVectorForInsert(feature_vector,
                                                                          false);
+  this->pinBucket(matching_bucket);
   // insert into the bucket
-  this->buckets[matching_bucket]->InsertObject(feature_vector, object_id);
+  const uint32_t position = this->buckets[matching_bucket].InsertObject(feature_vector,
+                                                                       object_id);
+  if (this->use_tid_directory)
+    this->setTidLocation(object_id, matching_bucket, position);
+  this->updateZoneMap(matching_bucket, feature_vector);
+  this->updateBucketSums(matching_bucket, feature_vector, 1.0);
   // increase global data object counter
   this->count++;
+  this->traceBucket(BBTREE_TRACE_INSERT, matching_bucket);
+  // the bucket stays resident until the next bucket is pinned
+  this->unpinBucket(matching_bucket, true);
 
   // check if bucket overflows
-  if (this->buckets[matching_bucket]->IsFull(BUCKET_MAX)) {
+  if (this->buckets[matching_bucket].IsFull(this->bucket_max)) {
     // if it is a regular bucket, try to transform it into a superbucket
-    if (this->buckets[matching_bucket]->IsRegularBucket()) {
+    if (this->buckets[matching_bucket].IsRegularBucket()) {
       // if too many superbuckets exist, invoke a rebuild
       if (this->num_super_buckets++ >
           (ALLOWED_SUPER_BUCKETS * this->num_buckets)) {
@@ -84,20 +171,46 @@ void BBTree::BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
   // do not allow bulk inserts on already built index structures
   assert(this->count == 0);
 
+  // pick bucket sizes and fanout before loading the data
+  if (this->auto_tuning) {
+    const size_t num_samples = std::max((size_t) 1,
+      (size_t) (feature_vectors.size() * REBUILD_SAMPLE_SIZE));
+    std::vector<std::vector<float> > samples(num_samples);
+    for (size_t i = 0; i < num_samples; ++i)
+      samples[i] = feature_vectors[rand() % feature_vectors.size()];
+    this->count = feature_vectors.size();
+    this->applyTuning(samples);
+  }
+
   this->count = feature_vectors.size();
   // insert batches of feature vectors into buckets
-  this->num_buckets = (feature_vectors.size() / BUCKET_MAX) + 1;
-  this->buckets = new BBTreeBucket*[this->num_buckets];
-  for (size_t i = 0; i < num_buckets; ++i)
-    this->buckets[i] = new BBTreeRegularBucket();
+  this->num_buckets = (feature_vectors.size() / this->bucket_max) + 1;
+  delete [] this->buckets;
+  delete [] this->zone_maps;
+  delete [] this->bucket_sums;
+  delete [] this->bucket_versions;
+  this->buckets = new BBTreeBucket[this->num_buckets];
+  this->zone_maps = new float[2 * this->dimensions * this->num_buckets];
+  this->bucket_sums = new double[this->dimensions * this->num_buckets];
+  this->bucket_versions = new uint64_t[this->num_buckets]();
   const size_t partition_size = feature_vectors.size() / this->num_buckets;
 
-  // batch-wise insertions
+  // batch-wise insertions; with a buffer pool, every batch is written to
+  // the bucket file right away
+  if (this->buffer_pool != NULL)
+    this->buffer_pool->BeginRebuild(this->num_buckets);
   for (size_t i = 0; i < this->num_buckets; ++i) {
+    this->configureBucket(this->buckets[i]);
     const size_t start = i * partition_size;
     const size_t end = (i == this->num_buckets - 1) ? feature_vectors.size() : ((i+1) * partition_size);
-    this->buckets[i]->BulkInsert(feature_vectors, object_ids, start, end);
+    this->buckets[i].BulkInsert(feature_vectors, object_ids, start, end);
+    if (this->buffer_pool != NULL) {
+      this->buffer_pool->AppendObjects(i, this->buckets[i]);
+      this->buckets[i].Clear();
+    }
   }
+  if (this->buffer_pool != NULL)
+    this->buffer_pool->FinishRebuild();
 
   this->RebuildDelimiters();
 }
@@ -108,49 +221,372 @@ void BBTree::BulkInsert(const std::vector<std::vector<float> > &feature_vectors,
  * It may invoke a rebuild of BB-Tree if too many sparse buckets exist.
  */
 bool BBTree::DeleteObject(const std::vector<float> &feature_vector) {
+  this->checkNoBufferPool("BBTree::DeleteObject()");
   // get the buckets that may hold the to-be-deleted data object
   std::vector<size_t> buckets = this->getBucketOfFeatureVector(feature_vector);
 
   // iterate over all relevant buckets and search for the to-be-deleted object
   for (size_t i = 0; i < buckets.size(); ++i) {
-    if (this->buckets[buckets[i]]->DeleteObject(feature_vector)) {
-      this->count--;
-      // increase the sparse buckets counter
-      if (this->buckets[buckets[i]]->GetNumberOfObjects() == 0) {
-        this->num_empty_buckets++;
-      }
-      // invoke a rebuild if too many sparse buckets exist
-      if (this->num_empty_buckets >=
-          this->num_buckets * ALLOWED_EMPTY_BUCKETS) {
-        this->RebuildDelimiters();
-      // or transform underflowing super bucket into regular bucket
-      } else if (this->buckets[buckets[i]]->IsRegularBucket() == false &&
-                 this->buckets[buckets[i]]->GetNumberOfObjects() <
-                   (BUCKET_MAX * SUPER_BUCKET_FILL_DEGREE)) {
-        this->transformSuperIntoRegularBucket(buckets[i]);
-      }
+    const int64_t position = this->buckets[buckets[i]].FindPosition(feature_vector);
+    if (position != -1) {
+      this->deleteObjectAt(buckets[i], (uint32_t) position, feature_vector);
       // data object has been successfully deleted
       return true;
     }
+    this->traceBucket(BBTREE_TRACE_QUERY, buckets[i]);
   }
 
   // data object could not be found
   return false;
 }
 
+/**
+ * BBTree::DeleteByTid(id) deletes the data object with the given identifier
+ * without comparing feature vectors. It returns false if no such data object
+ * exists. Requires the tid directory (see SetTidDirectory()).
+ */
+bool BBTree::DeleteByTid(const uint32_t object_id) {
+  this->checkNoBufferPool("BBTree::DeleteByTid()");
+  assert(this->use_tid_directory);
+  if (!this->hasTidLocation(object_id))
+    return false;
+
+  const BBTreeTidLocation location = this->tid_directory[object_id];
+  this->deleteObjectAt(location.bucket, location.position,
+    this->buckets[location.bucket].GetObjectAt(location.position));
+  return true;
+}
+
+/**
+ * BBTree::GetObjectByTid(id) returns the data object with the given
+ * identifier, or an empty std::vector if no such data object exists.
+ * Requires the tid directory (see SetTidDirectory()).
+ */
+std::vector<float> BBTree::GetObjectByTid(const uint32_t object_id) const {
+  this->checkNoBufferPool("BBTree::GetObjectByTid()");
+  assert(this->use_tid_directory);
+  if (!this->hasTidLocation(object_id))
+    return std::vector<float>();
+
+  const BBTreeTidLocation &location = this->tid_directory[object_id];
+  return this->buckets[location.bucket].GetObjectAt(location.position);
+}
+
+/**
+ * BBTree::UpdateObject(id, feature_vector) replaces the data object with the
+ * given identifier by the given feature vector. It returns false if no such
+ * data object exists. Requires the tid directory (see SetTidDirectory()).
+ *
+ * If the new feature vector belongs into the same (sub-)bucket, the values are
+ * overwritten in place. Otherwise, the data object is deleted and re-inserted.
+ */
+bool BBTree::UpdateObject(const uint32_t object_id,
+                          const std::vector<float> &feature_vector) {
+  this->checkNoBufferPool("BBTree::UpdateObject()");
+  assert(this->use_tid_directory);
+  assert(feature_vector.size() == this->dimensions);
+  if (!this->hasTidLocation(object_id))
+    return false;
+
+  const BBTreeTidLocation location = this->tid_directory[object_id];
+  BBTreeBucket &bucket = this->buckets[location.bucket];
+  const std::vector<float> old_feature_vector = bucket.GetObjectAt(location.position);
+  const std::vector<size_t> buckets = this->getBucketOfFeatureVector(feature_vector);
+
+  if (std::find(buckets.begin(), buckets.end(), location.bucket) != buckets.end() &&
+      bucket.CanUpdateAt(location.position, feature_vector)) {
+    bucket.UpdateObjectAt(location.position, feature_vector);
+    this->traceBucket(BBTREE_TRACE_UPDATE, location.bucket);
+    this->updateBucketSums(location.bucket, old_feature_vector, -1.0);
+    this->updateBucketSums(location.bucket, feature_vector, 1.0);
+    if (this->isOnZoneMapBoundary(location.bucket, old_feature_vector)) {
+      this->rebuildZoneMap(location.bucket);
+    } else {
+      this->updateZoneMap(location.bucket, feature_vector);
+    }
+    return true;
+  }
+
+  this->deleteObjectAt(location.bucket, location.position, old_feature_vector);
+  this->InsertObject(feature_vector, object_id);
+  return true;
+}
+
+/**
+ * BBTree::DeleteRange(lower_boundary, upper_boundary) deletes all data
+ * objects that match the given range query.
+ * Buckets covered by the query are dropped wholesale, all other relevant
+ * buckets are compacted in a single pass. A rebuild or the transformation of
+ * underflowing superbuckets is considered once at the end.
+ * It returns the number of deleted data objects.
+ */
+size_t BBTree::DeleteRange(const std::vector<float> &lower_boundary,
+                           const std::vector<float> &upper_boundary) {
+  this->checkNoBufferPool("BBTree::DeleteRange()");
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
+                                                                     upper_boundary);
+  std::vector<size_t> modified_buckets;
+  std::vector<uint32_t> deleted_tids;
+  size_t num_deleted = 0;
+
+  for (size_t i = 0; i < match_buckets.size(); ++i) {
+    const size_t bucket_id = match_buckets[i];
+    BBTreeBucket &bucket = this->buckets[bucket_id];
+    if (bucket.GetNumberOfObjects() == 0 ||
+        !this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary)) {
+      continue;
+    }
+
+    this->traceBucket(BBTREE_TRACE_DELETE, bucket_id);
+    deleted_tids.clear();
+    size_t deleted = 0;
+    if (this->zoneMapContained(bucket_id, lower_boundary, upper_boundary)) {
+      if (this->use_tid_directory)
+        bucket.GetAllTids(deleted_tids);
+      deleted = bucket.GetNumberOfObjects();
+      bucket.Clear();
+    } else {
+      deleted = bucket.DeleteRange(lower_boundary, upper_boundary,
+                                   this->use_tid_directory ? &deleted_tids : NULL);
+    }
+    if (deleted == 0)
+      continue;
+
+    if (this->use_tid_directory) {
+      for (size_t j = 0; j < deleted_tids.size(); ++j)
+        this->tid_directory[deleted_tids[j]].bucket = BBTREE_INVALID_BUCKET;
+    }
+    this->count -= deleted;
+    num_deleted += deleted;
+    modified_buckets.push_back(bucket_id);
+  }
+
+  this->finishRangeModification(modified_buckets);
+
+  return num_deleted;
+}
+
+/**
+ * BBTree::UpdateRange(lower_boundary, upper_boundary, update) calls
+ * update(tid, feature_vector) for all data objects that match the given range
+ * query and stores the modified feature vectors.
+ * Data objects that stay in their (sub-)bucket are updated in place; all
+ * others are removed during the pass and re-inserted afterwards. A rebuild
+ * or the transformation of underflowing or overflowing buckets is
+ * considered once at the end.
+ * It returns the number of updated data objects.
+ */
+size_t BBTree::UpdateRange(const std::vector<float> &lower_boundary,
+                           const std::vector<float> &upper_boundary,
+                           const std::function<void(uint32_t, std::vector<float>&)> &update) {
+  this->checkNoBufferPool("BBTree::UpdateRange()");
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
+                                                                     upper_boundary);
+  std::vector<size_t> modified_buckets;
+  std::vector<std::vector<float> > moved_objects;
+  std::vector<uint32_t> moved_tids;
+  std::vector<uint64_t> bitmap;
+  size_t num_updated = 0;
+
+  for (size_t i = 0; i < match_buckets.size(); ++i) {
+    const size_t bucket_id = match_buckets[i];
+    BBTreeBucket &bucket = this->buckets[bucket_id];
+    if (bucket.GetNumberOfObjects() == 0 ||
+        !this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary)) {
+      continue;
+    }
+
+    this->traceBucket(BBTREE_TRACE_UPDATE, bucket_id);
+    size_t updated = 0;
+    for (size_t z = 0; z < bucket.GetNumberOfRegularBuckets(); ++z) {
+      const BBTreeBucket &sub_bucket = bucket.GetRegularBucket(z);
+      bitmap.resize((sub_bucket.GetNumberOfObjects() + 63) / 64);
+      sub_bucket.SelectRange(bitmap.data(), lower_boundary, upper_boundary);
+      // a deleted data object is replaced by the last one, so rows are
+      // visited backwards to keep the bitmap of the unvisited rows valid
+      for (size_t row = sub_bucket.GetNumberOfObjects(); row-- > 0; ) {
+        if (((bitmap[row / 64] >> (row % 64)) & 1) == 0)
+          continue;
+        const uint32_t position = bucket.IsRegularBucket() ? (uint32_t) row :
+          (uint32_t) ((z << BUCKET_POSITION_ROW_BITS) | row);
+        const uint32_t tid = sub_bucket.GetTid(row);
+        std::vector<float> feature_vector = sub_bucket.GetObject(row);
+        update(tid, feature_vector);
+        assert(feature_vector.size() == this->dimensions);
+        updated++;
+
+        const std::vector<size_t> new_buckets =
+          this->getBucketOfFeatureVector(feature_vector);
+        if (std::find(new_buckets.begin(), new_buckets.end(), bucket_id) !=
+              new_buckets.end() &&
+            bucket.CanUpdateAt(position, feature_vector)) {
+          bucket.UpdateObjectAt(position, feature_vector);
+          continue;
+        }
+        if (this->use_tid_directory)
+          this->tid_directory[tid].bucket = BBTREE_INVALID_BUCKET;
+        bucket.DeleteObjectAt(position);
+        this->count--;
+        moved_objects.push_back(feature_vector);
+        moved_tids.push_back(tid);
+      }
+    }
+    if (updated == 0)
+      continue;
+
+    num_updated += updated;
+    modified_buckets.push_back(bucket_id);
+  }
+
+  // re-insert data objects that belong into other buckets; their zone maps,
+  // sums and tid directory entries are restored with the others
+  for (size_t i = 0; i < moved_objects.size(); ++i) {
+    const size_t bucket_id = this->getBucketOfFeatureVectorForInsert(moved_objects[i],
+                                                                     false);
+    this->buckets[bucket_id].InsertObject(moved_objects[i], moved_tids[i]);
+    this->traceBucket(BBTREE_TRACE_INSERT, bucket_id);
+    this->count++;
+    modified_buckets.push_back(bucket_id);
+  }
+  std::sort(modified_buckets.begin(), modified_buckets.end());
+  modified_buckets.erase(std::unique(modified_buckets.begin(),
+                                     modified_buckets.end()),
+                         modified_buckets.end());
+
+  this->finishRangeModification(modified_buckets);
+
+  return num_updated;
+}
+
+/**
+ * BBTree::SetTidDirectory(enabled) enables or disables the tid directory,
+ * which maps the identifier of every data object to its bucket and position.
+ * It is required by DeleteByTid(), GetObjectByTid() and UpdateObject(), and
+ * costs 8 bytes per identifier up to the largest identifier.
+ * The tid directory cannot be enabled while a buffer pool is set.
+ */
+void BBTree::SetTidDirectory(const bool enabled) {
+  if (enabled)
+    this->checkNoBufferPool("BBTree::SetTidDirectory(true)");
+  this->use_tid_directory = enabled;
+  this->tid_directory.clear();
+  if (enabled) {
+    for (size_t i = 0; i < this->num_buckets; ++i)
+      this->refreshTidDirectory(i);
+  } else {
+    this->tid_directory.shrink_to_fit();
+  }
+}
+
+/**
+ * BBTree::SetBufferPool(path, num_frames, replacement) moves the buckets
+ * into a file of fixed-size pages at path. Afterwards, at most num_frames
+ * unpinned buckets are kept resident; the replacement policy decides which
+ * ones are evicted. The delimiters, zone maps and sums stay in memory.
+ * It throws std::runtime_error if the file cannot be created or written,
+ * and std::logic_error if the tid directory is enabled.
+ */
+void BBTree::SetBufferPool(const std::string &path,
+                           const size_t num_frames,
+                           const BBTreeReplacement replacement) {
+  this->SetBufferPool(path, num_frames,
+                      BBTreeReplacementPolicy::Create(replacement, num_frames));
+}
+
+/**
+ * BBTree::SetBufferPool(path, num_frames, policy) is the same as above, but
+ * evicts buckets by the given replacement policy (e.g., a
+ * BBTreeWorkloadPolicy), which is deleted together with the buffer pool
+ * (or right away if the buffer pool cannot be set).
+ */
+void BBTree::SetBufferPool(const std::string &path,
+                           const size_t num_frames,
+                           BBTreeReplacementPolicy* policy) {
+  if (this->use_tid_directory) {
+    delete policy;
+    throw std::logic_error("BBTree::SetBufferPool() is not supported while "
+                           "the tid directory is enabled");
+  }
+  this->DisableBufferPool();
+  BBTreeBufferPool* buffer_pool = new BBTreeBufferPool(path, this->dimensions,
+                                                       num_frames, policy);
+  try {
+    buffer_pool->Reset(this->num_buckets);
+  } catch (...) {
+    delete buffer_pool;
+    throw;
+  }
+  this->buffer_pool = buffer_pool;
+  this->evictBuckets();
+}
+
+/**
+ * BBTree::DisableBufferPool() loads all evicted buckets back into memory
+ * and removes the file of the buffer pool.
+ */
+void BBTree::DisableBufferPool() {
+  if (this->buffer_pool == NULL)
+    return;
+  for (size_t i = 0; i < this->num_buckets; ++i) {
+    if (!this->buffer_pool->IsResident(i))
+      this->loadBucket(i);
+  }
+  delete this->buffer_pool;
+  this->buffer_pool = NULL;
+}
+
+/**
+ * BBTree::GetBufferPool() returns the buffer pool (e.g., for its hit and
+ * miss counters), or NULL if all buckets are kept in memory.
+ */
+const BBTreeBufferPool* BBTree::GetBufferPool() const {
+  return this->buffer_pool;
+}
+
+/**
+ * BBTree::checkNoBufferPool(operation) throws a std::logic_error if a buffer
+ * pool is set, since the given operation reads buckets without pinning them.
+ */
+void BBTree::checkNoBufferPool(const char* operation) const {
+  if (this->buffer_pool != NULL)
+    throw std::logic_error(std::string(operation) +
+                           " is not supported while a buffer pool is set");
+}
+
+/**
+ * BBTree::SetTrace(path) appends the bucket accesses of all following
+ * queries, inserts and deletes to the trace file at path (see BBTreeTrace).
+ * Only buckets whose data objects or tids are read or modified are recorded.
+ */
+void BBTree::SetTrace(const std::string &path) {
+  delete this->trace;
+  this->trace = new BBTreeTrace(path, this->dimensions);
+}
+
+/**
+ * BBTree::DisableTrace() stops recording bucket accesses and closes the
+ * trace file.
+ */
+void BBTree::DisableTrace() {
+  delete this->trace;
+  this->trace = NULL;
+}
+
 /**
  * BBTree::SearchObject(feature_vector) returns the identifier of the
  * specified data object.
  * If no matching data object has been found, it returns -1.
  */
 uint32_t BBTree::SearchObject(const std::vector<float> &feature_vector) const {
+  this->checkNoBufferPool("BBTree::SearchObject()");
   // get the buckets that may hold the searched data object
   const std::vector<size_t> buckets = this->getBucketOfFeatureVector(feature_vector);
   int32_t result;
 
   // iterate over all relevant buckets and search for the data object
   for (size_t i = 0; i < buckets.size(); ++i) {
-    result = this->buckets[buckets[i]]->SearchObject(feature_vector);
+    this->traceBucket(BBTREE_TRACE_QUERY, buckets[i]);
+    result = this->buckets[buckets[i]].SearchObject(feature_vector);
     if (result != -1) {
       // match
       return result;
@@ -162,28 +598,260 @@ uint32_t BBTree::SearchObject(const std::vector<float> &feature_vector) const {
 }
 
 /**
- * BBTree::SearchRange(lower_boundary, upper_boundary) executes the specified
- * range query.
- * It returns a std::vector containing all the tids of the matching objects.
+ * BBTree::SearchObjectBatch(search_objects, results) executes a batch of point
+ * queries and stores the tid of the i'th data object (or -1 if it has not been
+ * found) in results[i].
+ *
+ * Groups of POINT_QUERY_GROUP_SIZE point queries advance through the inner
+ * nodes in lock-step (group prefetching): while one level is searched for all
+ * queries of a group, the inner nodes of the next level, and finally the
+ * buckets, are prefetched, so that the cache misses of the group overlap.
  */
-std::vector<uint32_t> BBTree::SearchRange(const std::vector<float> &lower_boundary,
-                                         const std::vector<float> &upper_boundary) {
-  std::vector<uint32_t> results;
-  // buckets that are relevant for the given range query
+void BBTree::SearchObjectBatch(const std::vector<std::vector<float> > &search_objects,
+                               std::vector<uint32_t> &results) const {
+  this->checkNoBufferPool("BBTree::SearchObjectBatch()");
+  const size_t k = this->delimiters_per_split;
+  const size_t num_queries = search_objects.size();
+  // number of cache lines of an inner node
+  const size_t node_lines = (k * sizeof(float) + 63) / 64;
+  // offset of the first inner node of every level
+  std::vector<size_t> level_offsets(this->height + 1);
+  for (size_t i = 0; i <= this->height; ++i)
+    level_offsets[i] = this->getNumberOfNodesInTreeOfHeight(i);
+  size_t nodes[POINT_QUERY_GROUP_SIZE];
+  size_t offsets[POINT_QUERY_GROUP_SIZE];
+  size_t add_buckets[POINT_QUERY_GROUP_SIZE];
+
+  results.resize(num_queries);
+  for (size_t start = 0; start < num_queries; start += POINT_QUERY_GROUP_SIZE) {
+    const size_t group_size = std::min((size_t) POINT_QUERY_GROUP_SIZE,
+                                       num_queries - start);
+    for (size_t q = 0; q < group_size; ++q) {
+      nodes[q] = 0;
+      offsets[q] = 0;
+      add_buckets[q] = 1;
+    }
+
+    // descend the inner nodes level by level
+    if (this->num_buckets > 1) {
+      for (size_t i = 0; i < this->height; ++i) {
+        const bool last_level = (i == this->height - 1);
+        const size_t dimension = this->delimiter_dimensions[i];
+        for (size_t q = 0; q < group_size; ++q) {
+          const size_t rel_pos = this->searchInnerNode(
+            search_objects[start + q][dimension], offsets[q]);
+          if (last_level)
+            add_buckets[q] = this->getNumberOfEqualDelimiters(offsets[q], rel_pos);
+          nodes[q] = nodes[q] * (k + 1) + rel_pos;
+          offsets[q] = (level_offsets[i+1] + nodes[q]) * k;
+          if (!last_level) {
+            const char* node = (const char*) (this->delimiter_values + offsets[q]);
+            for (size_t line = 0; line < node_lines; ++line)
+              __builtin_prefetch(node + 64 * line);
+          }
+        }
+      }
+    }
+
+    // prefetch the bucket headers and zone maps
+    for (size_t q = 0; q < group_size; ++q) {
+      for (size_t b = nodes[q]; b < nodes[q] + add_buckets[q]; ++b) {
+        __builtin_prefetch(&this->buckets[b]);
+        __builtin_prefetch(this->zone_maps + 2 * this->dimensions * b);
+      }
+    }
+    // prefetch the data of buckets whose zone map contains the data object
+    for (size_t q = 0; q < group_size; ++q) {
+      const std::vector<float> &search_object = search_objects[start + q];
+      for (size_t b = nodes[q]; b < nodes[q] + add_buckets[q]; ++b) {
+        if (this->zoneMapIntersects(b, search_object, search_object))
+          this->buckets[b].Prefetch(false);
+      }
+    }
+    // search the buckets
+    for (size_t q = 0; q < group_size; ++q) {
+      const std::vector<float> &search_object = search_objects[start + q];
+      int32_t result = -1;
+      for (size_t b = nodes[q]; b < nodes[q] + add_buckets[q]; ++b) {
+        if (!this->zoneMapIntersects(b, search_object, search_object))
+          continue;
+        this->traceBucket(BBTREE_TRACE_QUERY, b);
+        result = this->buckets[b].SearchObject(search_object);
+        if (result != -1)
+          break;
+      }
+      results[start + q] = result;
+    }
+  }
+}
+
+/**
+ * BBTree::EstimateRange(lower_boundary, upper_boundary) estimates the number
+ * of data objects that match the given range query and the number of buckets
+ * it scans, using only the delimiters, the bucket counts and the zone maps.
+ * The inner nodes form an equi-depth histogram; within a bucket, data
+ * objects are assumed to be distributed uniformly and independently over its
+ * zone map. Superbuckets additionally use their delimiter values and the
+ * counts of their z buckets.
+ */
+BBTreeEstimate BBTree::EstimateRange(const std::vector<float> &lower_boundary,
+                                     const std::vector<float> &upper_boundary) const {
+  this->checkNoBufferPool("BBTree::EstimateRange()");
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
+                                                                     upper_boundary);
+  BBTreeEstimate estimate;
+  estimate.rows = 0.0;
+  estimate.buckets = 0;
+
+  for (size_t i = 0; i < match_buckets.size(); ++i) {
+    const size_t bucket_id = match_buckets[i];
+    const BBTreeBucket &bucket = this->buckets[bucket_id];
+    if (bucket.GetNumberOfObjects() == 0 ||
+        !this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary)) {
+      continue;
+    }
+    estimate.buckets++;
+    if (this->zoneMapContained(bucket_id, lower_boundary, upper_boundary)) {
+      estimate.rows += bucket.GetNumberOfObjects();
+      continue;
+    }
+
+    const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+    const BBTreeSuperBucket* super_bucket = bucket.IsRegularBucket() ?
+      NULL : bucket.GetSuperBucket();
+    double fraction = 1.0;
+    for (size_t j = 0; j < this->dimensions; ++j) {
+      if (super_bucket != NULL && j == super_bucket->delimiter_dimension)
+        continue;
+      fraction *= BBTree::getOverlapFraction(zone_map[j],
+                                             zone_map[this->dimensions + j],
+                                             lower_boundary[j],
+                                             upper_boundary[j]);
+    }
+    if (super_bucket == NULL) {
+      estimate.rows += fraction * bucket.GetNumberOfObjects();
+      continue;
+    }
+
+    // the z buckets partition the delimiter dimension of the zone map
+    const size_t dimension = super_bucket->delimiter_dimension;
+    const float minimum = zone_map[dimension];
+    const float maximum = zone_map[this->dimensions + dimension];
+    for (size_t z = 0; z < super_bucket->num_buckets; ++z) {
+      const size_t count = super_bucket->buckets[z].GetNumberOfObjects();
+      if (count == 0 ||
+          !super_bucket->isRelevantForRange(z, lower_boundary, upper_boundary)) {
+        continue;
+      }
+      const float lower = (z > 0) ?
+        std::max(minimum, super_bucket->delimiter_values[z - 1]) : minimum;
+      const float upper = (z < super_bucket->num_buckets - 1) ?
+        std::min(maximum, super_bucket->delimiter_values[z]) : maximum;
+      estimate.rows += fraction * count *
+        BBTree::getOverlapFraction(lower, std::max(lower, upper),
+                                   lower_boundary[dimension],
+                                   upper_boundary[dimension]);
+    }
+  }
+
+  return estimate;
+}
+
+/**
+ * BBTree::CountRange(lower_boundary, upper_boundary) returns the number of
+ * data objects that match the specified range query.
+ * Buckets whose zone map is covered by the query contribute their number of
+ * data objects, the remaining buckets count the bits of their block masks;
+ * no tids are materialized.
+ */
+size_t BBTree::CountRange(const std::vector<float> &lower_boundary,
+                          const std::vector<float> &upper_boundary) {
+  this->checkNoBufferPool("BBTree::CountRange()");
   const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
                                                                      upper_boundary);
   const size_t num_buckets = match_buckets.size();
-  for (size_t bucket = 0; bucket < num_buckets; ++bucket) {
-    this->buckets[match_buckets[bucket]]->SearchRange(results,
-                                                      lower_boundary,
-                                                      upper_boundary);
+  const size_t distance = this->getPrefetchDistance();
+  size_t matches = 0;
+  for (size_t i = 0; i < num_buckets; ++i) {
+    this->prefetchBuckets(match_buckets, i, num_buckets, distance,
+                          lower_boundary, upper_boundary);
+    const size_t bucket_id = match_buckets[i];
+    if (!this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary))
+      continue;
+    if (this->zoneMapContained(bucket_id, lower_boundary, upper_boundary)) {
+      matches += this->buckets[bucket_id].GetNumberOfObjects();
+    } else {
+      this->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+      matches += this->buckets[bucket_id].CountRange(lower_boundary,
+                                                     upper_boundary);
+    }
   }
 
-  // monitor query workload 
-  this->last_lower_bounds.push_back(lower_boundary);
-  this->last_upper_bounds.push_back(upper_boundary);
+  // monitor query workload
+  this->monitorQuery(lower_boundary, upper_boundary);
 
-  return results;
+  return matches;
+}
+
+/**
+ * BBTree::AggregateRange(lower_boundary, upper_boundary, dimension) returns
+ * the number of data objects that match the specified range query and the
+ * minimum, maximum and sum of their values in the given dimension.
+ * Buckets whose zone map is covered by the query are answered from their zone
+ * map and sums without touching their data objects.
+ */
+BBTreeAggregate BBTree::AggregateRange(const std::vector<float> &lower_boundary,
+                                       const std::vector<float> &upper_boundary,
+                                       const size_t dimension) {
+  this->checkNoBufferPool("BBTree::AggregateRange()");
+  assert(dimension < this->dimensions);
+  BBTreeAggregate aggregate;
+  aggregate.count = 0;
+  aggregate.min = std::numeric_limits<float>::max();
+  aggregate.max = -std::numeric_limits<float>::max();
+  aggregate.sum = 0.0;
+
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
+                                                                     upper_boundary);
+  const size_t num_buckets = match_buckets.size();
+  const size_t distance = this->getPrefetchDistance();
+  for (size_t i = 0; i < num_buckets; ++i) {
+    this->prefetchBuckets(match_buckets, i, num_buckets, distance,
+                          lower_boundary, upper_boundary);
+    const size_t bucket_id = match_buckets[i];
+    if (!this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary))
+      continue;
+    if (this->zoneMapContained(bucket_id, lower_boundary, upper_boundary)) {
+      const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+      aggregate.count += this->buckets[bucket_id].GetNumberOfObjects();
+      aggregate.min = std::min(aggregate.min, zone_map[dimension]);
+      aggregate.max = std::max(aggregate.max,
+                               zone_map[this->dimensions + dimension]);
+      aggregate.sum += this->bucket_sums[this->dimensions * bucket_id + dimension];
+    } else {
+      this->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+      this->buckets[bucket_id].AggregateRange(lower_boundary, upper_boundary,
+                                              dimension, aggregate);
+    }
+  }
+
+  // monitor query workload
+  this->monitorQuery(lower_boundary, upper_boundary);
+
+  return aggregate;
+}
+
+/**
+ * BBTree::SearchRange(lower_boundary, upper_boundary) executes the specified
+ * range query.
+ * It returns a std::vector containing all the tids of the matching objects.
+ */
+std::vector<uint32_t> BBTree::SearchRange(const std::vector<float> &lower_boundary,
+                                         const std::vector<float> &upper_boundary) {
+  BBTreeQueryContext context;
+  this->SearchRange(lower_boundary, upper_boundary, context);
+
+  return std::move(context.results);
 }
 
 /**
@@ -193,78 +861,94 @@ std::vector<uint32_t> BBTree::SearchRange(const std::vector<float> &lower_bounda
  */
 std::vector<uint32_t> BBTree::SearchRangeMT(const std::vector<float> &lower_boundary,
                                            const std::vector<float> &upper_boundary) {
+  BBTreeQueryContext context;
+  this->SearchRangeMT(lower_boundary, upper_boundary, context);
+
+  return std::move(context.results);
+}
+
+/**
+ * BBTree::SearchRanges(lower_boundaries, upper_boundaries) executes a set of
+ * range queries (boxes) at once. The tree is traversed once with all boxes,
+ * and every relevant bucket is scanned once for all boxes that may match
+ * data objects of it.
+ * It returns the tids of the matching objects of every box.
+ */
+std::vector<std::vector<uint32_t> > BBTree::SearchRanges(const std::vector<std::vector<float> > &lower_boundaries,
+                                                        const std::vector<std::vector<float> > &upper_boundaries) {
+  std::vector<std::vector<uint32_t> > results(lower_boundaries.size());
+  this->searchRanges(lower_boundaries, upper_boundaries, &results, NULL);
+
+  return results;
+}
+
+/**
+ * BBTree::SearchRangesUnion(lower_boundaries, upper_boundaries) executes a set
+ * of range queries (boxes) at once like SearchRanges().
+ * It returns the tids of all data objects that match any box (each once).
+ */
+std::vector<uint32_t> BBTree::SearchRangesUnion(const std::vector<std::vector<float> > &lower_boundaries,
+                                               const std::vector<std::vector<float> > &upper_boundaries) {
   std::vector<uint32_t> results;
-  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
-                                                                     upper_boundary);
+  this->searchRanges(lower_boundaries, upper_boundaries, NULL, &results);
+
+  return results;
+}
+
+/**
+ * BBTree::SearchRangesMT(lower_boundaries, upper_boundaries) executes a set of
+ * range queries (boxes) like SearchRanges(), but scans the relevant buckets
+ * in parallel.
+ * It returns the tids of the matching objects of every box.
+ */
+std::vector<std::vector<uint32_t> > BBTree::SearchRangesMT(const std::vector<std::vector<float> > &lower_boundaries,
+                                                          const std::vector<std::vector<float> > &upper_boundaries) {
+  this->checkNoBufferPool("BBTree::SearchRangesMT()");
+  assert(lower_boundaries.size() == upper_boundaries.size());
+  std::vector<std::vector<uint32_t> > results(lower_boundaries.size());
+  std::vector<size_t> match_buckets;
+  std::vector<std::vector<uint32_t> > bucket_boxes;
+  this->getBucketsForRanges(lower_boundaries, upper_boundaries, match_buckets,
+                            bucket_boxes);
   const size_t num_buckets = match_buckets.size();
   // take the current thread into account
-  const size_t dop = ((num_buckets < this->num_threads) ? num_buckets : this->num_threads) - 1;
-
-  std::vector<size_t> partitions;
-  for (size_t i = 0; i < num_buckets; ++i) {
-    if (this->buckets[match_buckets[i]]->IsRegularBucket()) { // regular bucket
-      partitions.push_back(match_buckets[i]);
-    } else { // super bucket
-      partitions.push_back(match_buckets[i]);
-      partitions.push_back(match_buckets[i]);
-    }
-  }
+  const size_t dop = (num_buckets == 0) ? 0 :
+    ((num_buckets < this->num_threads) ? num_buckets : this->num_threads) - 1;
+  const size_t partition_size = num_buckets / (dop + 1);
 
-  //const size_t partition_size = num_buckets / (dop + 1);
-  const size_t partition_size = partitions.size() / (dop + 1);
   std::future<void> *futures = new std::future<void>[dop];
-  std::vector<std::vector<uint32_t> > thread_results(dop,
-                                                     std::vector<uint32_t>());
-  size_t start, end;
+  std::vector<std::vector<std::vector<uint32_t> > > thread_results(dop,
+    std::vector<std::vector<uint32_t> >(lower_boundaries.size()));
   for (size_t i = 0; i < dop; ++i) {
-    start = (i * partition_size);
-    // compare with end of previous partition to handle
-    // superbuckets spanning multiple partitions
-    while (start > 0 && partitions[start] == partitions[end-1]) {
-      start++;
-    }
-    end = ((i+1) * partition_size);
-    // ensure that partition is not empty
-    futures[i] = this->thread_pool->push(std::ref(BBTree::ScanBuckets),
+    futures[i] = this->thread_pool->push(std::ref(BBTree::ScanBucketsRanges),
                                          this,
-                                         std::ref(thread_results[i]),
-                                         lower_boundary,
-                                         upper_boundary,
-                                         std::ref(partitions),
-                                         start,
-                                         end);
+                                         &thread_results[i],
+                                         (std::vector<uint32_t>*) NULL,
+                                         std::ref(lower_boundaries),
+                                         std::ref(upper_boundaries),
+                                         std::ref(match_buckets),
+                                         std::ref(bucket_boxes),
+                                         i * partition_size,
+                                         (i+1) * partition_size);
   }
 
   // do something useful with this thread :-)
-  start = (dop * partition_size);
-  // compare with end of previous partition to handle
-  // superbuckets spanning multiple partitions
-  while (start > 0 && partitions[start] == partitions[end-1]) {
-    start++;
-  }
-  end = partitions.size();
-  // ensure that partition is not empty
-  if(end > start) {
-    BBTree::ScanBuckets(0,
-                       this,
-                       std::ref(results),
-                       lower_boundary,
-                       upper_boundary,
-                       std::ref(partitions),
-                       start,
-                       end);
-  }
+  BBTree::ScanBucketsRanges(0, this, &results, NULL, lower_boundaries,
+                            upper_boundaries, match_buckets, bucket_boxes,
+                            dop * partition_size, num_buckets);
 
   // monitor query workload
-  this->last_lower_bounds.push_back(lower_boundary);
-  this->last_upper_bounds.push_back(upper_boundary);
+  for (size_t b = 0; b < lower_boundaries.size(); ++b)
+    this->monitorQuery(lower_boundaries[b], upper_boundaries[b]);
 
   // collect results from threads
   for (size_t i = 0; i < dop; ++i) {
     futures[i].get();
-    results.insert(std::end(results),
-                   std::begin(thread_results[i]),
-                   std::end(thread_results[i]));
+    for (size_t b = 0; b < results.size(); ++b) {
+      results[b].insert(std::end(results[b]),
+                        std::begin(thread_results[i][b]),
+                        std::end(thread_results[i][b]));
+    }
   }
   delete [] futures;
 
@@ -272,10 +956,670 @@ std::vector<uint32_t> BBTree::SearchRangeMT(const std::vector<float> &lower_boun
 }
 
 /**
- * BBTree::ScanBuckets(id,bbtree,results,lower_bounds,upper_bounds,match_buckets,start,end)
- * executes a range query on the relevant buckets start to end.
- * The tids of the matching objects are stored in the std::vector results.
- *
+ * BBTree::searchRanges(lower_bounds,upper_bounds,results,union_results)
+ * executes a set of range queries and stores the matches per box in results
+ * or the union of all matches in union_results (one of both is NULL).
+ */
+void BBTree::searchRanges(const std::vector<std::vector<float> > &lower_boundaries,
+                          const std::vector<std::vector<float> > &upper_boundaries,
+                          std::vector<std::vector<uint32_t> > *results,
+                          std::vector<uint32_t> *union_results) {
+  this->checkNoBufferPool("BBTree::SearchRanges()");
+  assert(lower_boundaries.size() == upper_boundaries.size());
+  std::vector<size_t> match_buckets;
+  std::vector<std::vector<uint32_t> > bucket_boxes;
+  this->getBucketsForRanges(lower_boundaries, upper_boundaries, match_buckets,
+                            bucket_boxes);
+
+  BBTree::ScanBucketsRanges(0, this, results, union_results, lower_boundaries,
+                            upper_boundaries, match_buckets, bucket_boxes, 0,
+                            match_buckets.size());
+
+  // monitor query workload
+  for (size_t b = 0; b < lower_boundaries.size(); ++b)
+    this->monitorQuery(lower_boundaries[b], upper_boundaries[b]);
+}
+
+/**
+ * BBTree::ScanBucketsRanges(id,bbtree,results,union_results,lower_bounds,upper_bounds,match_buckets,bucket_boxes,start,end)
+ * executes a set of range queries on the relevant buckets start to end, each
+ * with the boxes given by bucket_boxes. The matches are stored per box in
+ * results or as union in union_results (one of both is NULL).
+ * Buckets whose zone map is covered by a box contribute all of their tids
+ * to that box; the remaining boxes of a bucket are evaluated in one scan.
+ */
+void BBTree::ScanBucketsRanges(int thread_id,
+                               BBTree *bbtree,
+                               std::vector<std::vector<uint32_t> > *results,
+                               std::vector<uint32_t> *union_results,
+                               const std::vector<std::vector<float> > &lower_boundaries,
+                               const std::vector<std::vector<float> > &upper_boundaries,
+                               const std::vector<size_t> &match_buckets,
+                               const std::vector<std::vector<uint32_t> > &bucket_boxes,
+                               const size_t start,
+                               const size_t end) {
+  std::vector<uint32_t> boxes;
+  for (size_t i = start; i < end; ++i) {
+    const size_t bucket_id = match_buckets[i];
+    const BBTreeBucket &bucket = bbtree->buckets[bucket_id];
+    bool contained = false;
+    boxes.clear();
+    for (size_t b = 0; b < bucket_boxes[i].size(); ++b) {
+      const uint32_t box = bucket_boxes[i][b];
+      if (!bbtree->zoneMapIntersects(bucket_id, lower_boundaries[box],
+                                     upper_boundaries[box])) {
+        continue;
+      }
+      if (bbtree->zoneMapContained(bucket_id, lower_boundaries[box],
+                                   upper_boundaries[box])) {
+        contained = true;
+        if (results != NULL)
+          bucket.GetAllTids((*results)[box]);
+      } else {
+        boxes.push_back(box);
+      }
+    }
+    if (contained || !boxes.empty())
+      bbtree->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+    if (union_results != NULL && contained) {
+      bucket.GetAllTids(*union_results);
+    } else if (!boxes.empty()) {
+      bucket.SearchRanges(lower_boundaries, upper_boundaries, boxes, results,
+                          union_results);
+    }
+  }
+}
+
+/**
+ * BBTree::JoinBoxes(lower_boundaries, upper_boundaries) joins the data
+ * objects with a set of boxes. The boxes co-traverse the tree once and every
+ * relevant bucket is scanned once for all of its boxes (see SearchRanges()).
+ * It returns the pairs (box index, tid) of all data objects inside a box.
+ */
+std::vector<std::pair<uint32_t, uint32_t> > BBTree::JoinBoxes(const std::vector<std::vector<float> > &lower_boundaries,
+                                                             const std::vector<std::vector<float> > &upper_boundaries) {
+  this->checkNoBufferPool("BBTree::JoinBoxes()");
+  return BBTree::flattenJoinResults(this->SearchRanges(lower_boundaries,
+                                                       upper_boundaries));
+}
+
+/**
+ * BBTree::JoinBoxesMT(lower_boundaries, upper_boundaries) joins the data
+ * objects with a set of boxes like JoinBoxes(), but scans the relevant
+ * buckets in parallel.
+ */
+std::vector<std::pair<uint32_t, uint32_t> > BBTree::JoinBoxesMT(const std::vector<std::vector<float> > &lower_boundaries,
+                                                               const std::vector<std::vector<float> > &upper_boundaries) {
+  this->checkNoBufferPool("BBTree::JoinBoxesMT()");
+  return BBTree::flattenJoinResults(this->SearchRangesMT(lower_boundaries,
+                                                         upper_boundaries));
+}
+
+/**
+ * BBTree::JoinDistance(other, epsilon, metric) joins the data objects with
+ * those of another BB-Tree of the same dimensionality.
+ * It returns the pairs (tid, tid of other) of all data objects whose distance
+ * is at most epsilon. Only pairs of buckets whose zone maps are at most
+ * epsilon apart are compared.
+ */
+std::vector<std::pair<uint32_t, uint32_t> > BBTree::JoinDistance(BBTree &other,
+                                                                const float epsilon,
+                                                                const BBTreeMetric metric) {
+  this->checkNoBufferPool("BBTree::JoinDistance()");
+  other.checkNoBufferPool("BBTree::JoinDistance()");
+  std::vector<std::pair<uint32_t, uint32_t> > results;
+  std::vector<std::pair<size_t, size_t> > bucket_pairs;
+  this->getJoinBucketPairs(other, epsilon, metric, bucket_pairs);
+  const float max_distance = (metric == BBTREE_METRIC_L2) ?
+    epsilon * epsilon : epsilon;
+
+  BBTree::JoinBuckets(0, this, &other, results, metric, max_distance,
+                      bucket_pairs, 0, bucket_pairs.size());
+
+  return results;
+}
+
+/**
+ * BBTree::JoinDistanceMT(other, epsilon, metric) joins the data objects with
+ * those of another BB-Tree like JoinDistance(), but compares the bucket pairs
+ * in parallel.
+ */
+std::vector<std::pair<uint32_t, uint32_t> > BBTree::JoinDistanceMT(BBTree &other,
+                                                                  const float epsilon,
+                                                                  const BBTreeMetric metric) {
+  this->checkNoBufferPool("BBTree::JoinDistanceMT()");
+  other.checkNoBufferPool("BBTree::JoinDistanceMT()");
+  std::vector<std::pair<uint32_t, uint32_t> > results;
+  std::vector<std::pair<size_t, size_t> > bucket_pairs;
+  this->getJoinBucketPairs(other, epsilon, metric, bucket_pairs);
+  const float max_distance = (metric == BBTREE_METRIC_L2) ?
+    epsilon * epsilon : epsilon;
+  const size_t num_pairs = bucket_pairs.size();
+  // take the current thread into account
+  const size_t dop = (num_pairs == 0) ? 0 :
+    ((num_pairs < this->num_threads) ? num_pairs : this->num_threads) - 1;
+  const size_t partition_size = num_pairs / (dop + 1);
+
+  std::future<void> *futures = new std::future<void>[dop];
+  std::vector<std::vector<std::pair<uint32_t, uint32_t> > > thread_results(dop);
+  for (size_t i = 0; i < dop; ++i) {
+    futures[i] = this->thread_pool->push(std::ref(BBTree::JoinBuckets),
+                                         this,
+                                         &other,
+                                         std::ref(thread_results[i]),
+                                         metric,
+                                         max_distance,
+                                         std::ref(bucket_pairs),
+                                         i * partition_size,
+                                         (i+1) * partition_size);
+  }
+
+  // do something useful with this thread :-)
+  BBTree::JoinBuckets(0, this, &other, results, metric, max_distance,
+                      bucket_pairs, dop * partition_size, num_pairs);
+
+  // collect results from threads
+  for (size_t i = 0; i < dop; ++i) {
+    futures[i].get();
+    results.insert(std::end(results),
+                   std::begin(thread_results[i]),
+                   std::end(thread_results[i]));
+  }
+  delete [] futures;
+
+  return results;
+}
+
+/**
+ * BBTree::JoinBuckets(id,bbtree,other,results,metric,max_distance,bucket_pairs,start,end)
+ * joins the bucket pairs start to end (bucket of bbtree, bucket of other)
+ * and stores the pairs of tids whose distance is at most max_distance
+ * (squared for L2) in the std::vector results. The data objects of the
+ * smaller bucket of a pair are compared against the larger one.
+ */
+void BBTree::JoinBuckets(int thread_id,
+                         BBTree *bbtree,
+                         const BBTree *other,
+                         std::vector<std::pair<uint32_t, uint32_t> > &results,
+                         const BBTreeMetric metric,
+                         const float max_distance,
+                         const std::vector<std::pair<size_t, size_t> > &bucket_pairs,
+                         const size_t start,
+                         const size_t end) {
+  std::vector<std::pair<uint32_t, uint32_t> > swapped_results;
+  for (size_t i = start; i < end; ++i) {
+    const BBTreeBucket &bucket = bbtree->buckets[bucket_pairs[i].first];
+    const BBTreeBucket &other_bucket = other->buckets[bucket_pairs[i].second];
+    // the smaller bucket probes the larger one
+    if (bucket.GetNumberOfObjects() <= other_bucket.GetNumberOfObjects()) {
+      bucket.JoinDistance(other_bucket, metric, max_distance, results);
+      continue;
+    }
+    swapped_results.clear();
+    other_bucket.JoinDistance(bucket, metric, max_distance, swapped_results);
+    for (size_t j = 0; j < swapped_results.size(); ++j) {
+      results.push_back(std::make_pair(swapped_results[j].second,
+                                       swapped_results[j].first));
+    }
+  }
+}
+
+/**
+ * BBTree::SearchRangeLimit(lower_boundary, upper_boundary, limit) executes the
+ * specified range query until limit matching data objects have been found.
+ * It returns a std::vector containing the tids of at most limit (arbitrary)
+ * matching objects.
+ */
+std::vector<uint32_t> BBTree::SearchRangeLimit(const std::vector<float> &lower_boundary,
+                                              const std::vector<float> &upper_boundary,
+                                              const size_t limit) {
+  this->checkNoBufferPool("BBTree::SearchRangeLimit()");
+  std::vector<uint32_t> results;
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
+                                                                     upper_boundary);
+  const size_t num_buckets = match_buckets.size();
+  const size_t distance = this->getPrefetchDistance();
+  for (size_t bucket = 0; bucket < num_buckets && results.size() < limit;
+       ++bucket) {
+    this->prefetchBuckets(match_buckets, bucket, num_buckets, distance,
+                          lower_boundary, upper_boundary);
+    this->scanBucket(results, match_buckets[bucket], lower_boundary,
+                     upper_boundary);
+  }
+  if (results.size() > limit)
+    results.resize(limit);
+
+  // monitor query workload
+  this->monitorQuery(lower_boundary, upper_boundary);
+
+  return results;
+}
+
+/**
+ * BBTree::SearchRangeTopK(lower_boundary, upper_boundary, dimension, k)
+ * executes the specified range query and returns the tids of the k matching
+ * data objects with the smallest values in the given dimension, ordered by
+ * that value (ties are ordered by tid).
+ *
+ * The relevant buckets are visited in ascending order of the minimum of their
+ * zone maps in the given dimension, which follows the delimiter order if it
+ * is a delimiter dimension. Once k matches have been found, the scan stops at
+ * the first bucket whose minimum exceeds the current k-th value.
+ */
+std::vector<uint32_t> BBTree::SearchRangeTopK(const std::vector<float> &lower_boundary,
+                                             const std::vector<float> &upper_boundary,
+                                             const size_t dimension,
+                                             const size_t k) {
+  this->checkNoBufferPool("BBTree::SearchRangeTopK()");
+  assert(dimension < this->dimensions);
+  std::vector<std::pair<float, uint32_t> > heap;
+  std::vector<uint32_t> results;
+  if (k == 0)
+    return results;
+
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
+                                                                     upper_boundary);
+  // order relevant buckets by the minimum of their zone maps
+  std::vector<std::pair<float, size_t> > order;
+  for (size_t i = 0; i < match_buckets.size(); ++i) {
+    const size_t bucket_id = match_buckets[i];
+    if (!this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary))
+      continue;
+    const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+    order.push_back(std::make_pair(std::max(zone_map[dimension],
+                                            lower_boundary[dimension]),
+                                   bucket_id));
+  }
+  std::sort(order.begin(), order.end());
+
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (heap.size() == k && order[i].first > heap.front().first)
+      break;
+    this->traceBucket(BBTREE_TRACE_QUERY, order[i].second);
+    this->buckets[order[i].second].SearchRangeTopK(lower_boundary,
+                                                   upper_boundary,
+                                                   dimension, k, heap);
+  }
+
+  // monitor query workload
+  this->monitorQuery(lower_boundary, upper_boundary);
+
+  std::sort_heap(heap.begin(), heap.end());
+  results.reserve(heap.size());
+  for (size_t i = 0; i < heap.size(); ++i)
+    results.push_back(heap[i].second);
+
+  return results;
+}
+
+/**
+ * BBTree::SearchRange(lower_boundary, upper_boundary, context) executes the
+ * specified range query using the buffers of context and stores the tids of
+ * the matching objects in context (see BBTreeQueryContext::GetResults()).
+ */
+void BBTree::SearchRange(const std::vector<float> &lower_boundary,
+                         const std::vector<float> &upper_boundary,
+                         BBTreeQueryContext &context) {
+  std::vector<uint32_t> &results = context.results;
+  results.clear();
+  // buckets that are relevant for the given range query
+  this->getBucketsForRange(lower_boundary, upper_boundary,
+                           context.match_buckets, context.next_nodes);
+  const std::vector<size_t> &match_buckets = context.match_buckets;
+  const size_t num_buckets = match_buckets.size();
+  if (this->buffer_pool != NULL) {
+    // zone maps skip buckets without reading them; the remaining ones are
+    // pinned one at a time and announced to the replacement policy
+    std::vector<size_t> &pending_buckets = this->pending_buckets;
+    pending_buckets.clear();
+    for (size_t bucket = 0; bucket < num_buckets; ++bucket) {
+      if (this->zoneMapIntersects(match_buckets[bucket], lower_boundary,
+                                  upper_boundary))
+        pending_buckets.push_back(match_buckets[bucket]);
+    }
+    this->pending_queries++;
+    for (size_t bucket = 0; bucket < pending_buckets.size(); ++bucket) {
+      const size_t bucket_id = pending_buckets[bucket];
+      this->next_pending_bucket = bucket + 1;
+      this->pinBucket(bucket_id);
+      this->scanBucket(results, bucket_id, lower_boundary, upper_boundary);
+      this->unpinBucket(bucket_id, false);
+    }
+    pending_buckets.clear();
+    this->next_pending_bucket = 0;
+  } else {
+    const size_t distance = this->getPrefetchDistance();
+    for (size_t bucket = 0; bucket < num_buckets; ++bucket) {
+      this->prefetchBuckets(match_buckets, bucket, num_buckets, distance,
+                            lower_boundary, upper_boundary);
+      this->scanBucket(results, match_buckets[bucket], lower_boundary,
+                       upper_boundary);
+    }
+  }
+
+  // monitor query workload 
+  this->monitorQuery(lower_boundary, upper_boundary);
+}
+
+/**
+ * BBTree::SearchRangeMT(lower_boundary, upper_boundary, context) executes the
+ * specified range query in parallel using multi-threading and the buffers of
+ * context. The tids of the matching objects are stored in context.
+ */
+void BBTree::SearchRangeMT(const std::vector<float> &lower_boundary,
+                           const std::vector<float> &upper_boundary,
+                           BBTreeQueryContext &context) {
+  // the buffer pool is accessed by the calling thread only
+  if (this->buffer_pool != NULL) {
+    this->SearchRange(lower_boundary, upper_boundary, context);
+    return;
+  }
+  std::vector<uint32_t> &results = context.results;
+  results.clear();
+  this->getBucketsForRange(lower_boundary, upper_boundary,
+                           context.match_buckets, context.next_nodes);
+  const std::vector<size_t> &match_buckets = context.match_buckets;
+  const size_t num_buckets = match_buckets.size();
+  // take the current thread into account
+  const size_t dop = (num_buckets == 0) ? 0 :
+    ((num_buckets < this->num_threads) ? num_buckets : this->num_threads) - 1;
+
+  std::vector<size_t> &partitions = context.partitions;
+  partitions.clear();
+  for (size_t i = 0; i < num_buckets; ++i) {
+    if (this->buckets[match_buckets[i]].IsRegularBucket()) { // regular bucket
+      partitions.push_back(match_buckets[i]);
+    } else { // super bucket
+      partitions.push_back(match_buckets[i]);
+      partitions.push_back(match_buckets[i]);
+    }
+  }
+
+  //const size_t partition_size = num_buckets / (dop + 1);
+  const size_t partition_size = partitions.size() / (dop + 1);
+  if (context.futures.size() < dop) {
+    context.futures.resize(dop);
+    context.thread_results.resize(dop);
+  }
+  size_t start, end;
+  for (size_t i = 0; i < dop; ++i) {
+    start = (i * partition_size);
+    // compare with end of previous partition to handle
+    // superbuckets spanning multiple partitions
+    while (start > 0 && partitions[start] == partitions[end-1]) {
+      start++;
+    }
+    end = ((i+1) * partition_size);
+    context.thread_results[i].clear();
+    // ensure that partition is not empty
+    context.futures[i] = this->thread_pool->push(std::ref(BBTree::ScanBuckets),
+                                                 this,
+                                                 std::ref(context.thread_results[i]),
+                                                 std::ref(lower_boundary),
+                                                 std::ref(upper_boundary),
+                                                 std::ref(partitions),
+                                                 start,
+                                                 end);
+  }
+
+  // do something useful with this thread :-)
+  start = (dop * partition_size);
+  // compare with end of previous partition to handle
+  // superbuckets spanning multiple partitions
+  while (start > 0 && partitions[start] == partitions[end-1]) {
+    start++;
+  }
+  end = partitions.size();
+  // ensure that partition is not empty
+  if(end > start) {
+    BBTree::ScanBuckets(0,
+                       this,
+                       results,
+                       lower_boundary,
+                       upper_boundary,
+                       partitions,
+                       start,
+                       end);
+  }
+
+  // monitor query workload
+  this->monitorQuery(lower_boundary, upper_boundary);
+
+  // collect results from threads
+  for (size_t i = 0; i < dop; ++i) {
+    context.futures[i].get();
+    results.insert(std::end(results),
+                   std::begin(context.thread_results[i]),
+                   std::end(context.thread_results[i]));
+  }
+}
+
+/**
+ * BBTree::SearchRange(lower_boundary, upper_boundary, selection) executes the
+ * specified range query and stores a selection bitmap per scanned bucket in
+ * selection instead of materializing the tids of the matching objects.
+ */
+void BBTree::SearchRange(const std::vector<float> &lower_boundary,
+                         const std::vector<float> &upper_boundary,
+                         BBTreeSelection &selection) {
+  this->planSelection(lower_boundary, upper_boundary, selection);
+  selection.num_matches = selection.selectEntries(0, selection.entries.size(),
+                                                  lower_boundary,
+                                                  upper_boundary);
+
+  // monitor query workload
+  this->monitorQuery(lower_boundary, upper_boundary);
+}
+
+/**
+ * BBTree::SearchRangeMT(lower_boundary, upper_boundary, selection) executes
+ * the specified range query in parallel using multi-threading and stores
+ * a selection bitmap per scanned bucket in selection.
+ * The bitmaps of all buckets are allocated upfront, so the threads write
+ * into disjoint ranges of the same result and nothing has to be merged.
+ */
+void BBTree::SearchRangeMT(const std::vector<float> &lower_boundary,
+                           const std::vector<float> &upper_boundary,
+                           BBTreeSelection &selection) {
+  this->planSelection(lower_boundary, upper_boundary, selection);
+  const size_t num_entries = selection.entries.size();
+  // take the current thread into account
+  const size_t dop = (num_entries == 0) ? 0 :
+    ((num_entries < this->num_threads) ? num_entries : this->num_threads) - 1;
+  const size_t partition_size = num_entries / (dop + 1);
+
+  std::future<size_t> *futures = new std::future<size_t>[dop];
+  for (size_t i = 0; i < dop; ++i) {
+    futures[i] = this->thread_pool->push(std::ref(BBTree::SelectBuckets),
+                                         std::ref(selection),
+                                         std::ref(lower_boundary),
+                                         std::ref(upper_boundary),
+                                         i * partition_size,
+                                         (i+1) * partition_size);
+  }
+
+  // do something useful with this thread :-)
+  selection.num_matches = selection.selectEntries(dop * partition_size,
+                                                  num_entries,
+                                                  lower_boundary,
+                                                  upper_boundary);
+
+  // monitor query workload
+  this->monitorQuery(lower_boundary, upper_boundary);
+
+  for (size_t i = 0; i < dop; ++i) {
+    selection.num_matches += futures[i].get();
+  }
+  delete [] futures;
+}
+
+/**
+ * BBTree::SelectBuckets(id,selection,lower_bounds,upper_bounds,start,end)
+ * computes the selection bitmaps of the buckets start to end of selection
+ * and returns the number of matching data objects.
+ */
+size_t BBTree::SelectBuckets(int thread_id,
+                             BBTreeSelection &selection,
+                             const std::vector<float> &lower_boundary,
+                             const std::vector<float> &upper_boundary,
+                             const size_t start,
+                             const size_t end) {
+  return selection.selectEntries(start, end, lower_boundary, upper_boundary);
+}
+
+/**
+ * BBTree::planSelection(lower_bounds,upper_bounds,selection) clears selection
+ * and adds all regular (sub-)buckets that may hold matching data objects.
+ * Buckets whose zone map is disjoint with the range query are skipped, those
+ * whose zone map is contained in it are marked as fully matching.
+ */
+void BBTree::planSelection(const std::vector<float> &lower_boundary,
+                           const std::vector<float> &upper_boundary,
+                           BBTreeSelection &selection) const {
+  this->checkNoBufferPool("BBTree::SearchRange() of a selection");
+  selection.Clear();
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower_boundary,
+                                                                     upper_boundary);
+  for (size_t i = 0; i < match_buckets.size(); ++i) {
+    const size_t bucket_id = match_buckets[i];
+    if (!this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary))
+      continue;
+    const bool contained = this->zoneMapContained(bucket_id, lower_boundary,
+                                                  upper_boundary);
+    const BBTreeBucket &bucket = this->buckets[bucket_id];
+    this->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+    for (size_t z = 0; z < bucket.GetNumberOfRegularBuckets(); ++z) {
+      if (!bucket.IsRegularBucket() && !contained &&
+          !bucket.GetSuperBucket()->isRelevantForRange(z, lower_boundary,
+                                                       upper_boundary)) {
+        continue;
+      }
+      if (bucket.GetRegularBucket(z).GetNumberOfObjects() > 0)
+        selection.addBucket(&bucket.GetRegularBucket(z), contained);
+    }
+  }
+  selection.allocate();
+}
+
+/**
+ * BBTree::SearchRangeStream(lower_bounds,upper_bounds,callback,with_objects)
+ * executes the specified range query and passes the matching data objects to
+ * callback bucket by bucket (see BBTreeRangeCursor). The query stops early
+ * if callback returns false.
+ */
+void BBTree::SearchRangeStream(const std::vector<float> &lower_boundary,
+                               const std::vector<float> &upper_boundary,
+                               const std::function<bool(const BBTreeResultBatch&)> &callback,
+                               const bool with_objects) {
+  BBTreeRangeCursor cursor(*this, lower_boundary, upper_boundary,
+                           with_objects, false);
+  BBTreeResultBatch batch;
+  while (cursor.Next(batch)) {
+    if (!callback(batch))
+      break;
+  }
+}
+
+/**
+ * BBTree::SearchRangeStreamMT(lower_bounds,upper_bounds,callback,with_objects)
+ * executes the specified range query in parallel using multi-threading.
+ * The buckets are scanned by the thread pool, while callback is invoked by
+ * the calling thread only, one batch at a time. If callback is slower than
+ * the scans, at most CURSOR_QUEUE_CAPACITY batches are buffered.
+ */
+void BBTree::SearchRangeStreamMT(const std::vector<float> &lower_boundary,
+                                 const std::vector<float> &upper_boundary,
+                                 const std::function<bool(const BBTreeResultBatch&)> &callback,
+                                 const bool with_objects) {
+  BBTreeRangeCursor cursor(*this, lower_boundary, upper_boundary,
+                           with_objects, true);
+  BBTreeResultBatch batch;
+  while (cursor.Next(batch)) {
+    if (!callback(batch))
+      break;
+  }
+}
+
+/**
+ * BBTree::planCachedResult(lower_bounds,upper_bounds,match_buckets) stores
+ * all buckets that a range query reads in match_buckets (each one once),
+ * including those skipped by their zone maps, as an insertion may extend
+ * them.
+ */
+void BBTree::planCachedResult(const std::vector<float> &lower_boundary,
+                              const std::vector<float> &upper_boundary,
+                              std::vector<size_t> &match_buckets) const {
+  match_buckets = this->getBucketsForRange(lower_boundary, upper_boundary);
+  match_buckets.erase(std::unique(match_buckets.begin(), match_buckets.end()),
+                      match_buckets.end());
+}
+
+/**
+ * BBTree::planCursor(lower_bounds,upper_bounds,match_buckets) stores the
+ * buckets relevant for a streamed range query in match_buckets (each one
+ * once) and records the query in the workload monitor.
+ */
+void BBTree::planCursor(const std::vector<float> &lower_boundary,
+                        const std::vector<float> &upper_boundary,
+                        std::vector<size_t> &match_buckets) {
+  this->checkNoBufferPool("BBTreeRangeCursor");
+  match_buckets = this->getBucketsForRange(lower_boundary, upper_boundary);
+  match_buckets.erase(std::unique(match_buckets.begin(), match_buckets.end()),
+                      match_buckets.end());
+
+  // monitor query workload
+  this->monitorQuery(lower_boundary, upper_boundary);
+}
+
+/**
+ * BBTree::scanBucketBatch(bucket_id,lower_bounds,upper_bounds,with_objects,batch,bitmap)
+ * replaces the contents of batch with the matching data objects of a single
+ * bucket, using bitmap as scratch space for the selection bitmaps of its
+ * (sub-)buckets. If with_objects is set, their feature vectors are copied too.
+ */
+void BBTree::scanBucketBatch(const size_t bucket_id,
+                             const std::vector<float> &lower_boundary,
+                             const std::vector<float> &upper_boundary,
+                             const bool with_objects,
+                             BBTreeResultBatch &batch,
+                             std::vector<uint64_t> &bitmap) const {
+  batch.tids.clear();
+  batch.objects.clear();
+  batch.dimensions = this->dimensions;
+  if (!this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary))
+    return;
+  this->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+  const bool contained = this->zoneMapContained(bucket_id, lower_boundary,
+                                                upper_boundary);
+  const BBTreeBucket &bucket = this->buckets[bucket_id];
+
+  for (size_t z = 0; z < bucket.GetNumberOfRegularBuckets(); ++z) {
+    if (!bucket.IsRegularBucket() && !contained &&
+        !bucket.GetSuperBucket()->isRelevantForRange(z, lower_boundary,
+                                                     upper_boundary)) {
+      continue;
+    }
+    const BBTreeBucket &sub_bucket = bucket.GetRegularBucket(z);
+    const size_t count = sub_bucket.GetNumberOfObjects();
+    bitmap.resize((count + 63) / 64);
+    if (contained) {
+      for (size_t w = 0; w < count / 64; ++w)
+        bitmap[w] = ~((uint64_t) 0);
+      if (count % 64 != 0)
+        bitmap[count / 64] = (((uint64_t) 1) << (count % 64)) - 1;
+    } else {
+      sub_bucket.SelectRange(bitmap.data(), lower_boundary, upper_boundary);
+    }
+    sub_bucket.MaterializeRows(bitmap.data(), batch.tids,
+                               with_objects ? &batch.objects : NULL);
+  }
+}
+
+/**
+ * BBTree::ScanBuckets(id,bbtree,results,lower_bounds,upper_bounds,match_buckets,start,end)
+ * executes a range query on the relevant buckets start to end.
+ * The tids of the matching objects are stored in the std::vector results.
+ *
  * It is solely used by the parallel BB-Tree.
  */
 void BBTree::ScanBuckets(int thread_id,
@@ -286,123 +1630,625 @@ void BBTree::ScanBuckets(int thread_id,
                         const std::vector<size_t> &match_buckets,
                         const size_t start,
                         const size_t end) {
+  const size_t distance = bbtree->getPrefetchDistance();
   for (size_t i = start; i < end; ++i) {
+    bbtree->prefetchBuckets(match_buckets, i, end, distance,
+                            lower_boundary, upper_boundary);
     // do not search multiple times in a superbucket
     if (i == start || match_buckets[i] != match_buckets[i-1]) {
-      bbtree->buckets[match_buckets[i]]->SearchRange(results,
-                                                    lower_boundary,
-                                                    upper_boundary);
+      bbtree->scanBucket(results, match_buckets[i], lower_boundary,
+                         upper_boundary);
+    }
+  }
+}
+
+/**
+ * BBTree::SearchFixedRadiusNN(search_object, r) returns all data objects that
+ * are located within (Euclidean) radius r with respect to the given
+ * search_object.
+ * It returns a std::vector containing the tids of all matching objects.
+ */
+std::vector<uint32_t> BBTree::SearchFixedRadiusNN(const std::vector<float> &search_object,
+                                                 const float &r) {
+  this->checkNoBufferPool("BBTree::SearchFixedRadiusNN()");
+  return this->SearchFixedRadiusNN(search_object, r, BBTREE_METRIC_L2);
+}
+
+/**
+ * BBTree::SearchFixedRadiusNN(search_object, r, metric) returns all data
+ * objects whose distance to search_object according to the given metric is
+ * at most r.
+ * The relevant buckets are determined by the bounding box of the ball of
+ * radius r; buckets whose zone map is farther away than r are skipped, and
+ * the remaining data objects are filtered by their exact distances.
+ */
+std::vector<uint32_t> BBTree::SearchFixedRadiusNN(const std::vector<float> &search_object,
+                                                 const float &r,
+                                                 const BBTreeMetric metric) {
+  this->checkNoBufferPool("BBTree::SearchFixedRadiusNN()");
+  assert(search_object.size() == this->dimensions);
+  std::vector<uint32_t> results;
+  std::vector<float> lower(this->dimensions);
+  std::vector<float> upper(this->dimensions);
+  for (size_t i = 0; i < this->dimensions; ++i) {
+    lower[i] = search_object[i] - r;
+    upper[i] = search_object[i] + r;
+  }
+  const float max_distance = (metric == BBTREE_METRIC_L2) ? r * r : r;
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower, upper);
+
+  BBTree::ScanBucketsRadius(0, this, results, search_object, metric,
+                            max_distance, match_buckets, 0,
+                            match_buckets.size());
+
+  // monitor query workload
+  this->monitorQuery(lower, upper);
+
+  return results;
+}
+
+/**
+ * BBTree::SearchFixedRadiusNNMT(search_object, r, metric) executes a fixed
+ * radius query in parallel using multi-threading.
+ * It returns a std::vector containing the tids of all matching objects.
+ */
+std::vector<uint32_t> BBTree::SearchFixedRadiusNNMT(const std::vector<float> &search_object,
+                                                   const float &r,
+                                                   const BBTreeMetric metric) {
+  this->checkNoBufferPool("BBTree::SearchFixedRadiusNNMT()");
+  assert(search_object.size() == this->dimensions);
+  std::vector<uint32_t> results;
+  std::vector<float> lower(this->dimensions);
+  std::vector<float> upper(this->dimensions);
+  for (size_t i = 0; i < this->dimensions; ++i) {
+    lower[i] = search_object[i] - r;
+    upper[i] = search_object[i] + r;
+  }
+  const float max_distance = (metric == BBTREE_METRIC_L2) ? r * r : r;
+  const std::vector<size_t> match_buckets = this->getBucketsForRange(lower, upper);
+  const size_t num_buckets = match_buckets.size();
+  // take the current thread into account
+  const size_t dop = (num_buckets == 0) ? 0 :
+    ((num_buckets < this->num_threads) ? num_buckets : this->num_threads) - 1;
+  const size_t partition_size = num_buckets / (dop + 1);
+
+  std::future<void> *futures = new std::future<void>[dop];
+  std::vector<std::vector<uint32_t> > thread_results(dop);
+  for (size_t i = 0; i < dop; ++i) {
+    futures[i] = this->thread_pool->push(std::ref(BBTree::ScanBucketsRadius),
+                                         this,
+                                         std::ref(thread_results[i]),
+                                         std::ref(search_object),
+                                         metric,
+                                         max_distance,
+                                         std::ref(match_buckets),
+                                         i * partition_size,
+                                         (i+1) * partition_size);
+  }
+
+  // do something useful with this thread :-)
+  BBTree::ScanBucketsRadius(0, this, results, search_object, metric,
+                            max_distance, match_buckets, dop * partition_size,
+                            num_buckets);
+
+  // monitor query workload
+  this->monitorQuery(lower, upper);
+
+  // collect results from threads
+  for (size_t i = 0; i < dop; ++i) {
+    futures[i].get();
+    results.insert(std::end(results),
+                   std::begin(thread_results[i]),
+                   std::end(thread_results[i]));
+  }
+  delete [] futures;
+
+  return results;
+}
+
+/**
+ * BBTree::ScanBucketsRadius(id,bbtree,results,search_object,metric,max_distance,match_buckets,start,end)
+ * executes a fixed radius query on the relevant buckets start to end, skipping
+ * buckets whose zone map is farther away than max_distance (squared for L2).
+ * The tids of the matching objects are stored in the std::vector results.
+ */
+void BBTree::ScanBucketsRadius(int thread_id,
+                               BBTree *bbtree,
+                               std::vector<uint32_t> &results,
+                               const std::vector<float> &search_object,
+                               const BBTreeMetric metric,
+                               const float max_distance,
+                               const std::vector<size_t> &match_buckets,
+                               const size_t start,
+                               const size_t end) {
+  for (size_t i = start; i < end; ++i) {
+    const size_t bucket_id = match_buckets[i];
+    if (bbtree->buckets[bucket_id].GetNumberOfObjects() == 0 ||
+        bbtree->getZoneMapDistance(bucket_id, search_object, metric) > max_distance) {
+      continue;
+    }
+    bbtree->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+    bbtree->buckets[bucket_id].SearchRadius(search_object, metric, max_distance,
+                                            results);
+  }
+}
+
+/**
+ * BBTree::SearchKNN(search_object, k, metric) returns the tids of the k data
+ * objects closest to search_object according to the given metric, ordered by
+ * distance (ties are ordered by tid).
+ * Buckets are visited best-first in ascending order of the minimum distance
+ * of their zone maps to search_object; the search stops once the next bucket
+ * is farther away than the current k-th nearest neighbor.
+ */
+std::vector<uint32_t> BBTree::SearchKNN(const std::vector<float> &search_object,
+                                       const size_t k,
+                                       const BBTreeMetric metric) {
+  this->checkNoBufferPool("BBTree::SearchKNN()");
+  assert(search_object.size() == this->dimensions);
+  std::vector<std::pair<float, size_t> > order;
+  std::vector<std::pair<float, uint32_t> > heap;
+  std::vector<uint32_t> results;
+  if (k == 0)
+    return results;
+
+  this->orderBucketsByDistance(search_object, metric, order);
+  while (!order.empty()) {
+    // all remaining buckets are at least as far away
+    if (heap.size() == k && order.front().first > heap.front().first)
+      break;
+    const size_t bucket_id = order.front().second;
+    std::pop_heap(order.begin(), order.end(),
+                  std::greater<std::pair<float, size_t> >());
+    order.pop_back();
+    this->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+    this->buckets[bucket_id].SearchKNN(search_object, metric, k, heap);
+  }
+
+  std::sort_heap(heap.begin(), heap.end());
+  results.reserve(heap.size());
+  for (size_t i = 0; i < heap.size(); ++i)
+    results.push_back(heap[i].second);
+
+  // monitor query workload
+  if (!heap.empty())
+    this->monitorKNNQuery(search_object, heap.back().first, metric);
+
+  return results;
+}
+
+/**
+ * BBTree::SearchKNNMT(search_object, k, metric) executes a k nearest neighbor
+ * query in parallel using multi-threading.
+ * All threads take the next bucket in best-first order from a shared heap
+ * and keep a local heap of k candidates; they share the smallest k-th distance of all full heaps
+ * as pruning bound. Finally, the local heaps are merged.
+ */
+std::vector<uint32_t> BBTree::SearchKNNMT(const std::vector<float> &search_object,
+                                         const size_t k,
+                                         const BBTreeMetric metric) {
+  this->checkNoBufferPool("BBTree::SearchKNNMT()");
+  assert(search_object.size() == this->dimensions);
+  std::vector<std::pair<float, size_t> > order;
+  std::vector<uint32_t> results;
+  if (k == 0)
+    return results;
+
+  this->orderBucketsByDistance(search_object, metric, order);
+  const size_t num_buckets = order.size();
+  // take the current thread into account
+  const size_t dop = (num_buckets == 0) ? 0 :
+    ((num_buckets < this->num_threads) ? num_buckets : this->num_threads) - 1;
+  std::mutex order_mutex;
+  std::atomic<float> bound(std::numeric_limits<float>::max());
+  std::vector<std::vector<std::pair<float, uint32_t> > > heaps(dop + 1);
+
+  std::future<void> *futures = new std::future<void>[dop];
+  for (size_t i = 0; i < dop; ++i) {
+    futures[i] = this->thread_pool->push(std::ref(BBTree::ScanBucketsKNN),
+                                         this,
+                                         std::ref(search_object),
+                                         k,
+                                         metric,
+                                         std::ref(order),
+                                         std::ref(order_mutex),
+                                         std::ref(bound),
+                                         std::ref(heaps[i]));
+  }
+
+  // do something useful with this thread :-)
+  BBTree::ScanBucketsKNN(0, this, search_object, k, metric, order, order_mutex,
+                         bound, heaps[dop]);
+
+  // merge the local heaps
+  std::vector<std::pair<float, uint32_t> > candidates;
+  for (size_t i = 0; i <= dop; ++i) {
+    if (i < dop)
+      futures[i].get();
+    candidates.insert(candidates.end(), heaps[i].begin(), heaps[i].end());
+  }
+  delete [] futures;
+
+  const size_t num_results = std::min(k, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + num_results,
+                    candidates.end());
+  results.reserve(num_results);
+  for (size_t i = 0; i < num_results; ++i)
+    results.push_back(candidates[i].second);
+
+  // monitor query workload
+  if (num_results > 0)
+    this->monitorKNNQuery(search_object, candidates[num_results - 1].first,
+                          metric);
+
+  return results;
+}
+
+/**
+ * BBTree::ScanBucketsKNN(id,bbtree,search_object,k,metric,order,order_mutex,bound,heap)
+ * takes the nearest bucket from order (a heap of buckets by their minimum
+ * distances, shared by all threads and guarded by order_mutex) and scans it,
+ * until the nearest bucket is farther away than bound or the k-th distance
+ * of heap.
+ *
+ * It is solely used by the parallel k nearest neighbor search.
+ */
+void BBTree::ScanBucketsKNN(int thread_id,
+                            BBTree *bbtree,
+                            const std::vector<float> &search_object,
+                            const size_t k,
+                            const BBTreeMetric metric,
+                            std::vector<std::pair<float, size_t> > &order,
+                            std::mutex &order_mutex,
+                            std::atomic<float> &bound,
+                            std::vector<std::pair<float, uint32_t> > &heap) {
+  while (true) {
+    float kth_distance = bound.load();
+    if (heap.size() == k)
+      kth_distance = std::min(kth_distance, heap.front().first);
+    size_t bucket_id;
+    {
+      std::lock_guard<std::mutex> lock(order_mutex);
+      // all remaining buckets are at least as far away
+      if (order.empty() || order.front().first > kth_distance)
+        break;
+      bucket_id = order.front().second;
+      std::pop_heap(order.begin(), order.end(),
+                    std::greater<std::pair<float, size_t> >());
+      order.pop_back();
+    }
+    bbtree->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+    bbtree->buckets[bucket_id].SearchKNN(search_object, metric, k, heap);
+    if (heap.size() == k) {
+      float current = bound.load();
+      while (heap.front().first < current &&
+             !bound.compare_exchange_weak(current, heap.front().first)) {}
+    }
+  }
+}
+
+/**
+ * BBTree::orderBucketsByDistance(search_object,metric,order) stores all
+ * non-empty buckets in order, as a min-heap by the minimum distance of their
+ * zone map to search_object (L2 distances squared). Building the heap takes
+ * linear time; only the buckets that are scanned are popped from it.
+ * As zone maps are contained in the cells defined by the delimiters, they
+ * give a tighter bound than the cells.
+ */
+void BBTree::orderBucketsByDistance(const std::vector<float> &search_object,
+                                    const BBTreeMetric metric,
+                                    std::vector<std::pair<float, size_t> > &order) const {
+  order.clear();
+  for (size_t bucket_id = 0; bucket_id < this->num_buckets; ++bucket_id) {
+    if (this->buckets[bucket_id].GetNumberOfObjects() == 0)
+      continue;
+    order.push_back(std::make_pair(this->getZoneMapDistance(bucket_id,
+                                                            search_object,
+                                                            metric),
+                                   bucket_id));
+  }
+  std::make_heap(order.begin(), order.end(),
+                 std::greater<std::pair<float, size_t> >());
+}
+
+/**
+ * BBTree::getZoneMapDistance(bucket_id,search_object,metric) returns the
+ * minimum distance of the zone map of a non-empty bucket to search_object
+ * (squared for L2), a lower bound of the distances of its data objects.
+ */
+inline float BBTree::getZoneMapDistance(const size_t bucket_id,
+                                        const std::vector<float> &search_object,
+                                        const BBTreeMetric metric) const {
+  const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+  float distance = 0.0f;
+  for (size_t j = 0; j < this->dimensions; ++j) {
+    float difference = 0.0f;
+    if (search_object[j] < zone_map[j])
+      difference = zone_map[j] - search_object[j];
+    else if (search_object[j] > zone_map[this->dimensions + j])
+      difference = search_object[j] - zone_map[this->dimensions + j];
+    distance = BBTreeBucket::AccumulateDistance(distance, difference, metric);
+  }
+  return distance;
+}
+
+/**
+ * BBTree::getNumberOfNodesInTreeOfHeight(h) returns the number of
+ * inner nodes in a k-ary tree of height h.
+ * Implemented according to https://en.wikipedia.org/wiki/K-ary_tree
+ */
+size_t BBTree::getNumberOfNodesInTreeOfHeight(const size_t height) const {
+  return ((pow((this->delimiters_per_split+1), height)-1) / (this->delimiters_per_split));
+}
+
+/**
+ * BBTree::getBucketsForRange(lower_bounds,upper_bounds) returns the buckets
+ * relevant for a given range query.
+ */
+inline std::vector<size_t> BBTree::getBucketsForRange(const std::vector<float> &lower_boundary,
+                                                     const std::vector<float> &upper_boundary) const {
+  std::vector<size_t> buckets;
+  std::vector<size_t> next_nodes;
+  this->getBucketsForRange(lower_boundary, upper_boundary, buckets, next_nodes);
+
+  return buckets;
+}
+
+/**
+ * BBTree::getBucketsForRange(lower_bounds,upper_bounds,buckets,next_nodes)
+ * stores the buckets relevant for a given range query in buckets, using
+ * next_nodes as scratch space. Neither allocates memory if their capacities
+ * suffice.
+ * The relevant nodes of a level are identified by their index i within the
+ * level; the k children of node i are the nodes i*k to i*k+k-1 of the next
+ * level (k = delimiters_per_split + 1), and the nodes below the last level
+ * are the buckets.
+ */
+inline void BBTree::getBucketsForRange(const std::vector<float> &lower_boundary,
+                                       const std::vector<float> &upper_boundary,
+                                       std::vector<size_t> &buckets,
+                                       std::vector<size_t> &next_nodes) const {
+  buckets.clear();
+  buckets.push_back(0);
+  if (this->num_buckets == 1)
+    return;
+
+  const size_t delimiters = this->delimiters_per_split;
+  // number of nodes above the current level
+  size_t level_offset = 0;
+  size_t level_size = 1;
+  for (size_t i = 0; i < this->height; ++i) {
+    const size_t dimension = this->delimiter_dimensions[i];
+    next_nodes.clear();
+    for (size_t j = 0; j < buckets.size(); ++j) {
+      const size_t position = (level_offset + buckets[j]) * delimiters;
+      const size_t first_child = buckets[j] * (delimiters + 1);
+      if (this->delimiter_values[position] >= lower_boundary[dimension])
+        next_nodes.push_back(first_child);
+      for (size_t k = 1; k < delimiters; ++k) {
+        if (this->delimiter_values[position + k - 1] > upper_boundary[dimension])
+          break;
+        if (this->delimiter_values[position + k] >= lower_boundary[dimension] &&
+            this->delimiter_values[position + k - 1] <= upper_boundary[dimension]) {
+          next_nodes.push_back(first_child + k);
+        }
+      }
+      if (this->delimiter_values[position + delimiters - 1] <
+          upper_boundary[dimension]) {
+        next_nodes.push_back(first_child + delimiters);
+      }
+    }
+    buckets.swap(next_nodes);
+    level_offset += level_size;
+    level_size *= delimiters + 1;
+  }
+}
+
+/**
+ * BBTree::getBucketsForRanges(lower_bounds,upper_bounds,buckets,bucket_boxes)
+ * stores the buckets relevant for any of the given range queries (boxes) in
+ * buckets and the indexes of the boxes relevant for buckets[i] in
+ * bucket_boxes[i].
+ * The tree is traversed once: every relevant node carries the boxes that
+ * intersect its cell, and a child is visited if it is relevant for at least
+ * one of them (see getBucketsForRange()).
+ */
+void BBTree::getBucketsForRanges(const std::vector<std::vector<float> > &lower_boundaries,
+                                 const std::vector<std::vector<float> > &upper_boundaries,
+                                 std::vector<size_t> &buckets,
+                                 std::vector<std::vector<uint32_t> > &bucket_boxes) const {
+  buckets.assign(1, 0);
+  bucket_boxes.assign(1, std::vector<uint32_t>());
+  for (size_t b = 0; b < lower_boundaries.size(); ++b)
+    bucket_boxes[0].push_back(b);
+  if (this->num_buckets == 1)
+    return;
+
+  const size_t delimiters = this->delimiters_per_split;
+  std::vector<size_t> next_nodes;
+  std::vector<std::vector<uint32_t> > next_boxes;
+  std::vector<std::vector<uint32_t> > child_boxes(delimiters + 1);
+  // number of nodes above the current level
+  size_t level_offset = 0;
+  size_t level_size = 1;
+  for (size_t i = 0; i < this->height; ++i) {
+    const size_t dimension = this->delimiter_dimensions[i];
+    next_nodes.clear();
+    next_boxes.clear();
+    for (size_t j = 0; j < buckets.size(); ++j) {
+      const size_t position = (level_offset + buckets[j]) * delimiters;
+      const float* values = this->delimiter_values + position;
+      for (size_t c = 0; c <= delimiters; ++c)
+        child_boxes[c].clear();
+      for (size_t b = 0; b < bucket_boxes[j].size(); ++b) {
+        const uint32_t box = bucket_boxes[j][b];
+        const float lower = lower_boundaries[box][dimension];
+        const float upper = upper_boundaries[box][dimension];
+        if (values[0] >= lower)
+          child_boxes[0].push_back(box);
+        for (size_t c = 1; c < delimiters && values[c - 1] <= upper; ++c) {
+          if (values[c] >= lower)
+            child_boxes[c].push_back(box);
+        }
+        if (values[delimiters - 1] < upper)
+          child_boxes[delimiters].push_back(box);
+      }
+      for (size_t c = 0; c <= delimiters; ++c) {
+        if (child_boxes[c].empty())
+          continue;
+        next_nodes.push_back(buckets[j] * (delimiters + 1) + c);
+        next_boxes.push_back(child_boxes[c]);
+      }
+    }
+    buckets.swap(next_nodes);
+    bucket_boxes.swap(next_boxes);
+    level_offset += level_size;
+    level_size *= delimiters + 1;
+  }
+}
+
+/**
+ * BBTree::getJoinBucketPairs(other,epsilon,metric,bucket_pairs) stores all
+ * pairs (bucket, bucket of other) whose zone maps are at most epsilon apart
+ * in bucket_pairs, grouped by the bucket of other.
+ * The zone maps of all buckets, extended by epsilon, co-traverse the inner
+ * nodes of other once (see getBucketsForRanges()).
+ */
+void BBTree::getJoinBucketPairs(const BBTree &other,
+                                const float epsilon,
+                                const BBTreeMetric metric,
+                                std::vector<std::pair<size_t, size_t> > &bucket_pairs) const {
+  assert(this->dimensions == other.dimensions);
+  const float max_distance = (metric == BBTREE_METRIC_L2) ?
+    epsilon * epsilon : epsilon;
+  std::vector<size_t> join_buckets;
+  std::vector<std::vector<float> > lower_boundaries;
+  std::vector<std::vector<float> > upper_boundaries;
+  for (size_t i = 0; i < this->num_buckets; ++i) {
+    if (this->buckets[i].GetNumberOfObjects() == 0)
+      continue;
+    const float* zone_map = this->zone_maps + 2 * this->dimensions * i;
+    join_buckets.push_back(i);
+    lower_boundaries.push_back(std::vector<float>(this->dimensions));
+    upper_boundaries.push_back(std::vector<float>(this->dimensions));
+    for (size_t j = 0; j < this->dimensions; ++j) {
+      lower_boundaries.back()[j] = zone_map[j] - epsilon;
+      upper_boundaries.back()[j] = zone_map[this->dimensions + j] + epsilon;
+    }
+  }
+
+  std::vector<size_t> other_buckets;
+  std::vector<std::vector<uint32_t> > bucket_boxes;
+  other.getBucketsForRanges(lower_boundaries, upper_boundaries, other_buckets,
+                            bucket_boxes);
+  bucket_pairs.clear();
+  for (size_t i = 0; i < other_buckets.size(); ++i) {
+    const size_t other_id = other_buckets[i];
+    if (other.buckets[other_id].GetNumberOfObjects() == 0)
+      continue;
+    const float* other_zone_map = other.zone_maps + 2 * other.dimensions * other_id;
+    for (size_t b = 0; b < bucket_boxes[i].size(); ++b) {
+      const size_t bucket_id = join_buckets[bucket_boxes[i][b]];
+      const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+      // distance of the two zone maps
+      float distance = 0.0f;
+      for (size_t j = 0; j < this->dimensions; ++j) {
+        float difference = 0.0f;
+        if (zone_map[this->dimensions + j] < other_zone_map[j])
+          difference = other_zone_map[j] - zone_map[this->dimensions + j];
+        else if (other_zone_map[this->dimensions + j] < zone_map[j])
+          difference = zone_map[j] - other_zone_map[this->dimensions + j];
+        distance = BBTreeBucket::AccumulateDistance(distance, difference, metric);
+      }
+      if (distance <= max_distance)
+        bucket_pairs.push_back(std::make_pair(bucket_id, other_id));
     }
   }
 }
 
 /**
- * BBTree::SearchFixedRadiusNN(search_object, r) returns all data objects that
- * are located within radius r with respect to the given search_object.
- * It returns a std::vector containing the tids of all matching objects.
+ * BBTree::flattenJoinResults(results) converts the matches per box into
+ * pairs (box index, tid).
  */
-std::vector<uint32_t> BBTree::SearchFixedRadiusNN(const std::vector<float> &search_object,
-                                                 const float &r) {
-  // transform the rNN query into a conventional range query
-  std::vector<float> lower(this->dimensions);
-  std::vector<float> upper(this->dimensions);
-  for (size_t i = 0; i < this->dimensions; ++i) {
-    lower[i] = search_object[i] - r/2.0;
-    upper[i] = search_object[i] + r/2.0;
+std::vector<std::pair<uint32_t, uint32_t> > BBTree::flattenJoinResults(const std::vector<std::vector<uint32_t> > &results) {
+  size_t num_pairs = 0;
+  for (size_t b = 0; b < results.size(); ++b)
+    num_pairs += results[b].size();
+
+  std::vector<std::pair<uint32_t, uint32_t> > pairs;
+  pairs.reserve(num_pairs);
+  for (size_t b = 0; b < results.size(); ++b) {
+    for (size_t i = 0; i < results[b].size(); ++i)
+      pairs.push_back(std::make_pair((uint32_t) b, results[b][i]));
   }
 
-  return this->SearchRange(lower, upper);
+  return pairs;
 }
 
 /**
- * BBTree::getNumberOfNodesInTreeOfHeight(h) returns the number of
- * inner nodes in a k-ary tree of height h.
- * Implemented according to https://en.wikipedia.org/wiki/K-ary_tree
+ * BBTree::getOverlapFraction(minimum,maximum,lower,upper) returns the fraction
+ * of the interval [minimum, maximum] that is covered by [lower, upper].
+ * A single-value interval is covered completely or not at all. Intervals with
+ * integral bounds (e.g., positions or chromosomes) are treated as discrete
+ * domains, so equality predicates do not yield empty estimates.
  */
-size_t BBTree::getNumberOfNodesInTreeOfHeight(const size_t height) const {
-  return ((pow((DELIMITERS_PER_SPLIT+1), height)-1) / (DELIMITERS_PER_SPLIT));
+inline double BBTree::getOverlapFraction(const float minimum,
+                                         const float maximum,
+                                         const float lower,
+                                         const float upper) {
+  if (maximum <= minimum)
+    return (lower <= minimum && minimum <= upper) ? 1.0 : 0.0;
+  if (std::floor(minimum) == minimum && std::floor(maximum) == maximum) {
+    const double first = std::ceil(std::max(minimum, lower));
+    const double last = std::floor(std::min(maximum, upper));
+    if (last < first)
+      return 0.0;
+    return (last - first + 1.0) / ((double) maximum - (double) minimum + 1.0);
+  }
+  const double covered = (double) std::min(maximum, upper) -
+                         (double) std::max(minimum, lower);
+  if (covered <= 0.0)
+    return 0.0;
+  return std::min(1.0, covered / ((double) maximum - (double) minimum));
 }
 
 /**
- * BBTree::getBucketsForRange(lower_bounds,upper_bounds) returns the buckets
- * relevant for a given range query.
+ * BBTree::monitorQuery(lower_bounds,upper_bounds) records a range query in the
+ * workload monitor, a ring buffer of the last MONITOR_WORKLOAD_WINDOW queries.
+ * Once the ring buffer is full, the boundaries are copied into the vectors of
+ * the oldest query, so monitoring does not allocate memory.
  */
-inline std::vector<size_t> BBTree::getBucketsForRange(const std::vector<float> &lower_boundary,
-                                                     const std::vector<float> &upper_boundary) const {
-  std::vector<size_t> buckets;
-  if (this->num_buckets == 1) {
-    buckets.push_back(0);
-    return buckets;
-  }
-  std::vector<size_t> positions(1,0);
-  std::vector<std::vector<size_t> > rel_positions(1, std::vector<size_t>());
-
-  for (size_t i = 0; i < this->height; ++i) {
-    const size_t dimension = this->delimiter_dimensions[i];
-    const size_t num_positions = positions.size();
-    for (size_t j = 0; j < num_positions; ++j) {
-        if (this->delimiter_values[positions[j]] >= lower_boundary[dimension]) {
-          std::vector<size_t> new_rel_pos = rel_positions[j];
-          new_rel_pos.push_back(0);
-          size_t times = 0;
-          size_t new_pos = 0;
-          for (int m = new_rel_pos.size(); m > 0; m--) {
-            new_pos += new_rel_pos[m - 1] * pow((DELIMITERS_PER_SPLIT+1), times++);
-          }
-          new_pos = (this->getNumberOfNodesInTreeOfHeight(i+1) + new_pos) *
-                    DELIMITERS_PER_SPLIT;
-          positions.push_back(new_pos);
-          rel_positions.push_back(new_rel_pos);
-        }
-      for (size_t k = 1; k < DELIMITERS_PER_SPLIT; ++k) {
-        if (this->delimiter_values[positions[j] + k-1] > upper_boundary[dimension]) {
-          break;
-        }
-        if (this->delimiter_values[positions[j] + k] >= lower_boundary[dimension] &&
-            this->delimiter_values[positions[j] + k - 1] <= upper_boundary[dimension]) {
-          std::vector<size_t> new_rel_pos = rel_positions[j];
-          new_rel_pos.push_back(k);
-          size_t times = 0;
-          size_t new_pos = 0;
-          for (int m = new_rel_pos.size(); m > 0; m--) {
-            new_pos += new_rel_pos[m - 1] *
-                       pow((DELIMITERS_PER_SPLIT+1), times++);
-          }
-          new_pos = (this->getNumberOfNodesInTreeOfHeight(i+1) + new_pos) *
-                    DELIMITERS_PER_SPLIT;
-          positions.push_back(new_pos);
-          rel_positions.push_back(new_rel_pos);
-        }
-      }
-      if (this->delimiter_values[positions[j] + DELIMITERS_PER_SPLIT - 1] <
-          upper_boundary[dimension]) {
-          std::vector<size_t> new_rel_pos = rel_positions[j];
-          new_rel_pos.push_back(DELIMITERS_PER_SPLIT);
-          size_t times = 0;
-          size_t new_pos = 0;
-          for (int m = new_rel_pos.size(); m > 0; m--) {
-            new_pos += new_rel_pos[m - 1] *
-                       pow((DELIMITERS_PER_SPLIT+1), times++);
-          }
-          new_pos = (this->getNumberOfNodesInTreeOfHeight(i+1) + new_pos) *
-                    DELIMITERS_PER_SPLIT;
-          positions.push_back(new_pos);
-          rel_positions.push_back(new_rel_pos);
-      }
-    }
-    positions.erase(positions.begin(), positions.begin() + num_positions);
-    rel_positions.erase(rel_positions.begin(),
-                        rel_positions.begin() + num_positions);
+inline void BBTree::monitorQuery(const std::vector<float> &lower_boundary,
+                                 const std::vector<float> &upper_boundary) {
+  this->num_monitored_queries++;
+  if (this->last_lower_bounds.size() < MONITOR_WORKLOAD_WINDOW) {
+    this->last_lower_bounds.push_back(lower_boundary);
+    this->last_upper_bounds.push_back(upper_boundary);
+    return;
   }
+  this->last_lower_bounds[this->monitor_position] = lower_boundary;
+  this->last_upper_bounds[this->monitor_position] = upper_boundary;
+  this->monitor_position = (this->monitor_position + 1) % MONITOR_WORKLOAD_WINDOW;
+}
 
-  for (size_t i = 0; i < positions.size(); ++i) {
-    buckets.push_back((positions[i] -
-                       (this->getNumberOfNodesInTreeOfHeight(this->height) *
-                        DELIMITERS_PER_SPLIT)) /
-                      DELIMITERS_PER_SPLIT);
+/**
+ * BBTree::monitorKNNQuery(search_object,distance,metric) records a k nearest
+ * neighbor query in the workload monitor as the bounding box of the ball
+ * around search_object whose radius is the distance of the k-th nearest
+ * neighbor (squared for L2), i.e., the region the query had to inspect.
+ */
+void BBTree::monitorKNNQuery(const std::vector<float> &search_object,
+                             const float distance,
+                             const BBTreeMetric metric) {
+  const float radius = (metric == BBTREE_METRIC_L2) ? std::sqrt(distance) :
+                                                      distance;
+  std::vector<float> lower(this->dimensions);
+  std::vector<float> upper(this->dimensions);
+  for (size_t i = 0; i < this->dimensions; ++i) {
+    lower[i] = search_object[i] - radius;
+    upper[i] = search_object[i] + radius;
   }
-
-  return buckets;
+  this->monitorQuery(lower, upper);
 }
 
 /**
@@ -416,79 +2262,92 @@ inline std::vector<size_t> BBTree::getBucketOfFeatureVector(const std::vector<fl
     buckets.push_back(0);
     return buckets;
   }
-  size_t bucket = 0;
-  size_t rel_pos = 0;
+  const size_t k = this->delimiters_per_split;
+  size_t offset = 0;
+  size_t node = 0;
   size_t add_buckets = 1;
-  std::vector<size_t> rel_positions;
 
   for (size_t i = 0; i < this->height; ++i) {
-    rel_pos = 0;
-    const size_t dimension = this->delimiter_dimensions[i];
-    size_t first   = 0;
-    size_t last    = DELIMITERS_PER_SPLIT - 1;
-    size_t middle  = 0;
-
-    // binary search linearized inner node
-    while (first < last) {
-      middle = (first + last) / 2;
-      if (this->delimiter_values[bucket + middle] <
-          feature_vector[dimension]) {
-        first = middle + 1; 
-      } else if (this->delimiter_values[bucket + middle] ==
-                 feature_vector[dimension]) {
-        rel_pos = middle;
-        break;
-      } else {
-        last = middle - 1;
-      }
-    }
-    if (first >= last) {
-      rel_pos = first;
-    }
-    if (feature_vector[dimension] > this->delimiter_values[bucket + rel_pos]) {
-      rel_pos++;
-    }
-    while (rel_pos > 0 &&
-           rel_pos < DELIMITERS_PER_SPLIT && 
-           this->delimiter_values[bucket + rel_pos] == 
-           this->delimiter_values[bucket + rel_pos - 1]) {
-      rel_pos--;
-    }
-
+    const size_t rel_pos = this->searchInnerNode(
+      feature_vector[this->delimiter_dimensions[i]], offset);
     // check for duplicates on last level
-    if (i == this->height - 1) {
-      for (size_t k = 1; k < (DELIMITERS_PER_SPLIT - rel_pos); ++k) {
-        if (this->delimiter_values[bucket + rel_pos] ==
-            this->delimiter_values[bucket + rel_pos + k]) {
-          add_buckets++;
-        } else {
-          break;
-        }
-      }
-    }
-
-    rel_positions.push_back(rel_pos);
-    size_t level = 0;
-    bucket = 0;
-    // rel_positions is of size k (the variable)
-    for (int m = rel_positions.size(); m > 0; m--) {
-      bucket += rel_positions[m - 1] * pow((DELIMITERS_PER_SPLIT+1), level++);
-    }
-    bucket = (this->getNumberOfNodesInTreeOfHeight(i+1) + bucket) *
-      DELIMITERS_PER_SPLIT;
+    if (i == this->height - 1)
+      add_buckets = this->getNumberOfEqualDelimiters(offset, rel_pos);
+    node = node * (k + 1) + rel_pos;
+    offset = (this->getNumberOfNodesInTreeOfHeight(i+1) + node) * k;
   }
-  bucket = (bucket - (this->getNumberOfNodesInTreeOfHeight(this->height)
-                * DELIMITERS_PER_SPLIT))
-            / DELIMITERS_PER_SPLIT;
 
   // consider multiple buckets on the last level
   for (size_t i = 0; i < add_buckets; ++i) {
-    buckets.push_back(bucket + i);
+    buckets.push_back(node + i);
   }
 
   return buckets;
 }
 
+/**
+ * BBTree::searchInnerNode(value,offset) binary searches the linearized inner
+ * node starting at the given offset of delimiter_values and returns the
+ * child that a point query with the given value in the delimiter dimension of
+ * the node descends into.
+ * If the value equals a sequence of duplicate delimiters, it returns the
+ * first of them.
+ */
+inline size_t BBTree::searchInnerNode(const float value,
+                                      const size_t offset) const {
+  size_t rel_pos = 0;
+  size_t first   = 0;
+  size_t last    = this->delimiters_per_split - 1;
+  size_t middle  = 0;
+
+  // binary search linearized inner node
+  while (first < last) {
+    middle = (first + last) / 2;
+    if (this->delimiter_values[offset + middle] < value) {
+      first = middle + 1;
+    } else if (this->delimiter_values[offset + middle] == value) {
+      rel_pos = middle;
+      break;
+    } else {
+      last = middle - 1;
+    }
+  }
+  if (first >= last) {
+    rel_pos = first;
+  }
+  if (value > this->delimiter_values[offset + rel_pos]) {
+    rel_pos++;
+  }
+  while (rel_pos > 0 &&
+         rel_pos < this->delimiters_per_split &&
+         this->delimiter_values[offset + rel_pos] ==
+         this->delimiter_values[offset + rel_pos - 1]) {
+    rel_pos--;
+  }
+
+  return rel_pos;
+}
+
+/**
+ * BBTree::getNumberOfEqualDelimiters(offset,rel_pos) returns the number of
+ * children of the inner node starting at the given offset that may hold data
+ * objects equal to delimiter rel_pos in the delimiter dimension, i.e., one
+ * plus the number of duplicates following that delimiter.
+ */
+inline size_t BBTree::getNumberOfEqualDelimiters(const size_t offset,
+                                                 const size_t rel_pos) const {
+  size_t num_children = 1;
+  for (size_t k = 1; k < (this->delimiters_per_split - rel_pos); ++k) {
+    if (this->delimiter_values[offset + rel_pos] ==
+        this->delimiter_values[offset + rel_pos + k]) {
+      num_children++;
+    } else {
+      break;
+    }
+  }
+  return num_children;
+}
+
 /**
  * BBTree::getBucketOfFeatureVectorForInsert determines the bucket relevant for
  * inserting a given feature vector.
@@ -497,26 +2356,50 @@ inline std::vector<size_t> BBTree::getBucketOfFeatureVector(const std::vector<fl
  */
 inline size_t BBTree::getBucketOfFeatureVectorForInsert(const std::vector<float> &feature_vector,
                                                        const bool debug) const {
-  size_t bucket = 0;
   if (this->num_buckets == 1)
-    return bucket;
+    return 0;
 
-  std::vector<size_t> rel_positions;
+  return this->locateBucketForInsert(feature_vector,
+                                     this->height,
+                                     this->delimiter_dimensions,
+                                     this->delimiter_values);
+}
 
-  for (size_t i = 0; i < this->height; ++i) {
-    const size_t dimension = this->delimiter_dimensions[i];
+/**
+ * BBTree::locateBucketForInsert(feature_vector,height,dimensions,values)
+ * returns the bucket that a new data object is inserted into, given inner
+ * nodes of the specified height, delimiter dimensions and delimiter values.
+ * If a data object equals a delimiter value on the last level that has
+ * duplicates, one of the corresponding buckets is chosen randomly.
+ * It is used for inserts and for re-partitioning data objects when
+ * rebuilding the inner nodes.
+ */
+inline size_t BBTree::locateBucketForInsert(const std::vector<float> &feature_vector,
+                                            const size_t height,
+                                            const int* delimiter_dimensions,
+                                            const float* delimiter_values) const {
+  const size_t k = this->delimiters_per_split;
+  size_t bucket = 0;
+  // position of the current node within its level
+  size_t node = 0;
+
+  for (size_t i = 0; i < height; ++i) {
+    const size_t dimension = delimiter_dimensions[i];
     size_t rel_pos = 0;
-    if (i == (this->height - 1)) {
+    if (i == (height - 1)) {
       int first = 0;
       int last = 0;
-      for (size_t j = 0; j < DELIMITERS_PER_SPLIT; ++j) {
-        if (feature_vector[dimension] <= this->delimiter_values[bucket]) {
+      for (size_t j = 0; j < k; ++j) {
+        if (feature_vector[dimension] <= delimiter_values[bucket]) {
           first = rel_pos;
           last = rel_pos;
-          for (size_t k = 1; k < (DELIMITERS_PER_SPLIT - j); ++k) {
-            if (this->delimiter_values[bucket] ==
-                this->delimiter_values[bucket + k]) {
-              last = rel_pos + k;
+          // the buckets behind duplicates only hold data objects equal to
+          // them, which range queries below them do not visit
+          if (feature_vector[dimension] < delimiter_values[bucket])
+            break;
+          for (size_t l = 1; l < (k - j); ++l) {
+            if (delimiter_values[bucket] == delimiter_values[bucket + l]) {
+              last = rel_pos + l;
             } else {
               break;
             }
@@ -527,7 +2410,7 @@ inline size_t BBTree::getBucketOfFeatureVectorForInsert(const std::vector<float>
           rel_pos++;
         }
       }
-      if (rel_pos != DELIMITERS_PER_SPLIT) {
+      if (rel_pos != k) {
         if (last > first) {
           rel_pos = first + (rand() % (last-first));
         } else {
@@ -535,8 +2418,8 @@ inline size_t BBTree::getBucketOfFeatureVectorForInsert(const std::vector<float>
         }
       }
     } else {
-      for (size_t j = 0; j < DELIMITERS_PER_SPLIT; ++j) {
-        if (feature_vector[dimension] <= this->delimiter_values[bucket]) {
+      for (size_t j = 0; j < k; ++j) {
+        if (feature_vector[dimension] <= delimiter_values[bucket]) {
           break;
         } else {
           bucket++;
@@ -544,48 +2427,31 @@ inline size_t BBTree::getBucketOfFeatureVectorForInsert(const std::vector<float>
         }
       }
     }
-    rel_positions.push_back(rel_pos);
-    size_t level = 0;
-    bucket = 0;
-    // rel_positions is of size k (the variable)
-    for (int m = rel_positions.size(); m > 0; m--) {
-      bucket += rel_positions[m - 1] * pow((DELIMITERS_PER_SPLIT+1), level++);
-    }
-    bucket = (this->getNumberOfNodesInTreeOfHeight(i+1) + bucket) *
-      DELIMITERS_PER_SPLIT;
+    node = node * (k + 1) + rel_pos;
+    bucket = (this->getNumberOfNodesInTreeOfHeight(i+1) + node) * k;
   }
 
-  bucket = (bucket - (this->getNumberOfNodesInTreeOfHeight(this->height)
-                * DELIMITERS_PER_SPLIT))
-            / DELIMITERS_PER_SPLIT;
-
-  return bucket;
+  return node;
 }
 
 /**
  * BBTree::transformRegularIntoSuperBucket(bucket_id) transforms an
- * overflowing BBTreeRegularBucket into a BBTreeSuperBucket.
+ * overflowing regular bucket into a superbucket.
  * 
  * It determines a new delimiter dimension and z-1 delimiter values,
  * which are used to divide the data objects into the z new buckets.
  */
 inline void BBTree::transformRegularIntoSuperBucket(const size_t bucket_id) {
-  std::vector<std::vector<float> > data_objects;
-  BBTreeBucket* bucket = this->buckets[bucket_id];
-
-  for (size_t i = 0; i < bucket->GetNumberOfObjects(); ++i) {
-    data_objects.push_back(bucket->GetObject(i));
-    // preserve tid for sorting
-    data_objects[i].push_back((float) bucket->GetTid(i));
-  }
+  const BBTreeBucket &bucket = this->buckets[bucket_id];
+  const size_t num_objects = bucket.GetNumberOfObjects();
 
   // determine delimiter dimension
   std::vector<std::vector<int> > distinct_values =
     std::vector<std::vector<int> >(this->dimensions, std::vector<int>(2));
+  std::vector<float> dim_values = std::vector<float>(num_objects);
   for (size_t i = 0; i < this->dimensions; ++i) {
-    std::vector<float> dim_values = std::vector<float>(data_objects.size()); 
-    for (size_t j = 0; j < data_objects.size(); ++j) {
-            dim_values[j] = data_objects[j][i];
+    for (size_t j = 0; j < num_objects; ++j) {
+            dim_values[j] = bucket.GetValue(j, i);
     }
     std::sort(dim_values.begin(), dim_values.end());
     // get number of distinct values for dimension i
@@ -603,48 +2469,51 @@ inline void BBTree::transformRegularIntoSuperBucket(const size_t bucket_id) {
   const size_t delimiter_dimension = (size_t) distinct_values[0][0];
 
   // determine delimiter values
-  DimensionCompare cmp(delimiter_dimension);
-  std::sort(data_objects.begin(), data_objects.end(), cmp);
-  float* delimiter_values = new float[SUPER_BUCKET_SIZE - 1];
-  const size_t range_size = data_objects.size() / SUPER_BUCKET_SIZE;
+  for (size_t j = 0; j < num_objects; ++j) {
+    dim_values[j] = bucket.GetValue(j, delimiter_dimension);
+  }
+  std::sort(dim_values.begin(), dim_values.end());
+  std::vector<float> delimiter_values(SUPER_BUCKET_SIZE - 1);
+  const size_t range_size = num_objects / SUPER_BUCKET_SIZE;
   for (size_t i = 1; i < SUPER_BUCKET_SIZE; ++i) {
-    delimiter_values[i - 1] = data_objects[i * range_size][delimiter_dimension];
+    delimiter_values[i - 1] = dim_values[i * range_size];
   }
-  BBTreeBucket* new_bucket = new BBTreeSuperBucket(SUPER_BUCKET_SIZE,
-                                             delimiter_dimension,
-                                             delimiter_values);
+  BBTreeSuperBucket* super_bucket = new BBTreeSuperBucket(SUPER_BUCKET_SIZE,
+                                                          delimiter_dimension,
+                                                          delimiter_values);
 
-  size_t tid = 0;
   // insert data objects into new superbucket
-  for (size_t i = 0; i < data_objects.size(); ++i) {
-    tid = data_objects[i][this->dimensions];
-    data_objects[i].pop_back();
-    new_bucket->InsertObject(data_objects[i], tid);
+  for (size_t i = 0; i < num_objects; ++i) {
+    const std::vector<float> feature_vector = bucket.GetObject(i);
+    super_bucket->buckets[super_bucket->getBucket(feature_vector)]
+      .InsertObject(feature_vector, bucket.GetTid(i));
   }
 
-  delete this->buckets[bucket_id];
-  this->buckets[bucket_id] = new_bucket;
+  this->buckets[bucket_id].Clear();
+  this->buckets[bucket_id].MakeSuperBucket(super_bucket);
+  if (this->use_tid_directory)
+    this->refreshTidDirectory(bucket_id);
 }
 
 /**
  * BBTree::transformSuperIntoRegularBucket(bucket_id) transforms an
- * underflowing BBTreeSuperBucket into a BBTreeRegularBucket.
+ * underflowing superbucket into a regular bucket.
  */
 inline void BBTree::transformSuperIntoRegularBucket(const size_t bucket_id) {
-  BBTreeBucket* new_bucket = new BBTreeRegularBucket();
-
-  for (size_t i = 0; i < SUPER_BUCKET_SIZE; ++i) {
-    std::vector<std::vector<float> > &data_objects =
-      ((BBTreeSuperBucket*) this->buckets[bucket_id])->GetDataObjects(i);
-    std::vector<uint32_t> &tids =
-      ((BBTreeSuperBucket*) this->buckets[bucket_id])->GetTids(i);
-    for (size_t j = 0; j < data_objects.size(); ++j) {
-      new_bucket->InsertObject(data_objects[j], tids[j]);
+  BBTreeBucket new_bucket;
+  const BBTreeBucket &bucket = this->buckets[bucket_id];
+  this->configureBucket(new_bucket);
+
+  for (size_t i = 0; i < bucket.GetNumberOfRegularBuckets(); ++i) {
+    const BBTreeBucket &sub_bucket = bucket.GetRegularBucket(i);
+    for (size_t j = 0; j < sub_bucket.GetNumberOfObjects(); ++j) {
+      new_bucket.InsertObject(sub_bucket.GetObject(j), sub_bucket.GetTid(j));
     }
   }
 
-  delete this->buckets[bucket_id];
-  this->buckets[bucket_id] = new_bucket;
+  this->buckets[bucket_id].Swap(new_bucket);
+  if (this->use_tid_directory)
+    this->refreshTidDirectory(bucket_id);
 }
 
 /**
@@ -653,22 +2522,36 @@ inline void BBTree::transformSuperIntoRegularBucket(const size_t bucket_id) {
  * If workload statistics are available, it reorganizes the delimiter
  * dimensions according to the single-dimension selectivities of the last
  * executed range queries.
+ * With a buffer pool, at most as many old and new buckets as the pool has
+ * frames are kept in memory at a time, and every old bucket is read once;
+ * the new buckets are not read back.
  * This function is very huge and legacy; it may need a complete rewrite ;-)
  */
 void BBTree::RebuildDelimiters() {
   // retrieve samples
   const size_t num_samples = this->count * REBUILD_SAMPLE_SIZE;
   std::vector<std::vector<float> > samples(num_samples);
+  std::vector<size_t> sample_buckets((this->buffer_pool != NULL) ? num_samples : 0);
   for (size_t i = 0; i < num_samples; ++i) {
     int rand_bucket;
     int bucket_size;
     while (true) {
       rand_bucket = rand () % this->num_buckets;
-      bucket_size = this->buckets[rand_bucket]->GetNumberOfObjects();
+      bucket_size = this->getNumberOfObjects(rand_bucket);
       if (bucket_size > 0)
         break;
     }
-    samples[i] = this->buckets[rand_bucket]->GetRandomObject();
+    // spilled buckets are sampled bucket by bucket below
+    if (this->buffer_pool != NULL)
+      sample_buckets[i] = rand_bucket;
+    else
+      samples[i] = this->buckets[rand_bucket].GetRandomObject();
+  }
+  if (this->buffer_pool != NULL)
+    this->sampleSpilledBuckets(sample_buckets, samples);
+  // re-evaluate bucket sizes and fanout for the current data distribution
+  if (this->auto_tuning && num_samples > 0) {
+    this->applyTuning(samples);
   }
   std::vector<std::vector<double> > avg_selectivities(this->dimensions,
                                                      std::vector<double>(2, 0.0));
@@ -679,10 +2562,9 @@ void BBTree::RebuildDelimiters() {
   // if queries have been recorded, use them to determine the average
   // selectivities that the single dimensions are typically queried with
   if (this->last_lower_bounds.size() > 0) {
-    size_t num_queries = 0;
-    for (int i = this->last_lower_bounds.size() - 1; i >= 0; --i) {
-      if (++num_queries >= MONITOR_WORKLOAD_WINDOW)
-        break;
+    // the monitor holds at most the last MONITOR_WORKLOAD_WINDOW queries
+    const size_t num_queries = this->last_lower_bounds.size();
+    for (size_t i = 0; i < num_queries; ++i) {
       for (size_t j = 0; j < samples.size(); ++j) {
         for (size_t k = 0; k < this->dimensions; ++k) {
           if (this->last_lower_bounds[i][k] <= samples[j][k] &&
@@ -695,7 +2577,7 @@ void BBTree::RebuildDelimiters() {
     for (size_t i = 0; i < this->dimensions; ++i) {
       avg_selectivities[i][1] = (avg_selectivities[i][1] /
                                  (double) samples.size()) /
-                                 (double) (num_queries-1);
+                                 (double) num_queries;
     }
     // sort by average selectivity such that high selectivities are
     // moved to the beginning (top of the tree)
@@ -706,14 +2588,14 @@ void BBTree::RebuildDelimiters() {
   }
 
   // determine new number of buckets and new tree height
-  size_t tmp_buckets = this->count / BUCKET_AVG;
+  size_t tmp_buckets = this->count / this->bucket_avg;
   size_t new_height = 0;
   while (tmp_buckets > 0) {
-    tmp_buckets = tmp_buckets / (DELIMITERS_PER_SPLIT+1);
+    tmp_buckets = tmp_buckets / (this->delimiters_per_split+1);
     new_height++;
   }
   size_t new_num_delimiters = this->getNumberOfNodesInTreeOfHeight(new_height) *
-                              DELIMITERS_PER_SPLIT;
+                              this->delimiters_per_split;
   int* new_delimiter_dimensions = new int[new_height];
   float* new_delimiter_values = new float[new_num_delimiters];
   // if statistics about average selectivities exist,
@@ -777,8 +2659,8 @@ void BBTree::RebuildDelimiters() {
                 cmp);
 
       // find delimiter values
-      int range_size = (delimiter_indexes[j] - start) / (DELIMITERS_PER_SPLIT+1);
-      for (size_t k = 1; k <= DELIMITERS_PER_SPLIT; ++k) {
+      int range_size = (delimiter_indexes[j] - start) / (this->delimiters_per_split+1);
+      for (size_t k = 1; k <= this->delimiters_per_split; ++k) {
         int l = 0;
         new_delimiter_values[delim_value++] =
           samples[start + k*range_size][new_delimiter_dimensions[i]];
@@ -794,164 +2676,555 @@ void BBTree::RebuildDelimiters() {
   // re-partition data objects to new buckets
   size_t new_num_buckets = this->getNumberOfNodesInTreeOfHeight(new_height+1) -
                            this->getNumberOfNodesInTreeOfHeight(new_height);
-  BBTreeBucket** new_buckets = new BBTreeBucket*[new_num_buckets];
+  BBTreeBucket* new_buckets = new BBTreeBucket[new_num_buckets];
+  for (size_t i = 0; i < new_num_buckets; ++i)
+    this->configureBucket(new_buckets[i]);
+  // the zone maps and sums of the new buckets are maintained while the data
+  // objects are copied, such that spilled new buckets are not read back
+  float* new_zone_maps = new float[2 * this->dimensions * new_num_buckets];
+  double* new_bucket_sums = new double[this->dimensions * new_num_buckets]();
   for (size_t i = 0; i < new_num_buckets; ++i) {
-    new_buckets[i] = new BBTreeRegularBucket();
+    float* zone_map = new_zone_maps + 2 * this->dimensions * i;
+    std::fill(zone_map, zone_map + this->dimensions,
+              std::numeric_limits<float>::max());
+    std::fill(zone_map + this->dimensions, zone_map + 2 * this->dimensions,
+              -std::numeric_limits<float>::max());
+  }
+
+  // with a buffer pool, the new buckets are appended to the bucket file
+  // whenever they would exceed the frames together with the resident old
+  // buckets; resident old buckets are moved first to release their frames
+  std::vector<size_t> old_buckets(this->num_buckets);
+  for (size_t i = 0; i < this->num_buckets; ++i)
+    old_buckets[i] = i;
+  std::vector<size_t> filled_buckets;
+  if (this->buffer_pool != NULL) {
+    this->buffer_pool->BeginRebuild(new_num_buckets);
+    std::stable_partition(old_buckets.begin(), old_buckets.end(),
+      [this](size_t bucket_id) { return this->buffer_pool->IsResident(bucket_id); });
   }
 
   // traverse over "old" buckets and copy data objects into new buckets
-  for (size_t i = 0; i < this->num_buckets; ++i) {
-    if (this->buckets[i]->IsRegularBucket()) { // regular bucket
-      std::vector<std::vector<float> > &data_objects =
-        ((BBTreeRegularBucket*) this->buckets[i])->GetDataObjects();
-      std::vector<uint32_t> &tids =
-        ((BBTreeRegularBucket*) this->buckets[i])->GetTids();
-      for (size_t j = 0; j < data_objects.size(); ++j) {
-        // determine new bucket loation
-        size_t cur_pos = 0;
-        std::vector<size_t> rel_positions;
-        for (size_t k = 0; k < new_height; ++k) {
-          size_t rel_pos = 0;
-          if (k == (new_height - 1)) {
-            int first = 0;
-            int last = 0;
-            for (size_t l = 0; l < DELIMITERS_PER_SPLIT; ++l) {
-              if (data_objects[j][new_delimiter_dimensions[k]] <=
-                  new_delimiter_values[cur_pos]) {
-                first = rel_pos;
-                last = rel_pos;
-                for (size_t m = 1; m < (DELIMITERS_PER_SPLIT - l); ++m) {
-                  if (new_delimiter_values[cur_pos] ==
-                      new_delimiter_values[cur_pos + m]) {
-                    last = rel_pos + m;
-                  } else {
-                    break;
-                  }
-                }
-                break;
-              } else {
-                cur_pos++;
-                rel_pos++;
-              }
-            }
-            if (rel_pos != DELIMITERS_PER_SPLIT) {
-              if (last > first) {
-                rel_pos = first + (rand() % (last-first));
-              } else {
-                rel_pos = first;
-              }
-            }
-          } else {
-            for (size_t l = 0; l < DELIMITERS_PER_SPLIT; ++l) {
-              if (data_objects[j][new_delimiter_dimensions[k]] <=
-                  new_delimiter_values[cur_pos]) {
-                break;
-              } else {
-                rel_pos++;
-                cur_pos++;
-              }
-            }
-          }
-          rel_positions.push_back(rel_pos);
-          size_t times = 0;
-          cur_pos = 0;
-          // rel_positions is of size k (the variable)
-          for (int m = (rel_positions.size() - 1); m >= 0; m--) {
-            cur_pos += rel_positions[m] *
-                       pow((DELIMITERS_PER_SPLIT+1), times++);
-          }
-          cur_pos = (this->getNumberOfNodesInTreeOfHeight(k+1) + cur_pos) *
-                      DELIMITERS_PER_SPLIT;
+  for (size_t o = 0; o < old_buckets.size(); ++o) {
+    const size_t i = old_buckets[o];
+    this->pinBucket(i);
+    // superbuckets consist of z regular buckets
+    for (size_t z = 0; z < this->buckets[i].GetNumberOfRegularBuckets(); ++z) {
+      const BBTreeBucket &bucket = this->buckets[i].GetRegularBucket(z);
+      for (size_t j = 0; j < bucket.GetNumberOfObjects(); ++j) {
+        const std::vector<float> feature_vector = bucket.GetObject(j);
+        // determine new bucket location
+        const size_t new_bucket = this->locateBucketForInsert(feature_vector,
+                                                              new_height,
+                                                              new_delimiter_dimensions,
+                                                              new_delimiter_values);
+        if (this->buffer_pool != NULL &&
+            new_buckets[new_bucket].GetNumberOfObjects() == 0) {
+          // the pinned old bucket does not count against the frames
+          if (filled_buckets.size() + this->buffer_pool->GetNumberOfResidentBuckets() >
+              this->buffer_pool->GetNumberOfFrames())
+            this->appendNewBuckets(new_buckets, filled_buckets);
+          filled_buckets.push_back(new_bucket);
         }
-        cur_pos = (cur_pos - (this->getNumberOfNodesInTreeOfHeight(new_height)
-                     * DELIMITERS_PER_SPLIT))
-                  / DELIMITERS_PER_SPLIT;
-        new_buckets[cur_pos]->InsertObject(data_objects[j], tids[j]);
-      }
-    } else { // super bucket
-      for (size_t z = 0; z < SUPER_BUCKET_SIZE; ++z) {
-        std::vector<std::vector<float> > &data_objects =
-          ((BBTreeSuperBucket*) this->buckets[i])->GetDataObjects(z);
-        std::vector<uint32_t> &tids =
-          ((BBTreeSuperBucket*) this->buckets[i])->GetTids(z);
-        for (size_t j = 0; j < data_objects.size(); ++j) {
-          // determine new bucket loation
-          size_t cur_pos = 0;
-          std::vector<size_t> rel_positions;
-          for (size_t k = 0; k < new_height; ++k) {
-            size_t rel_pos = 0;
-            if (k == (new_height - 1)) {
-              int first = 0;
-              int last = 0;
-              for (size_t l = 0; l < DELIMITERS_PER_SPLIT; ++l) {
-                if (data_objects[j][new_delimiter_dimensions[k]] <=
-                    new_delimiter_values[cur_pos]) {
-                  first = rel_pos;
-                  last = rel_pos;
-                  for (size_t m = 1; m < (DELIMITERS_PER_SPLIT - l); ++m) {
-                    if (new_delimiter_values[cur_pos] ==
-                        new_delimiter_values[cur_pos + m]) {
-                      last = rel_pos + m;
-                    } else {
-                      break;
-                    }
-                  }
-                  break;
-                } else {
-                  cur_pos++;
-                  rel_pos++;
-                }
-              }
-              if (rel_pos != DELIMITERS_PER_SPLIT) {
-                if (last > first) {
-                  rel_pos = first + (rand() % (last-first));
-                } else {
-                  rel_pos = first;
-                }
-              }
-            } else {
-              for (size_t l = 0; l < DELIMITERS_PER_SPLIT; ++l) {
-                if (data_objects[j][new_delimiter_dimensions[k]] <=
-                    new_delimiter_values[cur_pos]) {
-                  break;
-                } else {
-                  rel_pos++;
-                  cur_pos++;
-                }
-              }
-            }
-            rel_positions.push_back(rel_pos);
-            size_t times = 0;
-            cur_pos = 0;
-            // rel_positions is of size k (the variable)
-            for (int m = (rel_positions.size() - 1); m >= 0; m--) {
-              cur_pos += rel_positions[m] *
-                         pow((DELIMITERS_PER_SPLIT+1), times++);
-            }
-            cur_pos = (this->getNumberOfNodesInTreeOfHeight(k+1) + cur_pos) *
-                        DELIMITERS_PER_SPLIT;
-          }
-          cur_pos = (cur_pos - (this->getNumberOfNodesInTreeOfHeight(new_height)
-                       * DELIMITERS_PER_SPLIT))
-                    / DELIMITERS_PER_SPLIT;
-          new_buckets[cur_pos]->InsertObject(data_objects[j], tids[j]);
+        new_buckets[new_bucket].InsertObject(feature_vector, bucket.GetTid(j));
+        float* zone_map = new_zone_maps + 2 * this->dimensions * new_bucket;
+        double* sums = new_bucket_sums + this->dimensions * new_bucket;
+        for (size_t k = 0; k < this->dimensions; ++k) {
+          zone_map[k] = std::min(zone_map[k], feature_vector[k]);
+          zone_map[this->dimensions + k] =
+            std::max(zone_map[this->dimensions + k], feature_vector[k]);
+          sums[k] += feature_vector[k];
         }
       }
     }
     // decrease memory pressure
     // this should be disabled if RebuildDelimiters() is run in the background
-    delete this->buckets[i];
+    this->buckets[i].Clear();
+    if (this->buffer_pool != NULL)
+      this->buffer_pool->Drop(i);
+  }
+  if (this->buffer_pool != NULL) {
+    this->appendNewBuckets(new_buckets, filled_buckets);
+    this->buffer_pool->FinishRebuild();
   }
 
   // TODO: make the following lines atomic (necessary for background execution)
-  delete this->delimiter_dimensions;
-  delete this->delimiter_values;
+  delete [] this->delimiter_dimensions;
+  delete [] this->delimiter_values;
   delete [] this->buckets;
+  delete [] this->zone_maps;
+  delete [] this->bucket_sums;
+  delete [] this->bucket_versions;
   this->delimiter_dimensions = new_delimiter_dimensions;
   this->delimiter_values = new_delimiter_values;
   this->buckets = new_buckets;
+  this->zone_maps = new_zone_maps;
+  this->bucket_sums = new_bucket_sums;
+  this->bucket_versions = new uint64_t[new_num_buckets]();
+  this->structure_version++;
+  if (this->trace != NULL)
+    this->trace->MarkRebuild();
   this->num_buckets = new_num_buckets;
   this->height = new_height;
   this->num_super_buckets = 0;
   this->num_empty_buckets = 0;
+  // the tid directory cannot be enabled together with a buffer pool, so all
+  // new buckets are in memory
+  if (this->use_tid_directory) {
+    for (size_t i = 0; i < this->num_buckets; ++i)
+      this->refreshTidDirectory(i);
+  }
+}
+
+/**
+ * BBTree::appendNewBuckets(new_buckets, filled_buckets) appends the data
+ * objects of the given filled buckets of a rebuild to the buffer pool and
+ * releases them.
+ */
+void BBTree::appendNewBuckets(BBTreeBucket* new_buckets,
+                              std::vector<size_t> &filled_buckets) {
+  for (size_t i = 0; i < filled_buckets.size(); ++i) {
+    this->buffer_pool->AppendObjects(filled_buckets[i],
+                                     new_buckets[filled_buckets[i]]);
+    new_buckets[filled_buckets[i]].Clear();
+  }
+  filled_buckets.clear();
+}
+
+/**
+ * BBTree::deleteObjectAt(bucket_id,position,feature_vector) deletes the given
+ * data object, which is stored at the given position of the given bucket.
+ * It may invoke a rebuild of BB-Tree if too many sparse buckets exist.
+ */
+void BBTree::deleteObjectAt(const size_t bucket_id,
+                            const uint32_t position,
+                            const std::vector<float> &feature_vector) {
+  this->traceBucket(BBTREE_TRACE_DELETE, bucket_id);
+  BBTreeBucket &bucket = this->buckets[bucket_id];
+  if (this->use_tid_directory)
+    this->tid_directory[bucket.GetTidAt(position)].bucket = BBTREE_INVALID_BUCKET;
+  bucket.DeleteObjectAt(position);
+  // another data object may have moved into the position
+  if (this->use_tid_directory && bucket.IsValidPosition(position))
+    this->setTidLocation(bucket.GetTidAt(position), bucket_id, position);
+  this->count--;
+  this->updateBucketSums(bucket_id, feature_vector, -1.0);
+  // keep the zone map exact if a boundary value has been deleted
+  if (this->isOnZoneMapBoundary(bucket_id, feature_vector))
+    this->rebuildZoneMap(bucket_id);
+  // increase the sparse buckets counter
+  if (bucket.GetNumberOfObjects() == 0) {
+    this->num_empty_buckets++;
+  }
+  // invoke a rebuild if too many sparse buckets exist
+  if (this->num_empty_buckets >=
+      this->num_buckets * ALLOWED_EMPTY_BUCKETS) {
+    this->RebuildDelimiters();
+  // or transform underflowing super bucket into regular bucket
+  } else if (bucket.IsRegularBucket() == false &&
+             bucket.GetNumberOfObjects() <
+               (this->bucket_max * SUPER_BUCKET_FILL_DEGREE)) {
+    this->transformSuperIntoRegularBucket(bucket_id);
+  }
+}
+
+/**
+ * BBTree::finishRangeModification(modified_buckets) restores the zone maps,
+ * sums and tid directory entries of the given buckets after a range delete
+ * or update. Afterwards, it invokes a rebuild if too many sparse buckets
+ * exist, or transforms underflowing superbuckets into regular buckets and
+ * overflowing regular buckets into superbuckets. As in InsertObject(), an
+ * overflowing superbucket or too many superbuckets invoke a rebuild.
+ */
+void BBTree::finishRangeModification(const std::vector<size_t> &modified_buckets) {
+  for (size_t i = 0; i < modified_buckets.size(); ++i) {
+    const size_t bucket_id = modified_buckets[i];
+    this->rebuildZoneMap(bucket_id);
+    if (this->use_tid_directory)
+      this->refreshTidDirectory(bucket_id);
+    // increase the sparse buckets counter
+    if (this->buckets[bucket_id].GetNumberOfObjects() == 0)
+      this->num_empty_buckets++;
+  }
+
+  // invoke a rebuild if too many sparse buckets exist
+  if (this->num_empty_buckets >=
+      this->num_buckets * ALLOWED_EMPTY_BUCKETS) {
+    this->RebuildDelimiters();
+    return;
+  }
+  // or transform underflowing super buckets into regular buckets
+  for (size_t i = 0; i < modified_buckets.size(); ++i) {
+    const BBTreeBucket &bucket = this->buckets[modified_buckets[i]];
+    if (bucket.IsRegularBucket() == false &&
+        bucket.GetNumberOfObjects() <
+          (this->bucket_max * SUPER_BUCKET_FILL_DEGREE)) {
+      this->transformSuperIntoRegularBucket(modified_buckets[i]);
+    }
+  }
+  for (size_t i = 0; i < modified_buckets.size(); ++i) {
+    const size_t bucket_id = modified_buckets[i];
+    if (!this->buckets[bucket_id].IsFull(this->bucket_max))
+      continue;
+    if (this->buckets[bucket_id].IsRegularBucket() &&
+        this->num_super_buckets++ <= (ALLOWED_SUPER_BUCKETS * this->num_buckets)) {
+      this->transformRegularIntoSuperBucket(bucket_id);
+      // the objects moved into the bucket may overflow the superbucket, too
+      if (!this->buckets[bucket_id].IsFull(this->bucket_max))
+        continue;
+    }
+    this->RebuildDelimiters();
+    return;
+  }
+}
+
+/**
+ * BBTree::hasTidLocation(id) returns true if the tid directory holds the
+ * location of a data object with the given identifier.
+ */
+inline bool BBTree::hasTidLocation(const uint32_t object_id) const {
+  return (object_id < this->tid_directory.size() &&
+          this->tid_directory[object_id].bucket != BBTREE_INVALID_BUCKET);
+}
+
+/**
+ * BBTree::setTidLocation(id,bucket_id,position) records the location of the
+ * data object with the given identifier in the tid directory.
+ */
+inline void BBTree::setTidLocation(const uint32_t object_id,
+                                   const size_t bucket_id,
+                                   const uint32_t position) {
+  if (object_id >= this->tid_directory.size()) {
+    BBTreeTidLocation invalid;
+    invalid.bucket = BBTREE_INVALID_BUCKET;
+    invalid.position = 0;
+    this->tid_directory.resize((size_t) object_id + 1, invalid);
+  }
+  this->tid_directory[object_id].bucket = bucket_id;
+  this->tid_directory[object_id].position = position;
+}
+
+/**
+ * BBTree::refreshTidDirectory(bucket_id) records the locations of all data
+ * objects of the given bucket in the tid directory.
+ */
+void BBTree::refreshTidDirectory(const size_t bucket_id) {
+  const BBTreeBucket &bucket = this->buckets[bucket_id];
+  for (size_t z = 0; z < bucket.GetNumberOfRegularBuckets(); ++z) {
+    const BBTreeBucket &sub_bucket = bucket.GetRegularBucket(z);
+    for (size_t j = 0; j < sub_bucket.GetNumberOfObjects(); ++j) {
+      this->setTidLocation(sub_bucket.GetTid(j), bucket_id,
+                           (z << BUCKET_POSITION_ROW_BITS) | j);
+    }
+  }
+}
+
+/**
+ * BBTree::isOnZoneMapBoundary(bucket_id,feature_vector) returns true if the
+ * given data object holds the minimum or maximum of the zone map of the given
+ * bucket in some dimension.
+ */
+inline bool BBTree::isOnZoneMapBoundary(const size_t bucket_id,
+                                        const std::vector<float> &feature_vector) const {
+  const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+  for (size_t j = 0; j < this->dimensions; ++j) {
+    if (feature_vector[j] == zone_map[j] ||
+        feature_vector[j] == zone_map[this->dimensions + j]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * BBTree::configureBucket(bucket) applies the hash index and Bloom filter
+ * settings to a new bucket.
+ */
+inline void BBTree::configureBucket(BBTreeBucket &bucket) const {
+  bucket.SetHashIndex(this->hash_index);
+  bucket.SetBloomFilter(this->bloom_filter);
+}
+
+/**
+ * BBTree::resetZoneMap(bucket_id) sets the zone map of the given bucket to
+ * the empty zone map, which does not intersect with any range query, and its
+ * sums to zero. It also bumps the version of the bucket.
+ */
+void BBTree::resetZoneMap(const size_t bucket_id) {
+  this->bucket_versions[bucket_id]++;
+  float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+  double* sums = this->bucket_sums + this->dimensions * bucket_id;
+  for (size_t j = 0; j < this->dimensions; ++j) {
+    zone_map[j] = std::numeric_limits<float>::max();
+    zone_map[this->dimensions + j] = -std::numeric_limits<float>::max();
+    sums[j] = 0.0;
+  }
+}
+
+/**
+ * BBTree::updateZoneMap(bucket_id, feature_vector) extends the zone map of
+ * the given bucket by a newly inserted data object.
+ */
+inline void BBTree::updateZoneMap(const size_t bucket_id,
+                                  const std::vector<float> &feature_vector) {
+  float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+  for (size_t j = 0; j < this->dimensions; ++j) {
+    zone_map[j] = std::min(zone_map[j], feature_vector[j]);
+    zone_map[this->dimensions + j] = std::max(zone_map[this->dimensions + j],
+                                              feature_vector[j]);
+  }
+}
+
+/**
+ * BBTree::rebuildZoneMap(bucket_id) recomputes the zone map and the sums of
+ * the given bucket from its data objects.
+ */
+void BBTree::rebuildZoneMap(const size_t bucket_id) {
+  const BBTreeBucket &bucket = this->buckets[bucket_id];
+  float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+  double* sums = this->bucket_sums + this->dimensions * bucket_id;
+
+  this->resetZoneMap(bucket_id);
+  for (size_t z = 0; z < bucket.GetNumberOfRegularBuckets(); ++z) {
+    const BBTreeBucket &sub_bucket = bucket.GetRegularBucket(z);
+    for (size_t i = 0; i < sub_bucket.GetNumberOfObjects(); ++i) {
+      for (size_t j = 0; j < this->dimensions; ++j) {
+        const float value = sub_bucket.GetValue(i, j);
+        zone_map[j] = std::min(zone_map[j], value);
+        zone_map[this->dimensions + j] =
+          std::max(zone_map[this->dimensions + j], value);
+        sums[j] += value;
+      }
+    }
+  }
+}
+
+/**
+ * BBTree::updateBucketSums(bucket_id,feature_vector,sign) adds (sign = 1) or
+ * subtracts (sign = -1) the given data object to or from the sums of the
+ * given bucket and bumps the version of the bucket.
+ */
+inline void BBTree::updateBucketSums(const size_t bucket_id,
+                                     const std::vector<float> &feature_vector,
+                                     const double sign) {
+  this->bucket_versions[bucket_id]++;
+  double* sums = this->bucket_sums + this->dimensions * bucket_id;
+  for (size_t j = 0; j < this->dimensions; ++j)
+    sums[j] += sign * feature_vector[j];
+}
+
+/**
+ * BBTree::zoneMapIntersects(bucket_id,lower_bounds,upper_bounds) returns
+ * false if the given bucket cannot hold any data object of the range query.
+ */
+inline bool BBTree::zoneMapIntersects(const size_t bucket_id,
+                                      const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary) const {
+  const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+  for (size_t j = 0; j < this->dimensions; ++j) {
+    if (zone_map[j] > upper_boundary[j] ||
+        zone_map[this->dimensions + j] < lower_boundary[j]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * BBTree::zoneMapContained(bucket_id,lower_bounds,upper_bounds) returns true
+ * if all data objects of the given bucket match the range query.
+ */
+inline bool BBTree::zoneMapContained(const size_t bucket_id,
+                                     const std::vector<float> &lower_boundary,
+                                     const std::vector<float> &upper_boundary) const {
+  const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+  for (size_t j = 0; j < this->dimensions; ++j) {
+    if (zone_map[j] < lower_boundary[j] ||
+        zone_map[this->dimensions + j] > upper_boundary[j]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * BBTree::pinBucket(bucket_id) pins the given bucket in the buffer pool,
+ * loading it from its pages if it has been evicted, and evicts other buckets
+ * if the buffer pool is full. It does nothing without a buffer pool.
+ */
+inline void BBTree::pinBucket(const size_t bucket_id) {
+  if (this->buffer_pool == NULL)
+    return;
+  if (!this->buffer_pool->Pin(bucket_id))
+    this->loadBucket(bucket_id);
+  this->evictBuckets();
+}
+
+/**
+ * BBTree::unpinBucket(bucket_id, dirty) unpins the given bucket and marks it
+ * dirty if it has been modified. It does nothing without a buffer pool.
+ */
+inline void BBTree::unpinBucket(const size_t bucket_id, const bool dirty) {
+  if (this->buffer_pool != NULL)
+    this->buffer_pool->Unpin(bucket_id, dirty);
+}
+
+/**
+ * BBTree::loadBucket(bucket_id) reads an evicted bucket from the buffer pool
+ * and rebuilds it (and its superbucket layout) in memory.
+ */
+void BBTree::loadBucket(const size_t bucket_id) {
+  std::vector<std::vector<float> > feature_vectors;
+  std::vector<uint32_t> object_ids;
+  bool super_bucket;
+  this->buffer_pool->ReadBucket(bucket_id, feature_vectors, object_ids,
+                                super_bucket);
+  BBTreeBucket &bucket = this->buckets[bucket_id];
+  bucket.Clear();
+  this->configureBucket(bucket);
+  bucket.BulkInsert(feature_vectors, object_ids, 0, feature_vectors.size());
+  if (super_bucket)
+    this->transformRegularIntoSuperBucket(bucket_id);
+  else if (this->use_tid_directory)
+    this->refreshTidDirectory(bucket_id);
+}
+
+/**
+ * BBTree::evictBuckets() writes back and releases buckets chosen by the
+ * replacement policy until the buffer pool is no longer overfull.
+ */
+void BBTree::evictBuckets() {
+  size_t victim;
+  while (this->buffer_pool->GetVictim(victim)) {
+    if (this->buffer_pool->IsDirty(victim))
+      this->buffer_pool->WriteBucket(victim, this->buckets[victim]);
+    this->buckets[victim].Clear();
+  }
+}
+
+/**
+ * BBTree::getNumberOfObjects(bucket_id) returns the number of data objects
+ * of the given bucket, also if it has been evicted.
+ */
+inline size_t BBTree::getNumberOfObjects(const size_t bucket_id) const {
+  if (this->buffer_pool != NULL && !this->buffer_pool->IsResident(bucket_id))
+    return this->buffer_pool->GetNumberOfObjects(bucket_id);
+  return this->buckets[bucket_id].GetNumberOfObjects();
+}
+
+/**
+ * BBTree::sampleSpilledBuckets(sample_buckets, samples) draws the i'th
+ * sample from bucket sample_buckets[i], pinning every bucket only once.
+ */
+void BBTree::sampleSpilledBuckets(const std::vector<size_t> &sample_buckets,
+                                  std::vector<std::vector<float> > &samples) {
+  std::vector<size_t> order(sample_buckets.size());
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&sample_buckets](size_t a, size_t b) {
+    return sample_buckets[a] < sample_buckets[b];
+  });
+  for (size_t i = 0; i < order.size();) {
+    const size_t bucket_id = sample_buckets[order[i]];
+    this->pinBucket(bucket_id);
+    for (; i < order.size() && sample_buckets[order[i]] == bucket_id; ++i)
+      samples[order[i]] = this->buckets[bucket_id].GetRandomObject();
+    this->unpinBucket(bucket_id, false);
+  }
+}
+
+/**
+ * BBTree::traceBucket(operation, bucket_id) records an access to the given
+ * bucket if a trace is enabled.
+ */
+inline void BBTree::traceBucket(const BBTreeTraceOperation operation,
+                                const size_t bucket_id) const {
+  if (this->trace == NULL)
+    return;
+  const size_t object_size = this->dimensions * sizeof(float) + sizeof(uint32_t);
+  this->trace->Record(operation, bucket_id,
+                      this->getNumberOfObjects(bucket_id) * object_size);
+}
+
+/**
+ * BBTree::getPrefetchDistance() returns the number of buckets that range scans
+ * prefetch ahead: the configured distance, or a distance that covers about
+ * PREFETCH_LOOKAHEAD data objects of an average bucket.
+ */
+inline size_t BBTree::getPrefetchDistance() const {
+  if (this->prefetch_distance > 0)
+    return this->prefetch_distance;
+  const size_t avg_bucket_size = std::max((size_t) 1,
+                                          this->count / this->num_buckets);
+  const size_t distance = (PREFETCH_LOOKAHEAD + avg_bucket_size - 1) /
+                          avg_bucket_size;
+  return std::min(distance, (size_t) PREFETCH_MAX_DISTANCE);
+}
+
+/**
+ * BBTree::prefetchBuckets(match_buckets,position,end,distance,lower_bounds,upper_bounds)
+ * drives a two-stage software prefetching pipeline while the bucket at the
+ * given position of match_buckets is scanned:
+ * the header and zone map of the bucket 2*distance positions ahead are
+ * prefetched, and if the zone map of the bucket distance positions ahead
+ * (which has been prefetched before) shows that it has to be scanned,
+ * the first cache lines of its columns and tids are prefetched.
+ */
+inline void BBTree::prefetchBuckets(const std::vector<size_t> &match_buckets,
+                                    const size_t position,
+                                    const size_t end,
+                                    const size_t distance,
+                                    const std::vector<float> &lower_boundary,
+                                    const std::vector<float> &upper_boundary) const {
+  if (position + 2 * distance < end) {
+    const size_t bucket_id = match_buckets[position + 2 * distance];
+    const float* zone_map = this->zone_maps + 2 * this->dimensions * bucket_id;
+    __builtin_prefetch(&this->buckets[bucket_id]);
+    __builtin_prefetch(zone_map);
+    __builtin_prefetch(zone_map + 2 * this->dimensions - 1);
+  }
+  if (position + distance < end) {
+    const size_t bucket_id = match_buckets[position + distance];
+    if (this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary)) {
+      this->buckets[bucket_id].Prefetch(
+        this->zoneMapContained(bucket_id, lower_boundary, upper_boundary));
+    }
+  }
+}
+
+/**
+ * BBTree::scanBucket(results,bucket_id,lower_bounds,upper_bounds) executes
+ * a range query on a single bucket.
+ * Buckets whose zone map does not intersect with the query are skipped, and
+ * buckets whose zone map is covered by the query return all of their tids
+ * without comparing any values.
+ */
+inline void BBTree::scanBucket(std::vector<uint32_t> &results,
+                               const size_t bucket_id,
+                               const std::vector<float> &lower_boundary,
+                               const std::vector<float> &upper_boundary) const {
+  if (!this->zoneMapIntersects(bucket_id, lower_boundary, upper_boundary))
+    return;
+  this->traceBucket(BBTREE_TRACE_QUERY, bucket_id);
+  if (this->zoneMapContained(bucket_id, lower_boundary, upper_boundary)) {
+    this->buckets[bucket_id].GetAllTids(results);
+  } else {
+    this->buckets[bucket_id].SearchRange(results, lower_boundary,
+                                         upper_boundary);
+  }
+}
+
+/**
+ * BBTree::applyTuning(samples) runs the auto-tuner on the given samples and
+ * adopts the chosen bucket sizes and fanout.
+ * The fanout must only change while the inner nodes are rebuilt.
+ */
+void BBTree::applyTuning(const std::vector<std::vector<float> > &samples) {
+  const BBTreeTuning tuning = this->tuner.Tune(samples,
+                                               this->dimensions,
+                                               this->count);
+  this->bucket_max = tuning.bucket_max;
+  this->bucket_avg = tuning.bucket_avg;
+  this->delimiters_per_split = tuning.delimiters_per_split;
+  this->tuned_scan_cost = tuning.ns_per_object;
 }
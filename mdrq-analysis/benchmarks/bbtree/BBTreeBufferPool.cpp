@@ -0,0 +1,478 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeBufferPool.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "BBTreeBucket.h"
+
+/**
+ * BBTreeBufferPool(path, dimensions, num_frames, replacement) creates the
+ * bucket file at path and a buffer pool that keeps up to num_frames buckets
+ * resident, evicting them by the given replacement policy.
+ */
+BBTreeBufferPool::BBTreeBufferPool(const std::string &path,
+                                   const size_t dimensions,
+                                   const size_t num_frames,
+                                   const BBTreeReplacement replacement) :
+  BBTreeBufferPool(path, dimensions, num_frames,
+                   BBTreeReplacementPolicy::Create(replacement, num_frames)) {}
+
+/**
+ * BBTreeBufferPool(path, dimensions, num_frames, policy) is the same as
+ * above, but uses the given replacement policy (and takes ownership of it).
+ */
+BBTreeBufferPool::BBTreeBufferPool(const std::string &path,
+                                   const size_t dimensions,
+                                   const size_t num_frames,
+                                   BBTreeReplacementPolicy* policy) :
+  path(path), dimensions(dimensions), num_frames(num_frames), policy(policy),
+  file(-1), num_pages(0), num_resident(0), hits(0), misses(0), evictions(0),
+  pages_read(0), pages_written(0) {
+  try {
+    this->openFile();
+  } catch (...) {
+    delete this->policy;
+    throw;
+  }
+}
+
+/**
+ * ~BBTreeBufferPool() closes and removes the bucket file.
+ */
+BBTreeBufferPool::~BBTreeBufferPool() {
+  close(this->file);
+  unlink(this->path.c_str());
+  delete this->policy;
+}
+
+/**
+ * BBTreeBufferPool::Reset(num_buckets) releases all pages and registers
+ * num_buckets new buckets, which are resident and dirty (e.g., after they
+ * have been rebuilt in memory).
+ */
+void BBTreeBufferPool::Reset(const size_t num_buckets) {
+  for (size_t i = 0; i < this->states.size(); ++i) {
+    if (this->states[i].resident)
+      this->policy->Remove(i);
+  }
+  this->free_pages.clear();
+  this->num_pages = 0;
+  if (ftruncate(this->file, 0) != 0)
+    this->throwError("cannot truncate");
+
+  BucketState state;
+  state.num_objects = 0;
+  state.super_bucket = false;
+  state.resident = true;
+  state.dirty = true;
+  state.pins = 0;
+  this->states.assign(num_buckets, state);
+  this->num_resident = num_buckets;
+  for (size_t i = 0; i < num_buckets; ++i)
+    this->policy->Insert(i);
+}
+
+/**
+ * BBTreeBufferPool::Pin(bucket_id) pins the given bucket, such that it is
+ * not evicted until it is unpinned again.
+ * It returns true if the bucket is resident (hit). Otherwise (miss), the
+ * bucket becomes resident and has to be loaded by the caller with
+ * ReadBucket().
+ */
+bool BBTreeBufferPool::Pin(const size_t bucket_id) {
+  BucketState &state = this->states[bucket_id];
+  state.pins++;
+  if (state.resident) {
+    this->hits++;
+    this->policy->Access(bucket_id);
+    return true;
+  }
+  this->misses++;
+  state.resident = true;
+  state.dirty = false;
+  this->num_resident++;
+  this->policy->Insert(bucket_id);
+  return false;
+}
+
+/**
+ * BBTreeBufferPool::Unpin(bucket_id, dirty) unpins the given bucket and
+ * marks it dirty if it has been modified.
+ */
+void BBTreeBufferPool::Unpin(const size_t bucket_id, const bool dirty) {
+  BucketState &state = this->states[bucket_id];
+  assert(state.pins > 0);
+  state.pins--;
+  state.dirty = state.dirty || dirty;
+}
+
+/**
+ * BBTreeBufferPool::Drop(bucket_id) releases the given bucket and its pages
+ * without writing it back, e.g., once its data objects have been moved to
+ * other buckets.
+ */
+void BBTreeBufferPool::Drop(const size_t bucket_id) {
+  BucketState &state = this->states[bucket_id];
+  if (state.resident) {
+    this->policy->Remove(bucket_id);
+    this->num_resident--;
+  }
+  this->freePages(state);
+  state.num_objects = 0;
+  state.super_bucket = false;
+  state.resident = false;
+  state.dirty = false;
+  state.pins = 0;
+}
+
+/**
+ * BBTreeBufferPool::GetVictim(bucket_id) chooses an unpinned bucket to evict
+ * if more than num_frames buckets are resident, and marks it as not
+ * resident. The caller has to write it back if it is dirty and release it.
+ * It returns false if no bucket has to or can be evicted.
+ */
+bool BBTreeBufferPool::GetVictim(size_t &bucket_id) {
+  if (this->num_resident <= this->num_frames)
+    return false;
+  uint64_t victim;
+  if (!this->policy->Evict([this](uint64_t key) {
+                             return this->states[key].pins == 0;
+                           }, victim))
+    return false;
+  this->states[victim].resident = false;
+  this->num_resident--;
+  this->evictions++;
+  bucket_id = (size_t) victim;
+  return true;
+}
+
+/**
+ * BBTreeBufferPool::IsResident(bucket_id) returns true if the given bucket
+ * is resident.
+ */
+bool BBTreeBufferPool::IsResident(const size_t bucket_id) const {
+  return this->states[bucket_id].resident;
+}
+
+/**
+ * BBTreeBufferPool::IsDirty(bucket_id) returns true if the given bucket has
+ * been modified since it was written.
+ */
+bool BBTreeBufferPool::IsDirty(const size_t bucket_id) const {
+  return this->states[bucket_id].dirty;
+}
+
+/**
+ * BBTreeBufferPool::WriteBucket(bucket_id, bucket) writes the tids and data
+ * objects of the given bucket (of all z buckets of a superbucket) to the
+ * pages of bucket_id, allocating or releasing pages as needed.
+ */
+void BBTreeBufferPool::WriteBucket(const size_t bucket_id,
+                                   const BBTreeBucket &bucket) {
+  BucketState &state = this->states[bucket_id];
+  const size_t num_objects = bucket.GetNumberOfObjects();
+  const size_t bytes = num_objects * (sizeof(uint32_t) +
+                                      this->dimensions * sizeof(float));
+  const size_t num_bucket_pages = (bytes + BUFFER_POOL_PAGE_SIZE - 1) /
+                                  BUFFER_POOL_PAGE_SIZE;
+  this->buffer.assign(num_bucket_pages * BUFFER_POOL_PAGE_SIZE, 0);
+  this->serializeObjects(bucket, this->buffer.data());
+
+  // adjust the page chain
+  while (state.pages.size() > num_bucket_pages) {
+    this->free_pages.push_back(state.pages.back());
+    state.pages.pop_back();
+  }
+  this->allocatePages(state, num_bucket_pages);
+
+  for (size_t p = 0; p < num_bucket_pages; ++p)
+    this->writePage(state.pages[p],
+                    this->buffer.data() + p * BUFFER_POOL_PAGE_SIZE);
+  state.num_objects = num_objects;
+  state.super_bucket = !bucket.IsRegularBucket();
+  state.dirty = false;
+}
+
+/**
+ * BBTreeBufferPool::ReadBucket(bucket_id, feature_vectors, object_ids,
+ * super_bucket) reads the data objects and tids of the given bucket from its
+ * pages, and whether it was a superbucket.
+ */
+void BBTreeBufferPool::ReadBucket(const size_t bucket_id,
+                                  std::vector<std::vector<float> > &feature_vectors,
+                                  std::vector<uint32_t> &object_ids,
+                                  bool &super_bucket) {
+  const BucketState &state = this->states[bucket_id];
+  this->buffer.resize(state.pages.size() * BUFFER_POOL_PAGE_SIZE);
+  for (size_t p = 0; p < state.pages.size(); ++p)
+    this->readPage(state.pages[p],
+                   this->buffer.data() + p * BUFFER_POOL_PAGE_SIZE);
+
+  const size_t num_objects = state.num_objects;
+  const size_t row_size = sizeof(uint32_t) + this->dimensions * sizeof(float);
+  object_ids.resize(num_objects);
+  feature_vectors.resize(num_objects);
+  for (size_t i = 0; i < num_objects; ++i) {
+    const char* row = this->buffer.data() + i * row_size;
+    memcpy(&object_ids[i], row, sizeof(uint32_t));
+    feature_vectors[i].resize(this->dimensions);
+    memcpy(feature_vectors[i].data(), row + sizeof(uint32_t),
+           this->dimensions * sizeof(float));
+  }
+  super_bucket = state.super_bucket;
+}
+
+/**
+ * BBTreeBufferPool::BeginRebuild(num_buckets) registers a new bucket
+ * directory of num_buckets empty buckets, which are filled by
+ * AppendObjects(). The pages of the current buckets are reused once they
+ * are dropped.
+ */
+void BBTreeBufferPool::BeginRebuild(const size_t num_buckets) {
+  BucketState state;
+  state.num_objects = 0;
+  state.super_bucket = false;
+  state.resident = false;
+  state.dirty = false;
+  state.pins = 0;
+  this->new_states.assign(num_buckets, state);
+}
+
+/**
+ * BBTreeBufferPool::AppendObjects(bucket_id, bucket) appends the tids and
+ * data objects of the given (regular) bucket to the pages of the bucket of
+ * the new directory with the given id. Only the last page of the bucket is
+ * read back, if it is partially filled.
+ */
+void BBTreeBufferPool::AppendObjects(const size_t bucket_id,
+                                     const BBTreeBucket &bucket) {
+  BucketState &state = this->new_states[bucket_id];
+  const size_t row_size = sizeof(uint32_t) + this->dimensions * sizeof(float);
+  const size_t offset = state.num_objects * row_size;
+  const size_t first_page = offset / BUFFER_POOL_PAGE_SIZE;
+  const size_t page_offset = offset % BUFFER_POOL_PAGE_SIZE;
+  const size_t bytes = page_offset + bucket.GetNumberOfObjects() * row_size;
+  const size_t num_append_pages = (bytes + BUFFER_POOL_PAGE_SIZE - 1) /
+                                  BUFFER_POOL_PAGE_SIZE;
+  this->buffer.assign(num_append_pages * BUFFER_POOL_PAGE_SIZE, 0);
+  if (page_offset > 0)
+    this->readPage(state.pages[first_page], this->buffer.data());
+  this->serializeObjects(bucket, this->buffer.data() + page_offset);
+  this->allocatePages(state, first_page + num_append_pages);
+
+  for (size_t p = 0; p < num_append_pages; ++p)
+    this->writePage(state.pages[first_page + p],
+                    this->buffer.data() + p * BUFFER_POOL_PAGE_SIZE);
+  state.num_objects += bucket.GetNumberOfObjects();
+}
+
+/**
+ * BBTreeBufferPool::FinishRebuild() releases the current buckets and
+ * replaces them by the buckets of the new directory (see BeginRebuild()),
+ * none of which is resident.
+ */
+void BBTreeBufferPool::FinishRebuild() {
+  for (size_t i = 0; i < this->states.size(); ++i) {
+    if (this->states[i].resident)
+      this->policy->Remove(i);
+    this->freePages(this->states[i]);
+  }
+  this->states.swap(this->new_states);
+  this->new_states.clear();
+  this->num_resident = 0;
+}
+
+/**
+ * BBTreeBufferPool::GetNumberOfObjects(bucket_id) returns the number of
+ * data objects of the given bucket when it was last written.
+ */
+size_t BBTreeBufferPool::GetNumberOfObjects(const size_t bucket_id) const {
+  return this->states[bucket_id].num_objects;
+}
+
+/**
+ * BBTreeBufferPool::GetNumberOfFrames() returns the maximum number of
+ * resident unpinned buckets.
+ */
+size_t BBTreeBufferPool::GetNumberOfFrames() const {
+  return this->num_frames;
+}
+
+/**
+ * BBTreeBufferPool::GetNumberOfResidentBuckets() returns the number of
+ * buckets that are currently resident.
+ */
+size_t BBTreeBufferPool::GetNumberOfResidentBuckets() const {
+  return this->num_resident;
+}
+
+/**
+ * BBTreeBufferPool::GetHits() returns the number of pins of resident
+ * buckets.
+ */
+size_t BBTreeBufferPool::GetHits() const {
+  return this->hits;
+}
+
+/**
+ * BBTreeBufferPool::GetMisses() returns the number of pins of buckets that
+ * had to be read from the file.
+ */
+size_t BBTreeBufferPool::GetMisses() const {
+  return this->misses;
+}
+
+/**
+ * BBTreeBufferPool::GetEvictions() returns the number of evicted buckets.
+ */
+size_t BBTreeBufferPool::GetEvictions() const {
+  return this->evictions;
+}
+
+/**
+ * BBTreeBufferPool::GetPagesRead() returns the number of pages read from the
+ * file.
+ */
+size_t BBTreeBufferPool::GetPagesRead() const {
+  return this->pages_read;
+}
+
+/**
+ * BBTreeBufferPool::GetPagesWritten() returns the number of pages written to
+ * the file.
+ */
+size_t BBTreeBufferPool::GetPagesWritten() const {
+  return this->pages_written;
+}
+
+/**
+ * BBTreeBufferPool::GetPolicyName() returns the name of the replacement
+ * policy.
+ */
+const char* BBTreeBufferPool::GetPolicyName() const {
+  return this->policy->GetName();
+}
+
+/**
+ * BBTreeBufferPool::openFile() creates (or truncates) the bucket file.
+ */
+void BBTreeBufferPool::openFile() {
+  this->file = open(this->path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (this->file < 0)
+    this->throwError("cannot open");
+}
+
+/**
+ * BBTreeBufferPool::readPage(page, data) reads the given page of the file
+ * into data. Interrupted and short reads are resumed.
+ */
+void BBTreeBufferPool::readPage(const uint32_t page, char* data) {
+  const off_t offset = (off_t) page * BUFFER_POOL_PAGE_SIZE;
+  size_t done = 0;
+  while (done < BUFFER_POOL_PAGE_SIZE) {
+    const ssize_t result = pread(this->file, data + done,
+                                 BUFFER_POOL_PAGE_SIZE - done,
+                                 offset + (off_t) done);
+    if (result < 0 && errno == EINTR)
+      continue;
+    if (result < 0)
+      this->throwError("cannot read");
+    if (result == 0) {
+      errno = EIO;
+      this->throwError("cannot read past the end of");
+    }
+    done += result;
+  }
+  this->pages_read++;
+}
+
+/**
+ * BBTreeBufferPool::writePage(page, data) writes data to the given page of
+ * the file. Interrupted and short writes are resumed.
+ */
+void BBTreeBufferPool::writePage(const uint32_t page, const char* data) {
+  const off_t offset = (off_t) page * BUFFER_POOL_PAGE_SIZE;
+  size_t done = 0;
+  while (done < BUFFER_POOL_PAGE_SIZE) {
+    const ssize_t result = pwrite(this->file, data + done,
+                                  BUFFER_POOL_PAGE_SIZE - done,
+                                  offset + (off_t) done);
+    if (result < 0 && errno == EINTR)
+      continue;
+    if (result < 0)
+      this->throwError("cannot write");
+    done += result;
+  }
+  this->pages_written++;
+}
+
+/**
+ * BBTreeBufferPool::throwError(operation) throws a std::runtime_error that
+ * names the failed operation, the bucket file and the reason given by errno.
+ */
+void BBTreeBufferPool::throwError(const char* operation) const {
+  throw std::runtime_error(std::string("BBTreeBufferPool: ") + operation +
+                           " " + this->path + ": " + strerror(errno));
+}
+
+/**
+ * BBTreeBufferPool::freePages(state) returns the pages of a bucket to the
+ * free list.
+ */
+void BBTreeBufferPool::freePages(BucketState &state) {
+  this->free_pages.insert(this->free_pages.end(), state.pages.begin(),
+                          state.pages.end());
+  state.pages.clear();
+}
+
+/**
+ * BBTreeBufferPool::serializeObjects(bucket, rows) writes a row of the tid
+ * and the values of every data object of the given bucket (of all z buckets
+ * of a superbucket) to rows.
+ */
+void BBTreeBufferPool::serializeObjects(const BBTreeBucket &bucket,
+                                        char* rows) const {
+  const size_t row_size = sizeof(uint32_t) + this->dimensions * sizeof(float);
+  for (size_t z = 0; z < bucket.GetNumberOfRegularBuckets(); ++z) {
+    const BBTreeBucket &sub_bucket = bucket.GetRegularBucket(z);
+    for (size_t i = 0; i < sub_bucket.GetNumberOfObjects(); ++i) {
+      const uint32_t tid = sub_bucket.GetTid(i);
+      memcpy(rows, &tid, sizeof(uint32_t));
+      float* values = (float*) (rows + sizeof(uint32_t));
+      for (size_t j = 0; j < this->dimensions; ++j)
+        values[j] = sub_bucket.GetValue(i, j);
+      rows += row_size;
+    }
+  }
+}
+
+/**
+ * BBTreeBufferPool::allocatePages(state, num_bucket_pages) extends the page
+ * chain of a bucket to num_bucket_pages pages, reusing free pages first.
+ */
+void BBTreeBufferPool::allocatePages(BucketState &state,
+                                     const size_t num_bucket_pages) {
+  while (state.pages.size() < num_bucket_pages) {
+    if (this->free_pages.empty()) {
+      state.pages.push_back(this->num_pages++);
+    } else {
+      state.pages.push_back(this->free_pages.back());
+      this->free_pages.pop_back();
+    }
+  }
+}
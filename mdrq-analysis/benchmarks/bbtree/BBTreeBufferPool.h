@@ -0,0 +1,130 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREEBUFFERPOOL
+#define BBTREEBUFFERPOOL
+#pragma once
+
+// Size of a page of the bucket file in bytes
+#define BUFFER_POOL_PAGE_SIZE 4096
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BBTreeReplacementPolicy.h"
+
+class BBTreeBucket;
+
+/**
+ * Buffer pool that keeps the buckets of an out-of-core BB-Tree in a file of
+ * fixed-size pages and decides which of them are resident in memory.
+ *
+ * Every bucket is stored in a chain of pages (a row of the tid and the values
+ * of every data object); the page table is kept in memory. Buckets are
+ * pinned while they are accessed and are marked dirty when they are unpinned
+ * after a modification. Once more than num_frames buckets are resident, the
+ * replacement policy chooses unpinned victims, which the BB-Tree writes back
+ * (if dirty) and releases. The file is created on construction and removed
+ * on destruction. I/O errors are reported by throwing std::runtime_error.
+ *
+ * A new bucket directory (e.g., of a rebuild) can be written while the
+ * current one is still in use: after BeginRebuild(), AppendObjects() adds
+ * data objects to the new buckets page by page, and FinishRebuild() replaces
+ * the current buckets by the new ones, which are not resident then.
+ *
+ * The buffer pool is not thread-safe.
+ */
+class BBTreeBufferPool {
+  public:
+    BBTreeBufferPool(const std::string &path,
+                     const size_t dimensions,
+                     const size_t num_frames,
+                     const BBTreeReplacement replacement);
+    BBTreeBufferPool(const std::string &path,
+                     const size_t dimensions,
+                     const size_t num_frames,
+                     BBTreeReplacementPolicy* policy);
+    ~BBTreeBufferPool();
+
+    void Reset(const size_t num_buckets);
+    bool Pin(const size_t bucket_id);
+    void Unpin(const size_t bucket_id, const bool dirty);
+    void Drop(const size_t bucket_id);
+    bool GetVictim(size_t &bucket_id);
+    bool IsResident(const size_t bucket_id) const;
+    bool IsDirty(const size_t bucket_id) const;
+    void WriteBucket(const size_t bucket_id, const BBTreeBucket &bucket);
+    void ReadBucket(const size_t bucket_id,
+                    std::vector<std::vector<float> > &feature_vectors,
+                    std::vector<uint32_t> &object_ids,
+                    bool &super_bucket);
+    void BeginRebuild(const size_t num_buckets);
+    void AppendObjects(const size_t bucket_id, const BBTreeBucket &bucket);
+    void FinishRebuild();
+    size_t GetNumberOfObjects(const size_t bucket_id) const;
+    size_t GetNumberOfFrames() const;
+    size_t GetNumberOfResidentBuckets() const;
+    size_t GetHits() const;
+    size_t GetMisses() const;
+    size_t GetEvictions() const;
+    size_t GetPagesRead() const;
+    size_t GetPagesWritten() const;
+    const char* GetPolicyName() const;
+  private:
+    /**
+     * Page table entry and frame state of a bucket.
+     */
+    struct BucketState {
+      // pages holding the bucket, in order
+      std::vector<uint32_t> pages;
+      // number of data objects of the bucket when it was written
+      size_t num_objects;
+      bool super_bucket;
+      bool resident;
+      bool dirty;
+      uint32_t pins;
+    };
+
+    const std::string path;
+    const size_t dimensions;
+    const size_t num_frames;
+    BBTreeReplacementPolicy* policy;
+    int file;
+    std::vector<BucketState> states;
+    // buckets of the directory that is being rebuilt
+    std::vector<BucketState> new_states;
+    std::vector<uint32_t> free_pages;
+    uint32_t num_pages;
+    size_t num_resident;
+    // statistics
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t pages_read;
+    size_t pages_written;
+    // scratch buffer of (de)serialized buckets
+    std::vector<char> buffer;
+
+    BBTreeBufferPool(const BBTreeBufferPool &other) = delete;
+    BBTreeBufferPool& operator=(const BBTreeBufferPool &other) = delete;
+
+    void openFile();
+    void readPage(const uint32_t page, char* data);
+    void writePage(const uint32_t page, const char* data);
+    [[noreturn]] void throwError(const char* operation) const;
+    void freePages(BucketState &state);
+    void serializeObjects(const BBTreeBucket &bucket, char* rows) const;
+    void allocatePages(BucketState &state, const size_t num_bucket_pages);
+};
+
+#endif
@@ -0,0 +1,704 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREEREPLACEMENTPOLICY
+#define BBTREEREPLACEMENTPOLICY
+#pragma once
+
+// Fraction of the resident entries of 2Q that are managed by its FIFO queue
+#define REPLACEMENT_2Q_IN_RATIO 0.25
+// Number of ghost entries of 2Q relative to the capacity
+#define REPLACEMENT_2Q_OUT_RATIO 0.5
+// Fraction of the resident entries of LIRS reserved for HIR entries
+#define REPLACEMENT_LIRS_HIR_RATIO 0.01
+// Number of non-resident entries kept by LIRS relative to the capacity
+#define REPLACEMENT_LIRS_GHOST_RATIO 1.0
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Replacement policies for caches of fixed numbers of entries.
+ */
+enum BBTreeReplacement {
+  BBTREE_REPLACEMENT_LRU,
+  BBTREE_REPLACEMENT_CLOCK,
+  BBTREE_REPLACEMENT_2Q,
+  BBTREE_REPLACEMENT_ARC,
+  BBTREE_REPLACEMENT_LIRS,
+  BBTREE_REPLACEMENT_LFU
+};
+
+/**
+ * Interface of a replacement policy. It tracks the resident entries of a
+ * cache (identified by keys) and decides which one to evict.
+ *
+ * A cache calls Insert() when an entry becomes resident after a miss,
+ * Access() on every hit, and Remove() when it drops an entry for other
+ * reasons. If the cache is over capacity, Evict() returns a victim among
+ * the entries accepted by is_evictable (e.g., not pinned) and forgets it,
+ * or returns false if there is none. Policies may remember evicted keys
+ * (ghost entries) to recognize them on their next Insert().
+ *
+ * Example usage:
+ *   BBTreeReplacementPolicy* policy =
+ *     BBTreeReplacementPolicy::Create(BBTREE_REPLACEMENT_ARC, num_frames);
+ */
+class BBTreeReplacementPolicy {
+  public:
+    virtual ~BBTreeReplacementPolicy() {}
+
+    virtual void Insert(const uint64_t key) = 0;
+    virtual void Access(const uint64_t key) = 0;
+    virtual void Remove(const uint64_t key) = 0;
+    virtual bool Evict(const std::function<bool(uint64_t)> &is_evictable,
+                       uint64_t &victim) = 0;
+    virtual const char* GetName() const = 0;
+
+    static BBTreeReplacementPolicy* Create(const BBTreeReplacement type,
+                                           const size_t capacity);
+    static const char* GetTypeName(const BBTreeReplacement type);
+};
+
+/**
+ * Least recently used.
+ */
+class BBTreeLRUPolicy : public BBTreeReplacementPolicy {
+  public:
+    void Insert(const uint64_t key) {
+      this->order.push_front(key);
+      this->positions[key] = this->order.begin();
+    }
+
+    void Access(const uint64_t key) {
+      this->order.splice(this->order.begin(), this->order,
+                         this->positions[key]);
+    }
+
+    void Remove(const uint64_t key) {
+      auto position = this->positions.find(key);
+      if (position == this->positions.end())
+        return;
+      this->order.erase(position->second);
+      this->positions.erase(position);
+    }
+
+    bool Evict(const std::function<bool(uint64_t)> &is_evictable,
+               uint64_t &victim) {
+      for (auto it = this->order.rbegin(); it != this->order.rend(); ++it) {
+        if (is_evictable(*it)) {
+          victim = *it;
+          this->Remove(victim);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    const char* GetName() const { return "LRU"; }
+  private:
+    // most recently used first
+    std::list<uint64_t> order;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> positions;
+};
+
+/**
+ * Least frequently used: evicts the entry with the fewest accesses since it
+ * became resident; ties are broken in LRU order.
+ */
+class BBTreeLFUPolicy : public BBTreeReplacementPolicy {
+  public:
+    BBTreeLFUPolicy() : tick(0) {}
+
+    void Insert(const uint64_t key) {
+      const Rank rank(1, this->tick++);
+      this->ranks[key] = rank;
+      this->order.insert(std::make_pair(rank, key));
+    }
+
+    void Access(const uint64_t key) {
+      Rank &rank = this->ranks[key];
+      this->order.erase(std::make_pair(rank, key));
+      rank.first++;
+      rank.second = this->tick++;
+      this->order.insert(std::make_pair(rank, key));
+    }
+
+    void Remove(const uint64_t key) {
+      auto rank = this->ranks.find(key);
+      if (rank == this->ranks.end())
+        return;
+      this->order.erase(std::make_pair(rank->second, key));
+      this->ranks.erase(rank);
+    }
+
+    bool Evict(const std::function<bool(uint64_t)> &is_evictable,
+               uint64_t &victim) {
+      for (auto it = this->order.begin(); it != this->order.end(); ++it) {
+        if (is_evictable(it->second)) {
+          victim = it->second;
+          this->Remove(victim);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    const char* GetName() const { return "LFU"; }
+  private:
+    // number of accesses and time of the last access
+    typedef std::pair<uint64_t, uint64_t> Rank;
+
+    // least frequently used first
+    std::set<std::pair<Rank, uint64_t> > order;
+    std::unordered_map<uint64_t, Rank> ranks;
+    uint64_t tick;
+};
+
+/**
+ * CLOCK (second chance): a hand sweeps over the entries and evicts the
+ * first one whose reference bit is not set, clearing the bits it passes.
+ */
+class BBTreeClockPolicy : public BBTreeReplacementPolicy {
+  public:
+    BBTreeClockPolicy() : hand(0) {}
+
+    void Insert(const uint64_t key) {
+      size_t slot;
+      if (this->free_slots.empty()) {
+        slot = this->keys.size();
+        this->keys.push_back(key);
+        this->referenced.push_back(true);
+      } else {
+        slot = this->free_slots.back();
+        this->free_slots.pop_back();
+        this->keys[slot] = key;
+        this->referenced[slot] = true;
+      }
+      this->slots[key] = slot;
+    }
+
+    void Access(const uint64_t key) {
+      this->referenced[this->slots[key]] = true;
+    }
+
+    void Remove(const uint64_t key) {
+      auto slot = this->slots.find(key);
+      if (slot == this->slots.end())
+        return;
+      this->keys[slot->second] = UINT64_MAX;
+      this->free_slots.push_back(slot->second);
+      this->slots.erase(slot);
+    }
+
+    bool Evict(const std::function<bool(uint64_t)> &is_evictable,
+               uint64_t &victim) {
+      // two rounds clear all reference bits
+      for (size_t step = 0; step <= 2 * this->keys.size(); ++step) {
+        if (this->hand >= this->keys.size())
+          this->hand = 0;
+        const size_t slot = this->hand++;
+        const uint64_t key = this->keys[slot];
+        if (key == UINT64_MAX || !is_evictable(key))
+          continue;
+        if (this->referenced[slot]) {
+          this->referenced[slot] = false;
+          continue;
+        }
+        victim = key;
+        this->Remove(victim);
+        return true;
+      }
+      return false;
+    }
+
+    const char* GetName() const { return "CLOCK"; }
+  private:
+    // keys of the slots; UINT64_MAX marks free slots
+    std::vector<uint64_t> keys;
+    std::vector<bool> referenced;
+    std::vector<size_t> free_slots;
+    std::unordered_map<uint64_t, size_t> slots;
+    size_t hand;
+};
+
+/**
+ * 2Q: new entries enter a FIFO queue (A1in); entries that are accessed again
+ * after they left it (remembered in the ghost queue A1out) are managed by an
+ * LRU list (Am). Entries that are only accessed once thus never displace
+ * the frequently accessed ones.
+ */
+class BBTreeTwoQueuePolicy : public BBTreeReplacementPolicy {
+  public:
+    explicit BBTreeTwoQueuePolicy(const size_t capacity) :
+      in_capacity(std::max((size_t) 1, (size_t) (capacity * REPLACEMENT_2Q_IN_RATIO))),
+      out_capacity(std::max((size_t) 1, (size_t) (capacity * REPLACEMENT_2Q_OUT_RATIO))) {}
+
+    void Insert(const uint64_t key) {
+      auto entry = this->entries.find(key);
+      if (entry != this->entries.end()) {
+        // accessed again after it left A1in
+        this->a1out.erase(entry->second.position);
+        this->push(key, BBTreeTwoQueuePolicy::AM);
+      } else {
+        this->push(key, BBTreeTwoQueuePolicy::A1IN);
+      }
+    }
+
+    void Access(const uint64_t key) {
+      Entry &entry = this->entries[key];
+      if (entry.queue == BBTreeTwoQueuePolicy::AM)
+        this->am.splice(this->am.begin(), this->am, entry.position);
+    }
+
+    void Remove(const uint64_t key) {
+      auto entry = this->entries.find(key);
+      if (entry == this->entries.end() ||
+          entry->second.queue == BBTreeTwoQueuePolicy::A1OUT)
+        return;
+      this->getQueue(entry->second.queue).erase(entry->second.position);
+      this->entries.erase(entry);
+    }
+
+    bool Evict(const std::function<bool(uint64_t)> &is_evictable,
+               uint64_t &victim) {
+      const bool from_in = this->a1in.size() > this->in_capacity;
+      if (this->evictFrom(from_in ? BBTreeTwoQueuePolicy::A1IN : BBTreeTwoQueuePolicy::AM,
+                          is_evictable, victim))
+        return true;
+      return this->evictFrom(from_in ? BBTreeTwoQueuePolicy::AM : BBTreeTwoQueuePolicy::A1IN,
+                             is_evictable, victim);
+    }
+
+    const char* GetName() const { return "2Q"; }
+  private:
+    enum Queue { A1IN, A1OUT, AM };
+    struct Entry {
+      Queue queue;
+      std::list<uint64_t>::iterator position;
+    };
+
+    const size_t in_capacity;
+    const size_t out_capacity;
+    // most recent entries first
+    std::list<uint64_t> a1in;
+    std::list<uint64_t> a1out;
+    std::list<uint64_t> am;
+    std::unordered_map<uint64_t, Entry> entries;
+
+    std::list<uint64_t>& getQueue(const Queue queue) {
+      return (queue == BBTreeTwoQueuePolicy::A1IN) ? this->a1in :
+             ((queue == BBTreeTwoQueuePolicy::A1OUT) ? this->a1out : this->am);
+    }
+
+    void push(const uint64_t key, const Queue queue) {
+      std::list<uint64_t> &list = this->getQueue(queue);
+      list.push_front(key);
+      Entry &entry = this->entries[key];
+      entry.queue = queue;
+      entry.position = list.begin();
+    }
+
+    bool evictFrom(const Queue queue,
+                   const std::function<bool(uint64_t)> &is_evictable,
+                   uint64_t &victim) {
+      std::list<uint64_t> &list = this->getQueue(queue);
+      for (auto it = list.rbegin(); it != list.rend(); ++it) {
+        if (!is_evictable(*it))
+          continue;
+        victim = *it;
+        list.erase(std::next(it).base());
+        if (queue == BBTreeTwoQueuePolicy::A1IN) {
+          // remember entries that leave A1in
+          this->push(victim, BBTreeTwoQueuePolicy::A1OUT);
+          if (this->a1out.size() > this->out_capacity) {
+            this->entries.erase(this->a1out.back());
+            this->a1out.pop_back();
+          }
+        } else {
+          this->entries.erase(victim);
+        }
+        return true;
+      }
+      return false;
+    }
+};
+
+/**
+ * ARC (adaptive replacement cache): resident entries are split into those
+ * accessed once recently (T1) and those accessed at least twice (T2). Ghost
+ * lists of recently evicted entries (B1, B2) adapt the target size p of T1
+ * to the workload.
+ */
+class BBTreeARCPolicy : public BBTreeReplacementPolicy {
+  public:
+    explicit BBTreeARCPolicy(const size_t capacity) :
+      capacity(std::max((size_t) 1, capacity)), p(0.0) {}
+
+    void Insert(const uint64_t key) {
+      auto entry = this->entries.find(key);
+      if (entry != this->entries.end()) {
+        if (entry->second.list == BBTreeARCPolicy::B1) {
+          // T1 was too small
+          const double delta = std::max(1.0, (double) this->b2.size() / this->b1.size());
+          this->p = std::min((double) this->capacity, this->p + delta);
+          this->b1.erase(entry->second.position);
+        } else {
+          // T2 was too small
+          const double delta = std::max(1.0, (double) this->b1.size() / this->b2.size());
+          this->p = std::max(0.0, this->p - delta);
+          this->b2.erase(entry->second.position);
+        }
+        this->push(key, BBTreeARCPolicy::T2);
+      } else {
+        this->push(key, BBTreeARCPolicy::T1);
+      }
+      this->trimGhosts();
+    }
+
+    void Access(const uint64_t key) {
+      Entry &entry = this->entries[key];
+      this->getList(entry.list).erase(entry.position);
+      this->push(key, BBTreeARCPolicy::T2);
+    }
+
+    void Remove(const uint64_t key) {
+      auto entry = this->entries.find(key);
+      if (entry == this->entries.end() ||
+          entry->second.list == BBTreeARCPolicy::B1 ||
+          entry->second.list == BBTreeARCPolicy::B2)
+        return;
+      this->getList(entry->second.list).erase(entry->second.position);
+      this->entries.erase(entry);
+    }
+
+    bool Evict(const std::function<bool(uint64_t)> &is_evictable,
+               uint64_t &victim) {
+      const bool from_t1 = !this->t1.empty() &&
+                           (this->t1.size() > this->p || this->t2.empty());
+      if (this->evictFrom(from_t1 ? BBTreeARCPolicy::T1 : BBTreeARCPolicy::T2,
+                          is_evictable, victim) ||
+          this->evictFrom(from_t1 ? BBTreeARCPolicy::T2 : BBTreeARCPolicy::T1,
+                          is_evictable, victim)) {
+        this->trimGhosts();
+        return true;
+      }
+      return false;
+    }
+
+    const char* GetName() const { return "ARC"; }
+  private:
+    enum List { T1, T2, B1, B2 };
+    struct Entry {
+      List list;
+      std::list<uint64_t>::iterator position;
+    };
+
+    const size_t capacity;
+    // target size of T1
+    double p;
+    // most recent entries first
+    std::list<uint64_t> t1;
+    std::list<uint64_t> t2;
+    std::list<uint64_t> b1;
+    std::list<uint64_t> b2;
+    std::unordered_map<uint64_t, Entry> entries;
+
+    std::list<uint64_t>& getList(const List list) {
+      switch (list) {
+        case BBTreeARCPolicy::T1: return this->t1;
+        case BBTreeARCPolicy::T2: return this->t2;
+        case BBTreeARCPolicy::B1: return this->b1;
+        default: return this->b2;
+      }
+    }
+
+    void push(const uint64_t key, const List list) {
+      std::list<uint64_t> &keys = this->getList(list);
+      keys.push_front(key);
+      Entry &entry = this->entries[key];
+      entry.list = list;
+      entry.position = keys.begin();
+    }
+
+    bool evictFrom(const List list,
+                   const std::function<bool(uint64_t)> &is_evictable,
+                   uint64_t &victim) {
+      std::list<uint64_t> &keys = this->getList(list);
+      for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+        if (!is_evictable(*it))
+          continue;
+        victim = *it;
+        keys.erase(std::next(it).base());
+        this->push(victim, (list == BBTreeARCPolicy::T1) ? BBTreeARCPolicy::B1 :
+                                                           BBTreeARCPolicy::B2);
+        return true;
+      }
+      return false;
+    }
+
+    void trimGhosts() {
+      while (this->t1.size() + this->b1.size() > this->capacity &&
+             !this->b1.empty()) {
+        this->entries.erase(this->b1.back());
+        this->b1.pop_back();
+      }
+      while (this->t1.size() + this->t2.size() + this->b1.size() +
+             this->b2.size() > 2 * this->capacity && !this->b2.empty()) {
+        this->entries.erase(this->b2.back());
+        this->b2.pop_back();
+      }
+    }
+};
+
+/**
+ * LIRS (low inter-reference recency set): entries with a low reuse distance
+ * (LIR) stay resident; all others (HIR) share a small part of the cache and
+ * are evicted first. The stack S orders entries by recency and keeps
+ * non-resident HIR entries to measure their reuse distance; the queue Q
+ * holds the resident HIR entries.
+ */
+class BBTreeLIRSPolicy : public BBTreeReplacementPolicy {
+  public:
+    explicit BBTreeLIRSPolicy(const size_t capacity) :
+      hir_capacity(std::max((size_t) 1, (size_t) (capacity * REPLACEMENT_LIRS_HIR_RATIO))),
+      lir_capacity((capacity > this->hir_capacity) ? capacity - this->hir_capacity : 1),
+      ghost_capacity(std::max((size_t) 1, (size_t) (capacity * REPLACEMENT_LIRS_GHOST_RATIO))),
+      num_lir(0), num_non_resident(0) {}
+
+    void Insert(const uint64_t key) {
+      auto entry = this->entries.find(key);
+      if (entry == this->entries.end()) {
+        State &state = this->entries[key];
+        if (this->num_lir < this->lir_capacity) {
+          state.status = BBTreeLIRSPolicy::LIR;
+          this->num_lir++;
+        } else {
+          state.status = BBTreeLIRSPolicy::HIR_RESIDENT;
+          this->enqueue(key, state);
+        }
+        this->pushTop(key, state);
+        return;
+      }
+
+      // non-resident HIR entry in the stack: its reuse distance is low
+      State &state = entry->second;
+      this->num_non_resident--;
+      state.status = BBTreeLIRSPolicy::LIR;
+      this->num_lir++;
+      this->pushTop(key, state);
+      if (this->num_lir > this->lir_capacity)
+        this->demoteBottom();
+    }
+
+    void Access(const uint64_t key) {
+      State &state = this->entries[key];
+      if (state.status == BBTreeLIRSPolicy::LIR) {
+        const bool bottom = (this->stack.back() == key);
+        this->pushTop(key, state);
+        if (bottom)
+          this->prune();
+      } else if (state.in_stack) {
+        // resident HIR entry with a low reuse distance
+        this->dequeue(state);
+        state.status = BBTreeLIRSPolicy::LIR;
+        this->num_lir++;
+        this->pushTop(key, state);
+        if (this->num_lir > this->lir_capacity)
+          this->demoteBottom();
+      } else {
+        this->pushTop(key, state);
+        this->dequeue(state);
+        this->enqueue(key, state);
+      }
+    }
+
+    void Remove(const uint64_t key) {
+      auto entry = this->entries.find(key);
+      if (entry == this->entries.end() ||
+          entry->second.status == BBTreeLIRSPolicy::HIR_NON_RESIDENT)
+        return;
+      State &state = entry->second;
+      if (state.status == BBTreeLIRSPolicy::LIR)
+        this->num_lir--;
+      this->dequeue(state);
+      if (state.in_stack)
+        this->stack.erase(state.stack_position);
+      this->entries.erase(entry);
+      this->prune();
+    }
+
+    bool Evict(const std::function<bool(uint64_t)> &is_evictable,
+               uint64_t &victim) {
+      // resident HIR entries first
+      for (auto it = this->queue.begin(); it != this->queue.end(); ++it) {
+        if (!is_evictable(*it))
+          continue;
+        victim = *it;
+        State &state = this->entries[victim];
+        this->dequeue(state);
+        if (state.in_stack) {
+          state.status = BBTreeLIRSPolicy::HIR_NON_RESIDENT;
+          this->num_non_resident++;
+          this->trimGhosts();
+        } else {
+          this->entries.erase(victim);
+        }
+        return true;
+      }
+      // then the LIR entries with the largest recency
+      for (auto it = this->stack.rbegin(); it != this->stack.rend(); ++it) {
+        const uint64_t key = *it;
+        if (this->entries[key].status != BBTreeLIRSPolicy::LIR || !is_evictable(key))
+          continue;
+        victim = key;
+        this->Remove(victim);
+        return true;
+      }
+      return false;
+    }
+
+    const char* GetName() const { return "LIRS"; }
+  private:
+    enum Status { LIR, HIR_RESIDENT, HIR_NON_RESIDENT };
+    struct State {
+      Status status;
+      bool in_stack;
+      bool in_queue;
+      std::list<uint64_t>::iterator stack_position;
+      std::list<uint64_t>::iterator queue_position;
+
+      State() : status(LIR), in_stack(false), in_queue(false) {}
+    };
+
+    const size_t hir_capacity;
+    const size_t lir_capacity;
+    const size_t ghost_capacity;
+    size_t num_lir;
+    size_t num_non_resident;
+    // stack S, most recent entry first
+    std::list<uint64_t> stack;
+    // queue Q of resident HIR entries, next victim first
+    std::list<uint64_t> queue;
+    std::unordered_map<uint64_t, State> entries;
+
+    void pushTop(const uint64_t key, State &state) {
+      if (state.in_stack)
+        this->stack.erase(state.stack_position);
+      this->stack.push_front(key);
+      state.stack_position = this->stack.begin();
+      state.in_stack = true;
+    }
+
+    void enqueue(const uint64_t key, State &state) {
+      this->queue.push_back(key);
+      state.queue_position = std::prev(this->queue.end());
+      state.in_queue = true;
+    }
+
+    void dequeue(State &state) {
+      if (!state.in_queue)
+        return;
+      this->queue.erase(state.queue_position);
+      state.in_queue = false;
+    }
+
+    // removes HIR entries from the bottom of the stack
+    void prune() {
+      while (!this->stack.empty()) {
+        const uint64_t key = this->stack.back();
+        State &state = this->entries[key];
+        if (state.status == BBTreeLIRSPolicy::LIR)
+          break;
+        this->stack.pop_back();
+        state.in_stack = false;
+        if (state.status == BBTreeLIRSPolicy::HIR_NON_RESIDENT) {
+          this->num_non_resident--;
+          this->entries.erase(key);
+        }
+      }
+    }
+
+    // turns the LIR entry at the bottom of the stack into a resident HIR entry
+    void demoteBottom() {
+      this->prune();
+      const uint64_t key = this->stack.back();
+      State &state = this->entries[key];
+      this->stack.pop_back();
+      state.in_stack = false;
+      state.status = BBTreeLIRSPolicy::HIR_RESIDENT;
+      this->num_lir--;
+      this->enqueue(key, state);
+      this->prune();
+    }
+
+    // forgets the oldest non-resident entries
+    void trimGhosts() {
+      for (auto it = this->stack.rbegin();
+           it != this->stack.rend() && this->num_non_resident > this->ghost_capacity;) {
+        const uint64_t key = *it;
+        if (this->entries[key].status != BBTreeLIRSPolicy::HIR_NON_RESIDENT) {
+          ++it;
+          continue;
+        }
+        it = std::list<uint64_t>::reverse_iterator(this->stack.erase(std::next(it).base()));
+        this->entries.erase(key);
+        this->num_non_resident--;
+      }
+    }
+};
+
+/**
+ * BBTreeReplacementPolicy::Create(type, capacity) returns a new replacement
+ * policy of the given type for a cache of capacity entries.
+ */
+inline BBTreeReplacementPolicy* BBTreeReplacementPolicy::Create(const BBTreeReplacement type,
+                                                                const size_t capacity) {
+  switch (type) {
+    case BBTREE_REPLACEMENT_CLOCK:
+      return new BBTreeClockPolicy();
+    case BBTREE_REPLACEMENT_2Q:
+      return new BBTreeTwoQueuePolicy(capacity);
+    case BBTREE_REPLACEMENT_ARC:
+      return new BBTreeARCPolicy(capacity);
+    case BBTREE_REPLACEMENT_LIRS:
+      return new BBTreeLIRSPolicy(capacity);
+    case BBTREE_REPLACEMENT_LFU:
+      return new BBTreeLFUPolicy();
+    default:
+      return new BBTreeLRUPolicy();
+  }
+}
+
+/**
+ * BBTreeReplacementPolicy::GetTypeName(type) returns the name of the given
+ * replacement policy.
+ */
+inline const char* BBTreeReplacementPolicy::GetTypeName(const BBTreeReplacement type) {
+  switch (type) {
+    case BBTREE_REPLACEMENT_CLOCK: return "CLOCK";
+    case BBTREE_REPLACEMENT_2Q: return "2Q";
+    case BBTREE_REPLACEMENT_ARC: return "ARC";
+    case BBTREE_REPLACEMENT_LIRS: return "LIRS";
+    case BBTREE_REPLACEMENT_LFU: return "LFU";
+    default: return "LRU";
+  }
+}
+
+#endif
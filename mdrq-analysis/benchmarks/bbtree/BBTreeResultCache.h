@@ -0,0 +1,137 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREERESULTCACHE
+#define BBTREERESULTCACHE
+#pragma once
+
+// Default memory budget of the cached results in bytes
+#define RESULT_CACHE_BUDGET (64 * 1024 * 1024)
+// Grid width used to quantize the boundaries of range queries for hashing
+#define RESULT_CACHE_QUANTUM 1e-3
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "BBTreeTidSet.h"
+
+class BBTree;
+
+/**
+ * Eviction policy of a BBTreeResultCache.
+ */
+enum BBTreeCachePolicy {
+  // evicts the least recently used result
+  BBTREE_CACHE_LRU,
+  // evicts the least frequently used result
+  BBTREE_CACHE_LFU,
+  // GreedyDual-Size: evicts the result with the lowest runtime per byte,
+  // aged by the priority of the last evicted result
+  BBTREE_CACHE_GREEDY_DUAL
+};
+
+/**
+ * Cache of the results of range queries on a BB-Tree. Repeated range queries
+ * with exactly the same boundaries are answered from the cache.
+ *
+ * Results are stored as compressed tid sets (see BBTreeTidSet) together with
+ * the versions of all buckets that the query reads. A cached result is only
+ * returned if none of these buckets has been modified since, and if the
+ * BB-Tree has not been rebuilt; otherwise, it is dropped and the query is
+ * executed again. Cached results are evicted by the given policy once their
+ * total size exceeds the memory budget.
+ *
+ * Results of cache hits are sorted by tid, results of misses are returned in
+ * the order of the BB-Tree. Tids must be unique.
+ *
+ * Example usage:
+ *   BBTreeResultCache cache(*bbtree, BBTREE_CACHE_GREEDY_DUAL);
+ *   std::vector<uint32_t> results = cache.SearchRangeMT(lower_boundary,
+ *                                                       upper_boundary);
+ */
+class BBTreeResultCache {
+  public:
+    explicit BBTreeResultCache(BBTree &bbtree,
+                               const BBTreeCachePolicy policy = BBTREE_CACHE_LRU,
+                               const size_t budget = RESULT_CACHE_BUDGET);
+
+    std::vector<uint32_t> SearchRange(const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary);
+    std::vector<uint32_t> SearchRangeMT(const std::vector<float> &lower_boundary,
+                                        const std::vector<float> &upper_boundary);
+    void Clear();
+    size_t GetHits() const;
+    size_t GetMisses() const;
+    size_t GetNumberOfEntries() const;
+    size_t GetSizeInBytes() const;
+  private:
+    /**
+     * Cached result of a range query.
+     */
+    struct Entry {
+      std::vector<float> lower_boundary;
+      std::vector<float> upper_boundary;
+      BBTreeTidSet tids;
+      // buckets read by the query and their versions at caching time
+      std::vector<size_t> buckets;
+      std::vector<uint64_t> versions;
+      uint64_t structure_version;
+      uint64_t hash;
+      size_t bytes;
+      // runtime of the query in ms
+      double cost;
+      size_t frequency;
+      double priority;
+    };
+
+    BBTree &bbtree;
+    const BBTreeCachePolicy policy;
+    const size_t budget;
+
+    std::unordered_map<uint64_t, Entry> entries;
+    // hashes of the quantized boundaries to entry ids
+    std::unordered_multimap<uint64_t, uint64_t> index;
+    // entries ordered by priority, lowest first
+    std::set<std::pair<double, uint64_t> > eviction_order;
+    uint64_t next_id;
+    // logical clock of the LRU policy
+    uint64_t clock;
+    // aging value of the GreedyDual policy
+    double inflation;
+    size_t size_in_bytes;
+    size_t hits;
+    size_t misses;
+
+    std::vector<uint32_t> searchRange(const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary,
+                                      const bool multithreaded);
+    static uint64_t getHash(const std::vector<float> &lower_boundary,
+                            const std::vector<float> &upper_boundary);
+    Entry* lookup(const uint64_t hash,
+                  const std::vector<float> &lower_boundary,
+                  const std::vector<float> &upper_boundary,
+                  uint64_t &id);
+    bool isValid(const Entry &entry) const;
+    void insert(const uint64_t hash,
+                const std::vector<float> &lower_boundary,
+                const std::vector<float> &upper_boundary,
+                const std::vector<uint32_t> &results,
+                const double cost);
+    void touch(const uint64_t id, Entry &entry);
+    double getPriority(const Entry &entry);
+    void erase(const uint64_t id);
+};
+
+#endif
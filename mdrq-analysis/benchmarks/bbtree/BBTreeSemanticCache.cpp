@@ -0,0 +1,391 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeSemanticCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "BBTree.h"
+
+/**
+ * BBTreeSemanticCache(bbtree, budget) creates an empty semantic cache for
+ * range queries on the given BB-Tree that holds up to budget bytes of
+ * cached data objects.
+ */
+BBTreeSemanticCache::BBTreeSemanticCache(BBTree &bbtree, const size_t budget) :
+  bbtree(bbtree), budget(budget), size_in_bytes(0), hits(0), partial_hits(0),
+  misses(0), remainder_queries(0) {}
+
+/**
+ * BBTreeSemanticCache::SearchRange(lower_boundary, upper_boundary) answers
+ * the specified range query from the cached boxes if possible, and executes
+ * it (or its remainder queries) with BBTree::SearchRangeStream() otherwise.
+ * It returns the tids of the matching objects.
+ */
+std::vector<uint32_t> BBTreeSemanticCache::SearchRange(const std::vector<float> &lower_boundary,
+                                                       const std::vector<float> &upper_boundary) {
+  return this->searchRange(lower_boundary, upper_boundary, false);
+}
+
+/**
+ * BBTreeSemanticCache::SearchRangeMT(lower_boundary, upper_boundary) is the
+ * same as SearchRange(), but executes queries on the BB-Tree with
+ * BBTree::SearchRangeStreamMT().
+ */
+std::vector<uint32_t> BBTreeSemanticCache::SearchRangeMT(const std::vector<float> &lower_boundary,
+                                                         const std::vector<float> &upper_boundary) {
+  return this->searchRange(lower_boundary, upper_boundary, true);
+}
+
+/**
+ * BBTreeSemanticCache::Clear() drops all cached boxes. The statistics are
+ * kept.
+ */
+void BBTreeSemanticCache::Clear() {
+  this->entries.clear();
+  this->size_in_bytes = 0;
+}
+
+/**
+ * BBTreeSemanticCache::GetHits() returns the number of range queries that
+ * have been answered from a single cached box.
+ */
+size_t BBTreeSemanticCache::GetHits() const {
+  return this->hits;
+}
+
+/**
+ * BBTreeSemanticCache::GetPartialHits() returns the number of range queries
+ * that have been answered from a cached box plus remainder queries.
+ */
+size_t BBTreeSemanticCache::GetPartialHits() const {
+  return this->partial_hits;
+}
+
+/**
+ * BBTreeSemanticCache::GetMisses() returns the number of range queries that
+ * have been executed on the BB-Tree.
+ */
+size_t BBTreeSemanticCache::GetMisses() const {
+  return this->misses;
+}
+
+/**
+ * BBTreeSemanticCache::GetRemainderQueries() returns the number of remainder
+ * queries executed for partial hits.
+ */
+size_t BBTreeSemanticCache::GetRemainderQueries() const {
+  return this->remainder_queries;
+}
+
+/**
+ * BBTreeSemanticCache::GetNumberOfEntries() returns the number of cached
+ * boxes.
+ */
+size_t BBTreeSemanticCache::GetNumberOfEntries() const {
+  return this->entries.size();
+}
+
+/**
+ * BBTreeSemanticCache::GetSizeInBytes() returns the total size of the cached
+ * boxes, which does not exceed the memory budget.
+ */
+size_t BBTreeSemanticCache::GetSizeInBytes() const {
+  return this->size_in_bytes;
+}
+
+/**
+ * BBTreeSemanticCache::searchRange(lower_bounds,upper_bounds,multithreaded)
+ * answers a range query from a containing box, from the box that covers the
+ * largest fraction of the query plus remainder queries, or from the
+ * BB-Tree. Only boxes that would answer the query are validated against the
+ * bucket versions; invalid ones are dropped on the way.
+ */
+std::vector<uint32_t> BBTreeSemanticCache::searchRange(const std::vector<float> &lower_boundary,
+                                                       const std::vector<float> &upper_boundary,
+                                                       const bool multithreaded) {
+  std::vector<uint32_t> tids;
+  std::vector<float> data_lower;
+  std::vector<float> data_upper;
+  if (!this->entries.empty())
+    this->getDataBounds(data_lower, data_upper);
+  // boxes that cover enough of the query, with their overlaps
+  std::vector<std::pair<double, std::list<Entry>::iterator> > candidates;
+  for (std::list<Entry>::iterator it = this->entries.begin();
+       it != this->entries.end();) {
+    if (it->structure_version != this->bbtree.structure_version) {
+      // the box was cached before a rebuild
+      this->size_in_bytes -= it->bytes;
+      it = this->entries.erase(it);
+      continue;
+    }
+    if (BBTreeSemanticCache::contains(*it, lower_boundary, upper_boundary)) {
+      if (!this->isValid(*it)) {
+        // some bucket of the box has been modified
+        this->size_in_bytes -= it->bytes;
+        it = this->entries.erase(it);
+        continue;
+      }
+      this->hits++;
+      BBTreeSemanticCache::filterEntry(*it, lower_boundary, upper_boundary,
+                                       tids, NULL);
+      this->entries.splice(this->entries.begin(), this->entries, it);
+      return tids;
+    }
+    const double overlap = BBTreeSemanticCache::getOverlap(lower_boundary,
+                                                           upper_boundary,
+                                                           data_lower,
+                                                           data_upper,
+                                                           *it);
+    if (overlap >= SEMANTIC_CACHE_MIN_OVERLAP)
+      candidates.push_back(std::make_pair(overlap, it));
+    ++it;
+  }
+
+  // the box with the largest overlap that is still valid answers the query
+  std::list<Entry>::iterator best = this->entries.end();
+  std::stable_sort(candidates.begin(), candidates.end(),
+    [](const std::pair<double, std::list<Entry>::iterator> &a,
+       const std::pair<double, std::list<Entry>::iterator> &b) {
+      return a.first > b.first;
+    });
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (this->isValid(*candidates[i].second)) {
+      best = candidates[i].second;
+      break;
+    }
+    this->size_in_bytes -= candidates[i].second->bytes;
+    this->entries.erase(candidates[i].second);
+  }
+
+  std::vector<float> objects;
+  if (best != this->entries.end()) {
+    this->partial_hits++;
+    BBTreeSemanticCache::filterEntry(*best, lower_boundary, upper_boundary,
+                                     tids, &objects);
+    std::vector<std::vector<float> > lower_boundaries;
+    std::vector<std::vector<float> > upper_boundaries;
+    BBTreeSemanticCache::getRemainder(lower_boundary, upper_boundary, *best,
+                                      lower_boundaries, upper_boundaries);
+    for (size_t i = 0; i < lower_boundaries.size(); ++i) {
+      this->remainder_queries++;
+      this->searchTree(lower_boundaries[i], upper_boundaries[i], multithreaded,
+                       tids, objects);
+    }
+  } else {
+    this->misses++;
+    this->searchTree(lower_boundary, upper_boundary, multithreaded, tids,
+                     objects);
+  }
+
+  std::vector<uint32_t> results(tids);
+  this->insert(lower_boundary, upper_boundary, tids, objects);
+  return results;
+}
+
+/**
+ * BBTreeSemanticCache::isValid(entry) returns true if neither the bucket
+ * directory nor any bucket read by the query of the cached box has changed.
+ */
+bool BBTreeSemanticCache::isValid(const Entry &entry) const {
+  if (entry.structure_version != this->bbtree.structure_version)
+    return false;
+  for (size_t i = 0; i < entry.buckets.size(); ++i) {
+    if (this->bbtree.bucket_versions[entry.buckets[i]] != entry.versions[i])
+      return false;
+  }
+  return true;
+}
+
+/**
+ * BBTreeSemanticCache::contains(entry,lower_bounds,upper_bounds) returns
+ * true if the given range query lies within the cached box.
+ */
+bool BBTreeSemanticCache::contains(const Entry &entry,
+                                   const std::vector<float> &lower_boundary,
+                                   const std::vector<float> &upper_boundary) {
+  for (size_t j = 0; j < lower_boundary.size(); ++j) {
+    if (lower_boundary[j] < entry.lower_boundary[j] ||
+        upper_boundary[j] > entry.upper_boundary[j])
+      return false;
+  }
+  return true;
+}
+
+/**
+ * BBTreeSemanticCache::getOverlap(lower_bounds,upper_bounds,data_lower,data_upper,entry)
+ * returns the fraction of the volume of the given range query that is
+ * covered by the cached box. The query is clamped to the bounds of the data
+ * objects (data_lower and data_upper), such that unbounded dimensions count
+ * by the part of the data that the box covers. Dimensions in which the
+ * clamped query is a point count as covered if the box intersects them.
+ */
+double BBTreeSemanticCache::getOverlap(const std::vector<float> &lower_boundary,
+                                       const std::vector<float> &upper_boundary,
+                                       const std::vector<float> &data_lower,
+                                       const std::vector<float> &data_upper,
+                                       const Entry &entry) {
+  double overlap = 1.0;
+  for (size_t j = 0; j < lower_boundary.size(); ++j) {
+    const double lower = std::max(lower_boundary[j], entry.lower_boundary[j]);
+    const double upper = std::min(upper_boundary[j], entry.upper_boundary[j]);
+    if (lower > upper)
+      return 0.0;
+    const double query_lower = std::max(lower_boundary[j], data_lower[j]);
+    const double query_upper = std::min(upper_boundary[j], data_upper[j]);
+    const double width = query_upper - query_lower;
+    if (width > 0.0) {
+      const double covered = std::min(upper, query_upper) -
+                             std::max(lower, query_lower);
+      overlap *= std::max(covered, 0.0) / width;
+    }
+  }
+  return overlap;
+}
+
+/**
+ * BBTreeSemanticCache::getDataBounds(data_lower,data_upper) stores the
+ * bounds of all data objects of the BB-Tree, i.e., of the union of its zone
+ * maps, in data_lower and data_upper.
+ */
+void BBTreeSemanticCache::getDataBounds(std::vector<float> &data_lower,
+                                        std::vector<float> &data_upper) const {
+  const size_t dimensions = this->bbtree.dimensions;
+  data_lower.assign(dimensions, std::numeric_limits<float>::max());
+  data_upper.assign(dimensions, -std::numeric_limits<float>::max());
+  for (size_t i = 0; i < this->bbtree.num_buckets; ++i) {
+    // empty zone maps have inverted bounds and do not extend the union
+    const float* zone_map = this->bbtree.zone_maps + 2 * dimensions * i;
+    for (size_t j = 0; j < dimensions; ++j) {
+      data_lower[j] = std::min(data_lower[j], zone_map[j]);
+      data_upper[j] = std::max(data_upper[j], zone_map[dimensions + j]);
+    }
+  }
+}
+
+/**
+ * BBTreeSemanticCache::getRemainder(lower_bounds,upper_bounds,entry,
+ * lower_boundaries,upper_boundaries) splits the part of the given range
+ * query that is not covered by the cached box into at most 2m disjoint
+ * boxes: per dimension, the slabs below and above the box, restricted to
+ * the box in all previously processed dimensions.
+ */
+void BBTreeSemanticCache::getRemainder(const std::vector<float> &lower_boundary,
+                                       const std::vector<float> &upper_boundary,
+                                       const Entry &entry,
+                                       std::vector<std::vector<float> > &lower_boundaries,
+                                       std::vector<std::vector<float> > &upper_boundaries) {
+  std::vector<float> lower(lower_boundary);
+  std::vector<float> upper(upper_boundary);
+  for (size_t j = 0; j < lower.size(); ++j) {
+    if (lower[j] < entry.lower_boundary[j]) {
+      lower_boundaries.push_back(lower);
+      upper_boundaries.push_back(upper);
+      upper_boundaries.back()[j] = std::nextafter(entry.lower_boundary[j],
+        -std::numeric_limits<float>::infinity());
+      lower[j] = entry.lower_boundary[j];
+    }
+    if (upper[j] > entry.upper_boundary[j]) {
+      lower_boundaries.push_back(lower);
+      upper_boundaries.push_back(upper);
+      lower_boundaries.back()[j] = std::nextafter(entry.upper_boundary[j],
+        std::numeric_limits<float>::infinity());
+      upper[j] = entry.upper_boundary[j];
+    }
+  }
+}
+
+/**
+ * BBTreeSemanticCache::filterEntry(entry,lower_bounds,upper_bounds,tids,objects)
+ * appends the cached data objects that match the given range query to tids
+ * and, if objects is not NULL, their feature vectors to objects.
+ */
+void BBTreeSemanticCache::filterEntry(const Entry &entry,
+                                      const std::vector<float> &lower_boundary,
+                                      const std::vector<float> &upper_boundary,
+                                      std::vector<uint32_t> &tids,
+                                      std::vector<float> *objects) {
+  const size_t dimensions = lower_boundary.size();
+  for (size_t i = 0; i < entry.tids.size(); ++i) {
+    const float* object = entry.objects.data() + i * dimensions;
+    bool match = true;
+    for (size_t j = 0; j < dimensions && match; ++j)
+      match = object[j] >= lower_boundary[j] && object[j] <= upper_boundary[j];
+    if (match) {
+      tids.push_back(entry.tids[i]);
+      if (objects != NULL)
+        objects->insert(objects->end(), object, object + dimensions);
+    }
+  }
+}
+
+/**
+ * BBTreeSemanticCache::searchTree(lower_bounds,upper_bounds,multithreaded,tids,objects)
+ * executes a range query on the BB-Tree and appends the matching tids and
+ * feature vectors to tids and objects.
+ */
+void BBTreeSemanticCache::searchTree(const std::vector<float> &lower_boundary,
+                                     const std::vector<float> &upper_boundary,
+                                     const bool multithreaded,
+                                     std::vector<uint32_t> &tids,
+                                     std::vector<float> &objects) {
+  const std::function<bool(const BBTreeResultBatch&)> callback =
+    [&tids, &objects](const BBTreeResultBatch &batch) {
+      tids.insert(tids.end(), batch.tids.begin(), batch.tids.end());
+      objects.insert(objects.end(), batch.objects.begin(), batch.objects.end());
+      return true;
+    };
+  if (multithreaded)
+    this->bbtree.SearchRangeStreamMT(lower_boundary, upper_boundary, callback, true);
+  else
+    this->bbtree.SearchRangeStream(lower_boundary, upper_boundary, callback, true);
+}
+
+/**
+ * BBTreeSemanticCache::insert(lower_bounds,upper_bounds,tids,objects) caches
+ * the box of a range query with its matching data objects (taking over tids
+ * and objects) and evicts the least recently used boxes until
+ * SEMANTIC_CACHE_MAX_ENTRIES and the memory budget are met. Boxes larger
+ * than the budget are not cached.
+ */
+void BBTreeSemanticCache::insert(const std::vector<float> &lower_boundary,
+                                 const std::vector<float> &upper_boundary,
+                                 std::vector<uint32_t> &tids,
+                                 std::vector<float> &objects) {
+  Entry entry;
+  entry.lower_boundary = lower_boundary;
+  entry.upper_boundary = upper_boundary;
+  entry.tids.swap(tids);
+  entry.objects.swap(objects);
+  this->bbtree.planCachedResult(lower_boundary, upper_boundary, entry.buckets);
+  entry.versions.resize(entry.buckets.size());
+  for (size_t i = 0; i < entry.buckets.size(); ++i)
+    entry.versions[i] = this->bbtree.bucket_versions[entry.buckets[i]];
+  entry.structure_version = this->bbtree.structure_version;
+  entry.bytes = sizeof(Entry) +
+                2 * lower_boundary.size() * sizeof(float) +
+                entry.tids.size() * sizeof(uint32_t) +
+                entry.objects.size() * sizeof(float) +
+                entry.buckets.size() * (sizeof(size_t) + sizeof(uint64_t));
+  if (entry.bytes > this->budget)
+    return;
+
+  this->size_in_bytes += entry.bytes;
+  this->entries.push_front(std::move(entry));
+  while (this->entries.size() > SEMANTIC_CACHE_MAX_ENTRIES ||
+         this->size_in_bytes > this->budget) {
+    this->size_in_bytes -= this->entries.back().bytes;
+    this->entries.pop_back();
+  }
+}
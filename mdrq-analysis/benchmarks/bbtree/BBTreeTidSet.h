@@ -0,0 +1,104 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREETIDSET
+#define BBTREETIDSET
+#pragma once
+
+// Containers with up to this many tids are stored as sorted arrays,
+// larger ones as bitmaps of 2^16 bits
+#define TIDSET_ARRAY_MAX 4096
+// Number of 64-bit words of a bitmap container
+#define TIDSET_BITMAP_WORDS 1024
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compressed set of tids in the style of roaring bitmaps.
+ *
+ * The tids are partitioned by their upper 16 bits into containers that
+ * hold the lower 16 bits either as a sorted array (sparse containers) or as
+ * a bitmap (dense containers), so a container of n tids needs about
+ * min(2, 8192 / n) bytes per tid.
+ *
+ * Example usage:
+ *   BBTreeTidSet matches = selection.ToTidSet();
+ *   BBTreeTidSet both = matches.Intersect(other_matches);
+ *   both.ForEach([](uint32_t tid) { ... });
+ */
+class BBTreeTidSet {
+  public:
+    BBTreeTidSet() : cardinality(0) {}
+
+    void Add(const uint32_t tid);
+    bool Contains(const uint32_t tid) const;
+    size_t Count() const;
+    BBTreeTidSet Intersect(const BBTreeTidSet &other) const;
+    template <typename Function>
+    void ForEach(Function function) const;
+    std::vector<uint32_t> ToVector() const;
+    void Optimize();
+    size_t GetSizeInBytes() const;
+    void Clear();
+  private:
+    /**
+     * Lower 16 bits of all tids that share the upper 16 bits key.
+     */
+    struct Container {
+      uint16_t key;
+      uint32_t cardinality;
+      // sorted values of an array container
+      std::vector<uint16_t> values;
+      // TIDSET_BITMAP_WORDS words of a bitmap container
+      std::vector<uint64_t> bits;
+
+      bool isBitmap() const { return !this->bits.empty(); }
+    };
+
+    // containers ordered by key
+    std::vector<Container> containers;
+    size_t cardinality;
+
+    Container& getContainer(const uint16_t key);
+    static void toBitmap(Container &container);
+    static void toArray(Container &container);
+    static void intersectContainers(const Container &a,
+                                    const Container &b,
+                                    Container &result);
+};
+
+/**
+ * BBTreeTidSet::ForEach(function) calls function(tid) for all tids of the set
+ * in ascending order.
+ */
+template <typename Function>
+void BBTreeTidSet::ForEach(Function function) const {
+  for (size_t i = 0; i < this->containers.size(); ++i) {
+    const Container &container = this->containers[i];
+    const uint32_t high = ((uint32_t) container.key) << 16;
+    if (container.isBitmap()) {
+      for (size_t w = 0; w < TIDSET_BITMAP_WORDS; ++w) {
+        uint64_t word = container.bits[w];
+        while (word != 0) {
+          function(high | (uint32_t) (w * 64 + __builtin_ctzll(word)));
+          word &= word - 1;
+        }
+      }
+    } else {
+      for (size_t j = 0; j < container.values.size(); ++j)
+        function(high | container.values[j]);
+    }
+  }
+}
+
+#endif
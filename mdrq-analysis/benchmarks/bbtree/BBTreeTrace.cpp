@@ -0,0 +1,51 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeTrace.h"
+
+#include <cassert>
+
+/**
+ * BBTreeTrace(path, dimensions) opens the trace file at path for appending
+ * and starts a new trace of a BB-Tree with the given dimensionality.
+ */
+BBTreeTrace::BBTreeTrace(const std::string &path, const size_t dimensions) :
+  file(path.c_str(), std::ios::out | std::ios::app) {
+  assert(this->file.is_open());
+  this->file << "T " << dimensions << '\n';
+}
+
+/**
+ * ~BBTreeTrace() flushes and closes the trace file.
+ */
+BBTreeTrace::~BBTreeTrace() {
+  this->file.close();
+}
+
+/**
+ * BBTreeTrace::Record(operation, bucket_id, bytes) records an access of the
+ * given operation to a bucket of the given size.
+ */
+void BBTreeTrace::Record(const BBTreeTraceOperation operation,
+                         const size_t bucket_id,
+                         const size_t bytes) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->file << (char) operation << ' ' << bucket_id << ' ' << bytes << '\n';
+}
+
+/**
+ * BBTreeTrace::MarkRebuild() records that the bucket directory has been
+ * replaced.
+ */
+void BBTreeTrace::MarkRebuild() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->file << "R\n";
+}
@@ -0,0 +1,62 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREETRACE
+#define BBTREETRACE
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+/**
+ * Operations that access buckets, as written to a trace.
+ */
+enum BBTreeTraceOperation {
+  BBTREE_TRACE_QUERY = 'Q',
+  BBTREE_TRACE_INSERT = 'I',
+  BBTREE_TRACE_DELETE = 'D',
+  BBTREE_TRACE_UPDATE = 'U'
+};
+
+/**
+ * Trace of the bucket accesses of a BB-Tree, e.g., to replay them against
+ * cache replacement policies offline (see tools/simulator.cpp).
+ *
+ * Every access is written as a line "<operation> <bucket> <bytes>", where
+ * operation is one of BBTreeTraceOperation and bytes is the size of the
+ * tids and data objects of the bucket. A line "R" marks that the bucket
+ * directory has been replaced (bucket ids are reused for different data
+ * objects afterwards), and a line "T <dimensions>" starts a new trace.
+ * Traces are appended to an existing file, such that the runs of a
+ * benchmark script end up in one file.
+ *
+ * Accesses may be recorded concurrently.
+ */
+class BBTreeTrace {
+  public:
+    BBTreeTrace(const std::string &path, const size_t dimensions);
+    ~BBTreeTrace();
+
+    void Record(const BBTreeTraceOperation operation,
+                const size_t bucket_id,
+                const size_t bytes);
+    void MarkRebuild();
+  private:
+    std::ofstream file;
+    std::mutex mutex;
+
+    BBTreeTrace(const BBTreeTrace &other) = delete;
+    BBTreeTrace& operator=(const BBTreeTrace &other) = delete;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#ifndef BBTREETUNER
+#define BBTREETUNER
+#pragma once
+
+// Smallest average bucket size considered by the auto-tuner
+#define TUNER_MIN_BUCKET_AVG 32
+// Largest average bucket size considered by the auto-tuner
+#define TUNER_MAX_BUCKET_AVG 4096
+// Ratio of maximum to average bucket size (BUCKET_MAX / BUCKET_AVG)
+#define TUNER_BUCKET_MAX_FACTOR 10
+// Upper bound for the working set of a calibration scan in bytes
+#define TUNER_MAX_WORKING_SET (64 * 1024 * 1024)
+// Bucket sizes whose estimated query cost is within this factor of the
+// cheapest bucket size are considered equally fast; the smallest is chosen
+#define TUNER_COST_TOLERANCE 1.1
+// Estimated cost of locating a bucket in the inner nodes in nanoseconds
+#define TUNER_BUCKET_OVERHEAD 100.0
+// Number of range queries per calibration scan
+#define TUNER_CALIBRATION_QUERIES 3
+// Largest fanout considered, in cache lines per inner node
+#define TUNER_MAX_NODE_LINES 4
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Sizes of the data caches of the current machine in bytes.
+ */
+struct BBTreeCacheInfo {
+  size_t line_size;
+  size_t l1d_size;
+  size_t l2_size;
+  size_t llc_size;
+};
+
+/**
+ * Bucket sizes and fanout chosen by BBTreeTuner.
+ */
+struct BBTreeTuning {
+  size_t bucket_max;
+  size_t bucket_avg;
+  size_t delimiters_per_split;
+  // measured scan cost per data object for buckets of size bucket_avg;
+  // 0 if the values have not been calibrated
+  double ns_per_object;
+};
+
+/**
+ * Cache-size-aware auto-tuner for the bucket capacity and the fanout of
+ * the inner nodes.
+ *
+ * It runs short calibration scans on buckets built from a data sample and
+ * picks the average bucket size with the lowest estimated query cost,
+ * i.e., scan cost per data object times the fraction of data objects that
+ * survive pruning by the inner nodes. The fanout is chosen such that an inner node
+ * occupies whole cache lines.
+ * Calibration results are reused as long as the dimensionality and the
+ * size of the working set stay roughly the same.
+ */
+class BBTreeTuner {
+  public:
+    BBTreeTuner() : caches(), probed(false), calibrated_dimensions(0),
+                    calibrated_bytes(0), selectivity(1.0) {}
+    static BBTreeCacheInfo ProbeCaches();
+    BBTreeTuning Tune(const std::vector<std::vector<float> > &samples,
+                      const size_t dimensions,
+                      const size_t count);
+    const BBTreeCacheInfo& getCaches() const;
+  private:
+    BBTreeCacheInfo caches;
+    bool probed;
+    size_t calibrated_dimensions;
+    size_t calibrated_bytes;
+    // average single-dimension selectivity of the calibration queries
+    double selectivity;
+    std::vector<size_t> candidates;
+    std::vector<double> ns_per_object;
+
+    double calibrate(const std::vector<std::vector<float> > &samples,
+                     const size_t bucket_size,
+                     const size_t working_set) const;
+    double measureSelectivity(const std::vector<std::vector<float> > &samples) const;
+};
+
+#endif
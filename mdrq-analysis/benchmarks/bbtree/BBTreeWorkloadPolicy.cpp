@@ -0,0 +1,209 @@
+/*********************************************************
+*
+*  Research Work of Stefan Sprenger
+*  https://www2.informatik.hu-berlin.de/~sprengsz/
+*
+*  Used solely for scholastic work in course CSCE 614 for
+*  the course research project. Adaptations and additions
+*  are marked with //ADDED ... //ADDED.
+*
+*********************************************************/
+
+#include "BBTreeWorkloadPolicy.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "BBTree.h"
+
+/**
+ * BBTreeWorkloadPolicy(bbtree, decay) creates a replacement policy for the
+ * buffer pool of the given BB-Tree that weights the i'th most recent
+ * monitored query by decay^i.
+ */
+BBTreeWorkloadPolicy::BBTreeWorkloadPolicy(const BBTree &bbtree,
+                                           const double decay) :
+  bbtree(bbtree), decay(decay), scored_structure_version(0),
+  next_reads_query(std::numeric_limits<size_t>::max()) {}
+
+/**
+ * BBTreeWorkloadPolicy::Insert(key) registers a bucket that has become
+ * resident. Its score is computed when it is needed first.
+ */
+void BBTreeWorkloadPolicy::Insert(const uint64_t key) {
+  this->order.push_front(key);
+  this->positions[key] = this->order.begin();
+  if (key >= this->scores.size()) {
+    this->scores.resize(key + 1, 0.0);
+    this->scored_queries.resize(key + 1, std::numeric_limits<size_t>::max());
+    this->scored_versions.resize(key + 1, 0);
+  }
+  this->scored_queries[key] = std::numeric_limits<size_t>::max();
+}
+
+/**
+ * BBTreeWorkloadPolicy::Access(key) marks a resident bucket as most recently
+ * used.
+ */
+void BBTreeWorkloadPolicy::Access(const uint64_t key) {
+  this->order.splice(this->order.begin(), this->order, this->positions[key]);
+}
+
+/**
+ * BBTreeWorkloadPolicy::Remove(key) forgets a bucket.
+ */
+void BBTreeWorkloadPolicy::Remove(const uint64_t key) {
+  auto position = this->positions.find(key);
+  if (position == this->positions.end())
+    return;
+  this->order.erase(position->second);
+  this->positions.erase(position);
+}
+
+/**
+ * BBTreeWorkloadPolicy::Evict(is_evictable, victim) chooses the evictable
+ * bucket with the lowest score among those that the running range query
+ * does not read anymore. If there is none, it chooses the bucket that the
+ * running range query reads last. It returns false if no bucket is
+ * evictable.
+ */
+bool BBTreeWorkloadPolicy::Evict(const std::function<bool(uint64_t)> &is_evictable,
+                                 uint64_t &victim) {
+  const bool in_flight = !this->bbtree.pending_buckets.empty();
+  if (in_flight)
+    this->collectNextReads();
+  const size_t next_pending_bucket = this->bbtree.next_pending_bucket;
+
+  bool found = false;
+  bool found_pending = false;
+  double min_score = std::numeric_limits<double>::max();
+  size_t max_next_read = 0;
+  // traverse from the least recently used bucket, such that it wins ties
+  for (auto it = this->order.rbegin(); it != this->order.rend(); ++it) {
+    const uint64_t key = *it;
+    if (!is_evictable(key))
+      continue;
+    const size_t next_read = in_flight ? this->next_reads[key] :
+                                         std::numeric_limits<size_t>::max();
+    if (next_read == std::numeric_limits<size_t>::max() ||
+        next_read < next_pending_bucket) {
+      const double score = this->getScore(key);
+      if (!found || found_pending || score < min_score) {
+        victim = key;
+        min_score = score;
+        found_pending = false;
+      }
+      found = true;
+    } else if (!found || (found_pending && next_read > max_next_read)) {
+      victim = key;
+      max_next_read = next_read;
+      found = true;
+      found_pending = true;
+    }
+  }
+  if (found)
+    this->Remove(victim);
+  return found;
+}
+
+/**
+ * BBTreeWorkloadPolicy::GetName() returns the name of the policy.
+ */
+const char* BBTreeWorkloadPolicy::GetName() const {
+  return "Workload";
+}
+
+/**
+ * BBTreeWorkloadPolicy::getScore(bucket_id) returns the score of the given
+ * bucket. A score that has been computed before is decayed once per query
+ * monitored since and extended by the overlaps with these queries; queries
+ * older than the monitor window fade out geometrically. Scores of buckets
+ * whose zone maps may have changed since are computed anew.
+ */
+double BBTreeWorkloadPolicy::getScore(const size_t bucket_id) {
+  const size_t monitored = this->bbtree.num_monitored_queries;
+  const size_t num_queries = this->bbtree.last_lower_bounds.size();
+  if (this->scored_structure_version != this->bbtree.structure_version) {
+    // the bucket directory has been replaced
+    std::fill(this->scored_queries.begin(), this->scored_queries.end(),
+              std::numeric_limits<size_t>::max());
+    this->scored_structure_version = this->bbtree.structure_version;
+  }
+  size_t &scored = this->scored_queries[bucket_id];
+  double &score = this->scores[bucket_id];
+  const uint64_t version = (bucket_id < this->bbtree.num_buckets) ?
+                           this->bbtree.bucket_versions[bucket_id] : 0;
+  if (this->scored_versions[bucket_id] != version) {
+    // the zone map of the bucket may have changed
+    scored = std::numeric_limits<size_t>::max();
+    this->scored_versions[bucket_id] = version;
+  }
+  if (scored == monitored)
+    return score;
+
+  size_t new_queries = monitored - scored;
+  if (scored == std::numeric_limits<size_t>::max() ||
+      new_queries > num_queries) {
+    score = 0.0;
+    new_queries = num_queries;
+  }
+  // the most recent query precedes the oldest one in the ring buffer;
+  // the new queries are applied from the oldest to the most recent one
+  const size_t most_recent = (this->bbtree.monitor_position + num_queries - 1) %
+                             std::max(num_queries, (size_t) 1);
+  for (size_t i = new_queries; i-- > 0; ) {
+    const size_t query = (most_recent + num_queries - i) % num_queries;
+    score = score * this->decay + this->getOverlap(bucket_id, query);
+  }
+  scored = monitored;
+  return score;
+}
+
+/**
+ * BBTreeWorkloadPolicy::getOverlap(bucket_id, query) returns the fraction of
+ * the zone map of the given bucket that the given monitored query covers.
+ * Dimensions in which the zone map is a single value count as fully covered
+ * if the query contains the value.
+ */
+double BBTreeWorkloadPolicy::getOverlap(const size_t bucket_id,
+                                        const size_t query) const {
+  const BBTree &bbtree = this->bbtree;
+  if (bucket_id >= bbtree.num_buckets)
+    return 0.0;
+  const size_t dimensions = bbtree.dimensions;
+  const float* zone_map = bbtree.zone_maps + 2 * dimensions * bucket_id;
+  const std::vector<float> &lower_boundary = bbtree.last_lower_bounds[query];
+  const std::vector<float> &upper_boundary = bbtree.last_upper_bounds[query];
+  double overlap = 1.0;
+  for (size_t j = 0; j < dimensions; ++j) {
+    const float minimum = zone_map[j];
+    const float maximum = zone_map[dimensions + j];
+    const float lower = std::max(minimum, lower_boundary[j]);
+    const float upper = std::min(maximum, upper_boundary[j]);
+    if (lower > upper)
+      return 0.0;
+    if (maximum > minimum) {
+      // a query that only touches the zone map still reads the bucket
+      overlap *= std::max(((double) upper - lower) /
+                          ((double) maximum - minimum), 1e-3);
+    }
+  }
+  return overlap;
+}
+
+/**
+ * BBTreeWorkloadPolicy::collectNextReads() records at which position the
+ * running range query reads each of its buckets, once per range query.
+ */
+void BBTreeWorkloadPolicy::collectNextReads() {
+  const size_t query = this->bbtree.pending_queries;
+  if (this->next_reads_query == query)
+    return;
+  const std::vector<size_t> &pending_buckets = this->bbtree.pending_buckets;
+  this->next_reads.assign(this->bbtree.num_buckets,
+                          std::numeric_limits<size_t>::max());
+  for (size_t i = pending_buckets.size(); i-- > 0; )
+    this->next_reads[pending_buckets[i]] = i;
+  this->next_reads_query = query;
+}
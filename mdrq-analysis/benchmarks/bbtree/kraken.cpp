@@ -11,6 +11,7 @@ void insert(KrakenIndex* index, std::vector<float> point) {
 
 void load_partitions(KrakenIndex* index) {
   index->bb_trees = new BBTree*[index->dop];
+  index->contexts = new BBTreeQueryContext[index->dop];
   for (size_t i = 0; i < index->dop; ++i)
     index->bb_trees[i] = new BBTree(index->dim);
 
@@ -29,47 +30,42 @@ std::vector<uint32_t> intersect(std::vector<uint32_t> first, std::vector<uint32_
   return intersection;
 }
 
-inline void scan_partition_bbtree(int id, BBTree* bbtree, std::vector<uint32_t> &results, std::vector<float> lower, std::vector<float> upper) {
-  std::vector<uint32_t> tmp_results = bbtree->SearchRange(lower, upper);
-  results.resize(tmp_results.size());
-  results = tmp_results;
+inline void scan_partition_bbtree(int id, BBTree* bbtree, BBTreeQueryContext &context, const std::vector<float> &lower, const std::vector<float> &upper) {
+  bbtree->SearchRange(lower, upper, context);
 }
 
-inline void scan_partition_bbtree_simd(int id, BBTree* bbtree, std::vector<uint32_t> &results, std::vector<float> lower, std::vector<float> upper) {
-  std::vector<uint32_t> tmp_results = bbtree->SearchRangeMT(lower, upper);
-  results.resize(tmp_results.size());
-  results = tmp_results;
+inline void scan_partition_bbtree_simd(int id, BBTree* bbtree, BBTreeQueryContext &context, const std::vector<float> &lower, const std::vector<float> &upper) {
+  bbtree->SearchRangeMT(lower, upper, context);
 }
 
-std::vector<uint32_t> partitioned_range_bbtree(KrakenIndex* index, ctpl::thread_pool *pool, std::vector<float> lower, std::vector<float> upper) {
+std::vector<uint32_t> partitioned_range_bbtree(KrakenIndex* index, ctpl::thread_pool *pool, const std::vector<float> &lower, const std::vector<float> &upper) {
   std::vector<uint32_t> results;
-  std::vector<std::vector<uint32_t>> intermediate_results(index->dop, std::vector<uint32_t>());
   std::future<void> *futures = new std::future<void>[index->dop];
 
   for (uint32_t i = 0; i < index->dop; i++)
-    futures[i] = pool->push(std::ref(scan_partition_bbtree), index->bb_trees[i], std::ref(intermediate_results[i]), lower, upper);
+    futures[i] = pool->push(std::ref(scan_partition_bbtree), index->bb_trees[i], std::ref(index->contexts[i]), std::ref(lower), std::ref(upper));
 
   for (uint32_t i = 0; i < index->dop; i++) {
     futures[i].get();
-    results.insert(std::end(results), std::begin(intermediate_results[i]), std::end(intermediate_results[i]));
+    const std::vector<uint32_t> &partition_results = index->contexts[i].GetResults();
+    results.insert(std::end(results), std::begin(partition_results), std::end(partition_results));
   }
   delete [] futures;
 
   return results;
 }
 
-std::vector<uint32_t> partitioned_range_bbtree_simd(KrakenIndex* index, ctpl::thread_pool *pool, std::vector<float> lower, std::vector<float> upper) {
+std::vector<uint32_t> partitioned_range_bbtree_simd(KrakenIndex* index, ctpl::thread_pool *pool, const std::vector<float> &lower, const std::vector<float> &upper) {
   std::vector<uint32_t> results;
-  std::vector<std::vector<uint32_t>> intermediate_results(index->dop, std::vector<uint32_t>());
   std::future<void> *futures = new std::future<void>[index->dop];
-  int partitions_visited = 0;
 
   for (uint32_t i = 0; i < index->dop; i++)
-    futures[i] = pool->push(std::ref(scan_partition_bbtree_simd), index->bb_trees[i], std::ref(intermediate_results[i]), lower, upper);
+    futures[i] = pool->push(std::ref(scan_partition_bbtree_simd), index->bb_trees[i], std::ref(index->contexts[i]), std::ref(lower), std::ref(upper));
 
   for (uint32_t i = 0; i < index->dop; i++) {
     futures[i].get();
-    results.insert(std::end(results), std::begin(intermediate_results[i]), std::end(intermediate_results[i]));
+    const std::vector<uint32_t> &partition_results = index->contexts[i].GetResults();
+    results.insert(std::end(results), std::begin(partition_results), std::end(partition_results));
   }
   delete [] futures;
 
@@ -16,13 +16,15 @@
 #include "ctpl_stl.h"
 
 struct KrakenIndex {
-  KrakenIndex(uint32_t c, uint32_t d, uint32_t dopp) : count(c), dim(d), dop(dopp) {
+  KrakenIndex(uint32_t c, uint32_t d, uint32_t dopp) : count(c), dim(d), dop(dopp),
+    bb_trees(NULL), contexts(NULL) {
 //    this->dop = std::thread::hardware_concurrency();
     this->partitions = new std::vector<std::vector<float>>[this->dop];
   }
 
   ~KrakenIndex() {
     delete [] bb_trees;
+    delete [] contexts;
     delete [] this->partitions;
   }
 
@@ -32,6 +34,8 @@ struct KrakenIndex {
 
   // bb tree
   BBTree** bb_trees;
+  // reused result buffers of the partitions
+  BBTreeQueryContext* contexts;
   std::vector<std::vector<float> >* bbtree_points;
   std::vector<std::vector<float> >* partitions;
 };
@@ -40,6 +44,6 @@ KrakenIndex* create_kraken(uint8_t dim, uint32_t dop);
 void insert(KrakenIndex* index, std::vector<float> point);
 void load_partitions(KrakenIndex* index);
 void load_bbtrees(KrakenIndex* index, std::vector<std::vector<float> > bbtree_points);
-std::vector<uint32_t> partitioned_range_bbtree(KrakenIndex* index, ctpl::thread_pool *pool, std::vector<float> lower, std::vector<float> upper);
-std::vector<uint32_t> partitioned_range_bbtree_simd(KrakenIndex* index, ctpl::thread_pool *pool, std::vector<float> lower, std::vector<float> upper);
+std::vector<uint32_t> partitioned_range_bbtree(KrakenIndex* index, ctpl::thread_pool *pool, const std::vector<float> &lower, const std::vector<float> &upper);
+std::vector<uint32_t> partitioned_range_bbtree_simd(KrakenIndex* index, ctpl::thread_pool *pool, const std::vector<float> &lower, const std::vector<float> &upper);
 #endif
@@ -10,6 +10,7 @@
 #include <limits>
 #include <random>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #include "BBTree.h"
@@ -54,6 +55,54 @@ static double getstddev(double* runtimes, size_t n) {
   return std_dev;
 }
 
+// does nothing with the result of a measured operation (see measure())
+struct NoCheck {
+  template <typename Result>
+  void operator()(size_t, const Result &) const {}
+};
+
+/**
+ * Executes run(i) for i = 0, ..., n-1 and measures the runtime of every
+ * execution (in seconds multiplied by scale, e.g., 1000 for milliseconds).
+ * After every execution, check(i, result) verifies its result without being
+ * measured. Prints the mean and the standard deviation of the runtimes and
+ * returns the mean.
+ *
+ * Example:
+ * measure(rq, 1000,
+ *   [&](size_t i) { return bbtree->CountRange(lb_queries[i], ub_queries[i]); },
+ *   [&](size_t i, size_t count) { assert(count == ...); });
+ */
+template <typename Run, typename Check>
+static double measure(const size_t n, const double scale, Run run,
+                      Check check) {
+  std::vector<double> runtimes(n);
+  for (size_t i = 0; i < n; ++i) {
+    const double start = gettime();
+    const auto result = run(i);
+    runtimes[i] = (gettime() - start) * scale;
+    check(i, result);
+  }
+  const double avg = getaverage(runtimes.data(), n);
+  std::cout << "Mean: " << avg << " Standard Deviation: " <<
+               getstddev(runtimes.data(), n) << std::endl;
+
+  return avg;
+}
+
+// measure(n, scale, run) is the same as above without checking the results.
+template <typename Run>
+static double measure(const size_t n, const double scale, Run run) {
+  return measure(n, scale, run, NoCheck());
+}
+
+// sorts the tids of a query result, such that results that were collected in
+// a different order can be compared.
+static std::vector<uint32_t> sorted(std::vector<uint32_t> tids) {
+  std::sort(tids.begin(), tids.end());
+  return tids;
+}
+
 int main(int argc, char* argv[]) {
   if (argc < 4) {
     std::cout << "Usage: " << argv[0] << " num_elements num_dimensions distribution(0=normal, 1=clustered, 2=uniform, 3=gmrqb, 4=power)" << std::endl;
@@ -154,30 +203,62 @@ int main(int argc, char* argv[]) {
   std::random_shuffle(bbtree_points.begin(), bbtree_points.end());
 
   double start = gettime();
-  double *runtimes;
   BBTree* bbtree = new BBTree(m);
+  // BBTREE_AUTOTUNE=1 calibrates bucket sizes and fanout for this machine
+  if (getenv("BBTREE_AUTOTUNE") != NULL)
+    bbtree->SetAutoTuning(true);
+  // BBTREE_PREFETCH=<n> prefetches n buckets ahead in range scans
+  // (0 = adaptive to the bucket size)
+  if (getenv("BBTREE_PREFETCH") != NULL)
+    bbtree->SetPrefetchDistance(atoi(getenv("BBTREE_PREFETCH")));
+  // BBTREE_HASH_INDEX=1 maintains per-bucket hash indexes for point queries
+  if (getenv("BBTREE_HASH_INDEX") != NULL)
+    bbtree->SetHashIndex(true);
+  // BBTREE_BLOOM_FILTER=1 maintains per-bucket Bloom filters for point queries
+  if (getenv("BBTREE_BLOOM_FILTER") != NULL)
+    bbtree->SetBloomFilter(true);
+  // BBTREE_TID_DIRECTORY=1 maintains the tid directory and deletes by tid
+  const bool delete_by_tid = (getenv("BBTREE_TID_DIRECTORY") != NULL);
+  bbtree->SetTidDirectory(delete_by_tid);
+  // BBTREE_TRACE=<file> appends the bucket accesses to a trace for
+  // tools/simulator
+  if (getenv("BBTREE_TRACE") != NULL)
+    bbtree->SetTrace(getenv("BBTREE_TRACE"));
 
   std::cout << "BB-Tree [inserts]" << std::endl;
-  runtimes = new double[n];
-  for (size_t i = 0; i < n; ++i) {
-    start = gettime();
-    bbtree->InsertObject(bbtree_points[i], (uint32_t) (i+1));
-    runtimes[i] = (gettime() - start) * 1000000;
-  }
-  std::cout << "Mean: " << getaverage(runtimes, n) << " Standard Deviation: " <<
-               getstddev(runtimes, n) << std::endl;
-  delete runtimes;
+  measure(n, 1000000,
+    [&](size_t i) {
+      bbtree->InsertObject(bbtree_points[i], (uint32_t) (i+1));
+      return bbtree->getCount();
+    },
+    [&](size_t i, size_t count) { assert(i+1 == count); });
+  BBTreeTuning tuning = bbtree->getTuning();
+  std::cout << "Bucket Size (avg/max): " << tuning.bucket_avg << "/" <<
+               tuning.bucket_max << " Fanout: " <<
+               (tuning.delimiters_per_split + 1) << std::endl;
 
   std::cout << "BB-Tree [point queries]" << std::endl;
-  runtimes = new double[n];
-  for (size_t i = 0; i < n; ++i) {
-    start = gettime();
-    assert((i+1) == bbtree->SearchObject(bbtree_points[i]));
-    runtimes[i] = (gettime() - start) * 1000000;
-  }
-  std::cout << "Mean: " << getaverage(runtimes, n) << " Standard Deviation: " <<
-               getstddev(runtimes, n) << std::endl;
-  delete runtimes;
+  measure(n, 1000000,
+    [&](size_t i) { return bbtree->SearchObject(bbtree_points[i]); },
+    [&](size_t i, uint32_t tid) { assert((i+1) == tid); });
+
+  // batches of 1024 point queries; runtimes are reported per point query
+  // (the data objects of the last, partial batch are not queried)
+  std::cout << "BB-Tree [point queries/batched]" << std::endl;
+  const size_t batch_size = 1024;
+  std::vector<std::vector<float> > batch(batch_size, std::vector<float>(m));
+  std::vector<uint32_t> batch_results;
+  measure(n / batch_size, 1000000.0 / batch_size,
+    [&](size_t b) {
+      std::copy(bbtree_points.begin() + b * batch_size, bbtree_points.begin() + (b + 1) * batch_size, batch.begin());
+      bbtree->SearchObjectBatch(batch, batch_results);
+      return batch_results.size();
+    },
+    [&](size_t b, size_t num_results) {
+      assert(num_results == batch_size);
+      for (size_t i = 0; i < batch_size; ++i)
+        assert(b * batch_size + i + 1 == batch_results[i]);
+    });
 
   int avg_result_size = 0;
   size_t repeat = 1;
@@ -230,45 +311,447 @@ int main(int argc, char* argv[]) {
   }
 
   std::cout << "BB-Tree [range queries]" << std::endl;
-  runtimes = new double[rq];
-  for (size_t i = 0; i < rq; ++i) {
-    start = gettime();
-    std::vector<uint32_t> results =  bbtree->SearchRange(lb_queries[i], ub_queries[i]);
-    runtimes[i] = (gettime() - start) * 1000;
-  }
-  std::cout << "Mean: " << getaverage(runtimes, rq) << " Standard Deviation: " <<
-               getstddev(runtimes, rq) << std::endl;
-  delete runtimes;
+  measure(rq, 1000,
+    [&](size_t i) { return bbtree->SearchRange(lb_queries[i], ub_queries[i]); });
 
   std::cout << "BB-Tree [range queries/multithreaded]" << std::endl;
-  runtimes = new double[rq];
   avg_result_size = 0;
-  for (size_t i = 0; i < rq; ++i) {
+  double avg = measure(rq, 1000,
+    [&](size_t i) { return bbtree->SearchRangeMT(lb_queries[i], ub_queries[i]); },
+    [&](size_t i, const std::vector<uint32_t> &results) { avg_result_size += results.size(); });
+
+  printf("MDRQ Throughput (multi-threaded/Vertical Partitioning/SIMD): %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) rq));
+
+  // only the number of matches is computed
+  std::cout << "BB-Tree [range queries/count]" << std::endl;
+  avg_result_size = 0;
+  avg = measure(rq, 1000,
+    [&](size_t i) { return bbtree->CountRange(lb_queries[i], ub_queries[i]); },
+    [&](size_t i, size_t num_results) { avg_result_size += num_results; });
+
+  printf("MDRQ Throughput (count): %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) rq));
+
+  std::cout << "BB-Tree [range queries/limit 100]" << std::endl;
+  avg_result_size = 0;
+  avg = measure(rq, 1000,
+    [&](size_t i) { return bbtree->SearchRangeLimit(lb_queries[i], ub_queries[i], 100); },
+    [&](size_t i, const std::vector<uint32_t> &results) { avg_result_size += results.size(); });
+
+  printf("MDRQ Throughput (limit 100): %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) rq));
+
+  std::cout << "BB-Tree [range queries/top 10 by dimension 0]" << std::endl;
+  avg_result_size = 0;
+  avg = measure(rq, 1000,
+    [&](size_t i) { return bbtree->SearchRangeTopK(lb_queries[i], ub_queries[i], 0, 10); },
+    [&](size_t i, const std::vector<uint32_t> &results) { avg_result_size += results.size(); });
+
+  printf("MDRQ Throughput (top 10): %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) rq));
+
+  // the lower boundaries of the range queries serve as query objects
+  std::cout << "BB-Tree [10-NN queries]" << std::endl;
+  avg = measure(rq, 1000,
+    [&](size_t i) { return bbtree->SearchKNN(lb_queries[i], 10, BBTREE_METRIC_L2); });
+
+  printf("10-NN Throughput: %f ops/s.\n", (float) (1000 / avg));
+
+  // the distances of the neighbors of some queries have to match a full scan
+  for (size_t i = 0; i < std::min((size_t) rq, (size_t) 5); ++i) {
+    std::vector<double> distances(n);
+    for (size_t d = 0; d < n; ++d) {
+      distances[d] = 0.0;
+      for (size_t j = 0; j < m; ++j) {
+        const double difference = (double) bbtree_points[d][j] - lb_queries[i][j];
+        distances[d] += difference * difference;
+      }
+    }
+    const size_t k = std::min(n, (size_t) 10);
+    std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+    for (size_t mt = 0; mt < 2; ++mt) {
+      std::vector<uint32_t> results = (mt == 0) ? bbtree->SearchKNN(lb_queries[i], 10, BBTREE_METRIC_L2) : bbtree->SearchKNNMT(lb_queries[i], 10, BBTREE_METRIC_L2);
+      assert(results.size() == k);
+      for (size_t r = 0; r < k; ++r) {
+        double distance = 0.0;
+        for (size_t j = 0; j < m; ++j) {
+          const double difference = (double) bbtree_points[results[r] - 1][j] - lb_queries[i][j];
+          distance += difference * difference;
+        }
+        assert(std::abs(distance - distances[r]) <= 1e-5 * (1.0 + distances[r]));
+      }
+    }
+  }
+
+  std::cout << "BB-Tree [10-NN queries/multithreaded]" << std::endl;
+  avg = measure(rq, 1000,
+    [&](size_t i) { return bbtree->SearchKNNMT(lb_queries[i], 10, BBTREE_METRIC_L2); });
+
+  printf("10-NN Throughput (multi-threaded): %f ops/s.\n", (float) (1000 / avg));
+
+  std::cout << "BB-Tree [fixed-radius queries/multithreaded]" << std::endl;
+  avg_result_size = 0;
+  avg = measure(rq, 1000,
+    [&](size_t i) { return bbtree->SearchFixedRadiusNNMT(lb_queries[i], 0.25, BBTREE_METRIC_L2); },
+    [&](size_t i, const std::vector<uint32_t> &results) { avg_result_size += results.size(); });
+
+  printf("Fixed-radius Throughput (multi-threaded): %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) rq));
+
+  // batches of 10 range queries share one traversal and one scan per bucket
+  std::cout << "BB-Tree [range queries/batches of 10]" << std::endl;
+  const size_t query_batch_size = 10;
+  const size_t num_query_batches = rq / query_batch_size;
+  std::vector<std::vector<float> > lower(query_batch_size, std::vector<float>(m));
+  std::vector<std::vector<float> > upper(query_batch_size, std::vector<float>(m));
+  avg_result_size = 0;
+  avg = measure(num_query_batches, 1000.0 / query_batch_size,
+    [&](size_t i) {
+      std::copy(lb_queries.begin() + i * query_batch_size, lb_queries.begin() + (i + 1) * query_batch_size, lower.begin());
+      std::copy(ub_queries.begin() + i * query_batch_size, ub_queries.begin() + (i + 1) * query_batch_size, upper.begin());
+      return bbtree->SearchRanges(lower, upper);
+    },
+    [&](size_t i, const std::vector<std::vector<uint32_t> > &results) {
+      for (size_t j = 0; j < query_batch_size; ++j)
+        avg_result_size += results[j].size();
+    });
+
+  printf("Batched Range Query Throughput: %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) (num_query_batches * query_batch_size)));
+
+  // concurrent clients whose range queries are batched into shared scans
+  std::cout << "BB-Tree [range queries/8 clients/shared scans]" << std::endl;
+  {
+    const size_t num_clients = 8;
+    BBTreeBatchExecutor executor(*bbtree);
+    std::vector<std::thread> clients;
     start = gettime();
-    std::vector<uint32_t> results =  bbtree->SearchRangeMT(lb_queries[i], ub_queries[i]);
-    runtimes[i] = (gettime() - start) * 1000;
-    avg_result_size += results.size();
+    for (size_t c = 0; c < num_clients; ++c) {
+      clients.push_back(std::thread([&, c]() {
+        for (size_t i = c; i < rq; i += num_clients)
+          executor.SearchRange(lb_queries[i], ub_queries[i]);
+      }));
+    }
+    for (size_t c = 0; c < num_clients; ++c)
+      clients[c].join();
+    avg = (gettime() - start) * 1000 / rq;
+    std::cout << "Mean: " << avg << std::endl;
+
+    printf("Shared Scan Throughput (8 clients): %f ops/s [avg batch size: %f].\n", (float) (1000 / avg), (float) (rq / (float) executor.GetNumberOfBatches()));
   }
-  double avg = getaverage(runtimes, rq);
-  std::cout << "Mean: " << avg << " Standard Deviation: " << getstddev(runtimes, rq) << std::endl;
-  
-  printf("MDRQ Throughput (multi-threaded/Vertical Partitioning/SIMD): %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) rq));
 
-  delete runtimes;
+  // joins of all range queries at once and of the lower query corners
+  std::cout << "BB-Tree [box join/multithreaded]" << std::endl;
+  start = gettime();
+  std::vector<std::pair<uint32_t, uint32_t> > join_results = bbtree->JoinBoxesMT(lb_queries, ub_queries);
+  avg = (gettime() - start) * 1000;
+  std::cout << "Runtime: " << avg << std::endl;
 
-  std::cout << "BB-Tree [deletes]" << std::endl;
-  runtimes = new double[n];
-  for (size_t i = 0; i < n; ++i) {
-    std::vector<float> object_to_delete = bbtree_points[i];
-    assert((i+1) == bbtree->SearchObject(object_to_delete));
-    size_t old_count = bbtree->getCount();
+  printf("Box Join Throughput (multi-threaded): %f boxes/s [pairs: %zu].\n", (float) (1000 * rq / avg), join_results.size());
+
+  std::cout << "BB-Tree [epsilon-distance join/multithreaded]" << std::endl;
+  {
+    BBTree* probe = new BBTree(m);
+    for (size_t i = 0; i < rq; ++i)
+      probe->InsertObject(lb_queries[i], i);
     start = gettime();
-    assert(true == bbtree->DeleteObject(object_to_delete));
-    runtimes[i] = (gettime() - start) * 1000000;
-    assert(old_count-1 == bbtree->getCount());
+    join_results = bbtree->JoinDistanceMT(*probe, 0.05, BBTREE_METRIC_L2);
+    avg = (gettime() - start) * 1000;
+    std::cout << "Runtime: " << avg << std::endl;
+
+    printf("Distance Join Throughput (multi-threaded): %f probes/s [pairs: %zu].\n", (float) (1000 * rq / avg), join_results.size());
+    delete probe;
+  }
+
+  // estimates are compared against the actual result sizes (q-error)
+  std::cout << "BB-Tree [range estimates]" << std::endl;
+  std::vector<double> q_errors(rq);
+  double estimated_rows = 0;
+  avg_result_size = 0;
+  avg = measure(rq, 1000000,
+    [&](size_t i) { return bbtree->EstimateRange(lb_queries[i], ub_queries[i]); },
+    [&](size_t i, const BBTreeEstimate &estimate) {
+      const double actual = bbtree->CountRange(lb_queries[i], ub_queries[i]);
+      q_errors[i] = std::max(estimate.rows + 1, actual + 1) / std::min(estimate.rows + 1, actual + 1);
+      estimated_rows += estimate.rows;
+      avg_result_size += actual;
+    });
+  std::sort(q_errors.begin(), q_errors.end());
+
+  printf("Estimate Latency: %f us [avg estimate: %f, avg result size: %f].\n", (float) avg, (float) (estimated_rows / rq), (float) (avg_result_size / (float) rq));
+  printf("Estimate Q-error: mean %f, median %f, 95th %f, max %f.\n", (float) getaverage(q_errors.data(), rq), (float) q_errors[rq / 2], (float) q_errors[rq * 95 / 100], (float) q_errors[rq - 1]);
+
+  // the hybrid index learns when a column scan beats the BB-Tree
+  {
+    BBTreeHybridIndex hybrid(*bbtree);
+    hybrid.SetColumnStore(true);
+
+    std::cout << "BB-Tree [range queries/column scan]" << std::endl;
+    avg = measure(rq, 1000,
+      [&](size_t i) { return hybrid.SearchRangeScan(lb_queries[i], ub_queries[i]); });
+
+    printf("Column Scan Throughput (multi-threaded): %f ops/s.\n", (float) (1000 / avg));
+
+    std::cout << "BB-Tree [range queries/hybrid]" << std::endl;
+    size_t num_scans = 0;
+    avg = measure(rq, 1000,
+      [&](size_t i) { return hybrid.SearchRange(lb_queries[i], ub_queries[i]); },
+      [&](size_t i, const std::vector<uint32_t> &results) {
+        if (hybrid.GetLastAccessPath() == BBTREE_ACCESS_SCAN)
+          num_scans++;
+      });
+
+    printf("Hybrid Throughput: %f ops/s [scans: %zu, crossover: %f].\n", (float) (1000 / avg), num_scans, (float) hybrid.GetCrossover());
+  }
+
+  // repeated range queries (skewed towards the first ones) are answered
+  // from result caches with a budget that only fits a part of the results
+  {
+    const BBTreeCachePolicy policies[3] = {BBTREE_CACHE_LRU, BBTREE_CACHE_LFU, BBTREE_CACHE_GREEDY_DUAL};
+    const char* policy_names[3] = {"lru", "lfu", "greedy-dual"};
+    const size_t num_cached_queries = 4 * rq;
+    std::vector<size_t> cached_queries(num_cached_queries);
+    for (size_t p = 0; p < 3; ++p) {
+      BBTreeResultCache cache(*bbtree, policies[p], RESULT_CACHE_BUDGET / 16);
+      std::cout << "BB-Tree [range queries/result cache/" << policy_names[p] << "]" << std::endl;
+      for (size_t i = 0; i < num_cached_queries; ++i)
+        cached_queries[i] = rand() % (1 + rand() % rq);
+      avg = measure(num_cached_queries, 1000,
+        [&](size_t i) {
+          const size_t q = cached_queries[i];
+          return cache.SearchRangeMT(lb_queries[q], ub_queries[q]);
+        });
+
+      printf("Result Cache Throughput (%s): %f ops/s [hit ratio: %f, bytes: %zu].\n", policy_names[p], (float) (1000 / avg), (float) cache.GetHits() / num_cached_queries, cache.GetSizeInBytes());
+    }
+  }
+
+  // every range query is refined by narrowing it three times and by shifting
+  // it in one dimension, as in an interactive analysis session
+  {
+    BBTreeSemanticCache semantic_cache(*bbtree);
+    const size_t num_refined_queries = 5 * rq;
+    std::vector<std::vector<float> > lower_boundaries(num_refined_queries);
+    std::vector<std::vector<float> > upper_boundaries(num_refined_queries);
+    for (size_t i = 0; i < num_refined_queries; ++i) {
+      const size_t q = i / 5;
+      const size_t step = i % 5;
+      lower_boundaries[i] = lb_queries[q];
+      upper_boundaries[i] = ub_queries[q];
+      for (size_t j = 0; j < m; ++j) {
+        const float width = ub_queries[q][j] - lb_queries[q][j];
+        if (step == 4) {
+          if (j == q % m) {
+            lower_boundaries[i][j] += 0.25f * width;
+            upper_boundaries[i][j] += 0.25f * width;
+          }
+        } else {
+          lower_boundaries[i][j] += 0.1f * step * width;
+          upper_boundaries[i][j] -= 0.1f * step * width;
+        }
+      }
+    }
+    std::cout << "BB-Tree [range queries/semantic cache]" << std::endl;
+    avg = measure(num_refined_queries, 1000,
+      [&](size_t i) { return semantic_cache.SearchRangeMT(lower_boundaries[i], upper_boundaries[i]); });
+
+    printf("Semantic Cache Throughput: %f ops/s [hit ratio: %f, partial hit ratio: %f].\n", (float) (1000 / avg), (float) semantic_cache.GetHits() / num_refined_queries, (float) semantic_cache.GetPartialHits() / num_refined_queries);
+  }
+
+  // the buckets are moved into a file, of which only a few are kept
+  // resident, and the skewed range queries are repeated per replacement policy
+  {
+    const BBTreeReplacement replacements[6] = {BBTREE_REPLACEMENT_LRU, BBTREE_REPLACEMENT_LFU, BBTREE_REPLACEMENT_CLOCK, BBTREE_REPLACEMENT_2Q, BBTREE_REPLACEMENT_ARC, BBTREE_REPLACEMENT_LIRS};
+    const size_t num_frames = 64;
+    const size_t num_pool_queries = 4 * rq;
+    std::vector<size_t> pool_queries(num_pool_queries);
+    // split the data objects into buckets of the average size, such that
+    // only a part of them fits into the frames
+    bbtree->RebuildDelimiters();
+    // in-memory results of the range queries, which the pooled ones have to
+    // match
+    std::vector<std::vector<uint32_t> > pool_references(rq);
+    for (size_t i = 0; i < (size_t) rq; ++i)
+      pool_references[i] = sorted(bbtree->SearchRange(lb_queries[i], ub_queries[i]));
+    // the tid directory cannot be maintained while a buffer pool is set
+    bbtree->SetTidDirectory(false);
+    for (size_t p = 0; p < 6; ++p) {
+      bbtree->SetBufferPool("bbtree_buffer_pool.dat", num_frames, replacements[p]);
+      const char* policy_name = bbtree->GetBufferPool()->GetPolicyName();
+      std::cout << "BB-Tree [range queries/buffer pool/" << policy_name << "]" << std::endl;
+      for (size_t i = 0; i < num_pool_queries; ++i)
+        pool_queries[i] = rand() % (1 + rand() % rq);
+      avg = measure(num_pool_queries, 1000,
+        [&](size_t i) {
+          const size_t q = pool_queries[i];
+          return bbtree->SearchRange(lb_queries[q], ub_queries[q]);
+        },
+        [&](size_t i, const std::vector<uint32_t> &results) {
+          assert(sorted(results) == pool_references[pool_queries[i]]);
+        });
+
+      const BBTreeBufferPool* buffer_pool = bbtree->GetBufferPool();
+      printf("Buffer Pool Throughput (%s): %f ops/s [hits: %zu, misses: %zu, pages read: %zu].\n", policy_name, (float) (1000 / avg), buffer_pool->GetHits(), buffer_pool->GetMisses(), buffer_pool->GetPagesRead());
+    }
+
+    // copies of the first data objects are inserted into the pooled buckets
+    // under new tids, which are then split anew
+    std::cout << "BB-Tree [inserts/buffer pool]" << std::endl;
+    const size_t num_pool_inserts = n / 10;
+    avg = measure(num_pool_inserts, 1000000,
+      [&](size_t i) {
+        bbtree->InsertObject(bbtree_points[i], (uint32_t) (n+i+1));
+        return bbtree->getCount();
+      },
+      [&](size_t i, size_t count) { assert(n+i+1 == count); });
+    bbtree->RebuildDelimiters();
+    for (size_t i = 0; i < (size_t) rq; ++i) {
+      std::vector<uint32_t> expected(pool_references[i]);
+      for (size_t r = 0; r < pool_references[i].size(); ++r)
+        if (pool_references[i][r] <= num_pool_inserts)
+          expected.push_back(n + pool_references[i][r]);
+      assert(sorted(bbtree->SearchRange(lb_queries[i], ub_queries[i])) == sorted(expected));
+    }
+
+    const BBTreeBufferPool* buffer_pool = bbtree->GetBufferPool();
+    printf("Buffer Pool Insert Throughput: %f ops/s [pages read: %zu, pages written: %zu].\n", (float) (1000000 / avg), buffer_pool->GetPagesRead(), buffer_pool->GetPagesWritten());
+    bbtree->DisableBufferPool();
+
+    // the copies are deleted by their tids
+    bbtree->SetTidDirectory(true);
+    for (size_t i = 0; i < num_pool_inserts; ++i)
+      assert(bbtree->DeleteByTid(n+i+1));
+    bbtree->SetTidDirectory(false);
+    assert(n == bbtree->getCount());
+    for (size_t i = 0; i < (size_t) rq; ++i)
+      assert(sorted(bbtree->SearchRange(lb_queries[i], ub_queries[i])) == pool_references[i]);
   }
-  std::cout << "Mean: " << getaverage(runtimes, n) << " Standard Deviation: " << getstddev(runtimes, n) << std::endl << std::endl;
-  delete runtimes;
+
+  // mixed workload of recurring queries on hot regions and one-off queries:
+  // LRU against the replacement policy that follows the query monitor; the
+  // queries of a gmrqb file (e.g., ../../gmrqb-mixed.queries), which mixes the
+  // query types of the benchmark, are replayed in their order instead
+  {
+    const size_t num_frames = 64;
+    const size_t num_mixed_queries = 4 * rq;
+    std::vector<size_t> mixed_queries(num_mixed_queries);
+    for (size_t i = 0; i < num_mixed_queries; ++i) {
+      if (atoi(argv[3]) == 3)
+        mixed_queries[i] = i % rq;
+      else
+        mixed_queries[i] = (rand() % 3 != 0) ? rand() % (1 + rq / 10) : rand() % rq;
+    }
+    // in-memory results of the range queries, which the pooled ones have to
+    // match
+    std::vector<std::vector<uint32_t> > mixed_references(rq);
+    for (size_t i = 0; i < (size_t) rq; ++i)
+      mixed_references[i] = sorted(bbtree->SearchRange(lb_queries[i], ub_queries[i]));
+    size_t misses[2];
+    for (size_t p = 0; p < 2; ++p) {
+      if (p == 0)
+        bbtree->SetBufferPool("bbtree_buffer_pool.dat", num_frames, BBTREE_REPLACEMENT_LRU);
+      else
+        bbtree->SetBufferPool("bbtree_buffer_pool.dat", num_frames, new BBTreeWorkloadPolicy(*bbtree));
+      const char* policy_name = bbtree->GetBufferPool()->GetPolicyName();
+      std::cout << "BB-Tree [range queries/buffer pool/mixed/" << policy_name << "]" << std::endl;
+      avg = measure(num_mixed_queries, 1000,
+        [&](size_t i) {
+          const size_t q = mixed_queries[i];
+          return bbtree->SearchRange(lb_queries[q], ub_queries[q]);
+        },
+        [&](size_t i, const std::vector<uint32_t> &results) {
+          assert(sorted(results) == mixed_references[mixed_queries[i]]);
+        });
+
+      const BBTreeBufferPool* buffer_pool = bbtree->GetBufferPool();
+      misses[p] = buffer_pool->GetMisses();
+      printf("Buffer Pool Throughput (mixed, %s): %f ops/s [hits: %zu, misses: %zu, pages read: %zu].\n", policy_name, (float) (1000 / avg), buffer_pool->GetHits(), buffer_pool->GetMisses(), buffer_pool->GetPagesRead());
+    }
+    printf("Buffer Pool Miss Reduction (mixed, vs. LRU): %f%%.\n", (float) (misses[0] == 0 ? 0.0 : 100.0 * ((double) misses[0] - misses[1]) / misses[0]));
+    bbtree->DisableBufferPool();
+    bbtree->SetTidDirectory(delete_by_tid);
+  }
+
+  // results are written into the reused buffers of a query context
+  std::cout << "BB-Tree [range queries/multithreaded/context]" << std::endl;
+  BBTreeQueryContext context;
+  avg_result_size = 0;
+  avg = measure(rq, 1000,
+    [&](size_t i) {
+      bbtree->SearchRangeMT(lb_queries[i], ub_queries[i], context);
+      return context.GetResults().size();
+    },
+    [&](size_t i, size_t num_results) { avg_result_size += num_results; });
+
+  printf("MDRQ Throughput (multi-threaded/context): %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) rq));
+
+  // results are kept as selection bitmaps and only counted
+  std::cout << "BB-Tree [range queries/multithreaded/bitmap]" << std::endl;
+  BBTreeSelection selection;
+  avg_result_size = 0;
+  avg = measure(rq, 1000,
+    [&](size_t i) {
+      bbtree->SearchRangeMT(lb_queries[i], ub_queries[i], selection);
+      return selection.Count();
+    },
+    [&](size_t i, size_t num_results) { avg_result_size += num_results; });
+
+  printf("MDRQ Throughput (multi-threaded/bitmap): %f ops/s [avg result size: %f].\n", (float) (1000 / avg), (float) (avg_result_size / (float) rq));
+
+  // results are consumed bucket by bucket while the query is running
+  std::cout << "BB-Tree [range queries/multithreaded/streamed]" << std::endl;
+  std::vector<double> first_batch_runtimes(rq);
+  measure(rq, 1000,
+    [&](size_t i) {
+      size_t num_results = 0;
+      const double stream_start = gettime();
+      first_batch_runtimes[i] = 0;
+      bbtree->SearchRangeStreamMT(lb_queries[i], ub_queries[i],
+        [&](const BBTreeResultBatch &batch) {
+          if (num_results == 0)
+            first_batch_runtimes[i] = (gettime() - stream_start) * 1000;
+          num_results += batch.tids.size();
+          return true;
+        }, false);
+      return num_results;
+    },
+    [&](size_t i, size_t num_results) {
+      assert(num_results == bbtree->SearchRange(lb_queries[i], ub_queries[i]).size());
+    });
+  std::cout << "First batch: Mean: " << getaverage(first_batch_runtimes.data(), rq) <<
+               " Standard Deviation: " << getstddev(first_batch_runtimes.data(), rq) <<
+               std::endl;
+
+  std::cout << "BB-Tree [deletes]" << std::endl;
+  measure(n, 1000000,
+    [&](size_t i) {
+      return delete_by_tid ? bbtree->DeleteByTid(i+1) :
+                             bbtree->DeleteObject(bbtree_points[i]);
+    },
+    [&](size_t i, bool deleted) {
+      assert(true == deleted);
+      assert((i+1) != bbtree->SearchObject(bbtree_points[i]));
+      assert(n - i - 1 == bbtree->getCount());
+    });
+  std::cout << std::endl;
+
+  // range updates and deletes on the reloaded data objects
+  for (size_t i = 0; i < n; ++i)
+    bbtree->InsertObject(bbtree_points[i], i+1);
+
+  std::cout << "BB-Tree [range updates]" << std::endl;
+  avg = measure(rq, 1000,
+    [&](size_t i) {
+      // mirror dimension 0, which moves data objects into other buckets
+      return bbtree->UpdateRange(lb_queries[i], ub_queries[i], [o](uint32_t tid, std::vector<float> &feature_vector) {
+        feature_vector[0] = o - feature_vector[0];
+      });
+    });
+
+  printf("Range Update Throughput: %f ops/s.\n", (float) (1000 / avg));
+
+  std::cout << "BB-Tree [range deletes]" << std::endl;
+  size_t num_deleted = 0;
+  avg = measure(rq, 1000,
+    [&](size_t i) { return bbtree->DeleteRange(lb_queries[i], ub_queries[i]); },
+    [&](size_t i, size_t num_range_deleted) { num_deleted += num_range_deleted; });
+
+  printf("Range Delete Throughput: %f ops/s [deleted: %zu].\n", (float) (1000 / avg), num_deleted);
 
   delete bbtree;
 